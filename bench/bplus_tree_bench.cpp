@@ -0,0 +1,118 @@
+// Concurrent insert/lookup benchmark for the B+tree. Every thread inserts a
+// run of keys of its own plus a run shared with all other threads, looking
+// up each entry once inserted; the final scan must then return every entry
+// exactly once in (key, tid) order. Exits non-zero on a missing or
+// misplaced entry.
+//
+// usage: bplus_tree_bench [keys_per_thread] [max_threads]
+#include "../src/index/bplus_tree.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+const size_t INSERT_RUN = 32; // Entries per insert_sorted call
+const size_t CACHE_PAGES = 1 << 20; // Never evicts: the cache has no file behind it
+
+std::string key_of(int64_t key) {
+    return encode_index_key({Value(static_cast<int>(key))}, KeyFormat::INT64);
+}
+
+// Disjoint keys go in ascending runs; the shared ones, a quarter of a thread's
+// keys, go in one at a time from the top so threads meet in the same leaves
+void run_thread(BPlusTree& tree, int thread, int64_t keys, std::atomic<size_t>& failures) {
+    int64_t shared = keys / 4;
+    int64_t first = shared + thread * keys;
+    std::vector<std::pair<std::string, Tid>> run;
+    for (int64_t key = first; key < first + keys; ++key) {
+        run.emplace_back(key_of(key), Tid{thread, static_cast<short>(key % 1000)});
+        if (run.size() == INSERT_RUN || key + 1 == first + keys) {
+            tree.insert_sorted(run);
+            for (const auto& [run_key, tid] : run) {
+                auto found = tree.search(run_key);
+                if (found.size() != 1 || found[0].page_id != tid.page_id) {
+                    ++failures;
+                }
+            }
+            run.clear();
+        }
+    }
+    for (int64_t key = shared - 1; key >= 0; --key) {
+        std::string encoded = key_of(key);
+        tree.insert(encoded, {thread, static_cast<short>(key % 1000)});
+        auto found = tree.search(encoded);
+        if (std::none_of(found.begin(), found.end(), [thread](const Tid& tid) { return tid.page_id == thread; })) {
+            ++failures;
+        }
+    }
+}
+
+// Shared keys come first, one entry per thread in thread order, then each
+// thread's own run
+size_t check_scan(BPlusTree& tree, int threads, int64_t keys) {
+    int64_t shared = keys / 4;
+    std::vector<std::string> found_keys;
+    std::vector<Tid> found = tree.search_range(key_of(0), std::nullopt, found_keys);
+    size_t expected = static_cast<size_t>(shared) * threads + static_cast<size_t>(keys) * threads;
+    if (found.size() != expected) {
+        std::cerr << "Scan returned " << found.size() << " entries, expected " << expected << std::endl;
+        return 1;
+    }
+    size_t errors = 0;
+    size_t i = 0;
+    for (int64_t key = 0; key < shared; ++key) {
+        for (int thread = 0; thread < threads; ++thread, ++i) {
+            errors += found_keys[i] != key_of(key) || found[i].page_id != thread;
+        }
+    }
+    for (int thread = 0; thread < threads; ++thread) {
+        for (int64_t key = shared + thread * keys; key < shared + (thread + 1) * keys; ++key, ++i) {
+            errors += found_keys[i] != key_of(key) || found[i].page_id != thread;
+        }
+    }
+    return errors;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int64_t keys = argc > 1 ? std::atoll(argv[1]) : 200000;
+    int max_threads = argc > 2 ? std::atoi(argv[2]) : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    std::string file = (std::filesystem::temp_directory_path() / "bplus_tree_bench.idx").string();
+
+    bool ok = true;
+    double base_rate = 0;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        std::filesystem::remove(file);
+        BufferCache cache(CACHE_PAGES);
+        // Splits log their page images as the engine's indexes do
+        std::atomic<size_t> logged{0};
+        BPlusTree tree(cache, file, KeyFormat::INT64, [&logged](const std::string&, const std::string&) { ++logged; });
+        std::atomic<size_t> failures{0};
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (int thread = 0; thread < threads; ++thread) {
+            workers.emplace_back(run_thread, std::ref(tree), thread, keys, std::ref(failures));
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t errors = failures + check_scan(tree, threads, keys);
+        // Each entry is inserted and looked up once
+        double rate = 2.0 * (keys + keys / 4) * threads / seconds;
+        if (threads == 1) base_rate = rate;
+        std::cout << threads << " threads: " << static_cast<long long>(rate) << " ops/s, "
+                  << "speedup " << rate / base_rate << ", " << errors << " errors" << std::endl;
+        ok = ok && errors == 0;
+    }
+    std::filesystem::remove(file);
+    return ok ? 0 : 1;
+}
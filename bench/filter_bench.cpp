@@ -0,0 +1,111 @@
+// Filter benchmark: the same rows and WHERE clauses run through the
+// row-at-a-time predicate and through the batch kernels, as FilterOperator
+// applies them. Both paths must select the same number of rows; exits
+// non-zero when they do not.
+//
+// usage: filter_bench [rows] [repeats]
+#include "../src/executor/vector_kernels.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+
+namespace {
+
+const std::vector<std::string> COLUMNS = {"a", "b", "s"};
+const std::vector<DataType> TYPES = {DataType::INT, DataType::INT, DataType::STRING};
+const int STRING_VALUES = 100;
+
+struct Query {
+    std::string label;
+    std::vector<WhereCondition> conditions;
+};
+
+// The FilterOperator's step for one term
+void apply(const Predicate::Term& term, RowBatch& batch) {
+    const ColumnVector& column = batch.columns[term.position];
+    if (term.constant.type != column.type) {
+        if (term.op != CompareOp::NE) batch.selection.clear();
+        return;
+    }
+    if (column.type == DataType::INT) {
+        select_int(column, term.op, term.constant.int_value, batch.selection, batch.size);
+    } else {
+        select_string(column, term.op, term.constant.str_value, batch.selection);
+    }
+}
+
+template <typename Fn>
+double time_seconds(int repeats, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i) {
+        fn();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t row_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    // a runs over 0..999, b over 0..9, s over STRING_VALUES strings
+    std::vector<std::vector<Value>> rows;
+    std::vector<RowBatch> batches;
+    rows.reserve(row_count);
+    for (size_t i = 0; i < row_count; ++i) {
+        int a = static_cast<int>((i * 7919) % 1000);
+        rows.push_back({Value(a), Value(static_cast<int>(i % 10)), Value("value" + std::to_string(i % STRING_VALUES))});
+        if (batches.empty() || batches.back().full()) {
+            batches.emplace_back();
+            batches.back().reset(TYPES);
+        }
+        batches.back().append(rows.back());
+    }
+    std::vector<uint32_t> all_rows(BATCH_SIZE);
+    std::iota(all_rows.begin(), all_rows.end(), 0);
+
+    std::vector<Query> queries = {
+        {"a < 500", {{"a", "<", Value(500)}}},
+        {"a = 42", {{"a", "=", Value(42)}}},
+        {"s = 'value7'", {{"s", "=", Value(std::string("value7"))}}},
+        {"a >= 100 AND b != 3", {{"a", ">=", Value(100)}, {"b", "!=", Value(3)}}},
+    };
+
+    bool ok = true;
+    for (const Query& query : queries) {
+        Predicate predicate(query.conditions, COLUMNS);
+
+        size_t row_matches = 0;
+        double row_seconds = time_seconds(repeats, [&] {
+            row_matches = 0;
+            for (const auto& row : rows) {
+                row_matches += predicate.matches(row);
+            }
+        });
+
+        size_t batch_matches = 0;
+        double batch_seconds = time_seconds(repeats, [&] {
+            batch_matches = 0;
+            for (RowBatch& batch : batches) {
+                batch.selection.assign(all_rows.begin(), all_rows.begin() + batch.size);
+                for (const auto& term : predicate.terms()) {
+                    if (batch.selection.empty()) break;
+                    apply(term, batch);
+                }
+                batch_matches += batch.selection.size();
+            }
+        });
+
+        double scanned = static_cast<double>(row_count) * repeats;
+        std::cout << query.label << ": row " << static_cast<long long>(scanned / row_seconds) << " rows/s, batch "
+                  << static_cast<long long>(scanned / batch_seconds) << " rows/s, speedup " << row_seconds / batch_seconds
+                  << ", " << batch_matches << " matches" << std::endl;
+        if (row_matches != batch_matches) {
+            std::cerr << query.label << ": row path selected " << row_matches << " rows, batch path " << batch_matches << std::endl;
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -2,6 +2,7 @@
 #include "../storage/storage_engine.h"
 #include <stdexcept>
 #include <iostream>
+#include <iterator>
 
 BufferCache::BufferCache(size_t capacity) : capacity(capacity) {}
 
@@ -14,8 +15,28 @@ void BufferCache::set_storage_engine(StorageEngine* storage_engine) {
 }
 
 Page* BufferCache::get_page(const std::string& file, int page_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fetch_page(file + "_" + std::to_string(page_id), file, page_id);
+}
+
+Page* BufferCache::pin_page(const std::string& file, int page_id) {
     std::lock_guard<std::mutex> lock(mutex);
     std::string key = file + "_" + std::to_string(page_id);
+    Page* page = fetch_page(key, file, page_id);
+    pin_counts[key]++;
+    return page;
+}
+
+void BufferCache::unpin_page(const std::string& file, int page_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = pin_counts.find(file + "_" + std::to_string(page_id));
+    if (it != pin_counts.end() && --it->second == 0) {
+        pin_counts.erase(it);
+    }
+}
+
+// Called with mutex held
+Page* BufferCache::fetch_page(const std::string& key, const std::string& file, int page_id) {
     auto it = cache_map.find(key);
     if (it != cache_map.end()) {
         hits_++;
@@ -78,18 +99,54 @@ void BufferCache::flush_all() {
     }
 }
 
+void BufferCache::flush_file(const std::string& file) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string prefix = file + "_";
+    for (auto& pair : lru_list) {
+        const std::string& key = pair.first;
+        Page* page = pair.second.get();
+        if (page->dirty && storage_engine_ && key.compare(0, prefix.size(), prefix) == 0 &&
+            key.find('_', prefix.size()) == std::string::npos) {
+            storage_engine_->write_page_to_file(file, *page, std::stoi(key.substr(prefix.size())));
+            page->dirty = false;
+        }
+    }
+}
+
+void BufferCache::drop_file(const std::string& file) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string prefix = file + "_";
+    for (auto it = lru_list.begin(); it != lru_list.end();) {
+        const std::string& key = it->first;
+        if (key.compare(0, prefix.size(), prefix) == 0 && key.find('_', prefix.size()) == std::string::npos) {
+            cache_map.erase(key);
+            it = lru_list.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 void BufferCache::print_stats() {
     std::cout << "Cache Stats: Hits=" << hits_ << ", Misses=" << misses_ << ", Evictions=" << evictions_ << std::endl;
 }
 
+// Evicts the least recently used unpinned page; with every page pinned the
+// cache grows past its capacity instead
 void BufferCache::evict() {
-    if (lru_list.empty()) {
+    auto victim = lru_list.end();
+    for (auto it = lru_list.rbegin(); it != lru_list.rend(); ++it) {
+        if (!pin_counts.count(it->first)) {
+            victim = std::prev(it.base());
+            break;
+        }
+    }
+    if (victim == lru_list.end()) {
         return;
     }
     evictions_++;
-    auto& last = lru_list.back();
-    std::string key = last.first;
-    Page* page = last.second.get();
+    std::string key = victim->first;
+    Page* page = victim->second.get();
 
     if (page->dirty && storage_engine_) {
         size_t separator_pos = key.find_last_of('_');
@@ -101,6 +158,33 @@ void BufferCache::evict() {
     }
 
     cache_map.erase(key);
-    lru_list.pop_back();
+    lru_list.erase(victim);
     // No need to delete - unique_ptr handles cleanup automatically
 }
+
+PinnedPage::PinnedPage(BufferCache& cache, const std::string& file, int page_id)
+    : cache(&cache), file(&file), page_id(page_id), page_ptr(cache.pin_page(file, page_id)) {}
+
+PinnedPage::PinnedPage(PinnedPage&& other) noexcept
+    : cache(other.cache), file(other.file), page_id(other.page_id), page_ptr(other.page_ptr) {
+    other.cache = nullptr;
+}
+
+PinnedPage& PinnedPage::operator=(PinnedPage&& other) noexcept {
+    if (this != &other) {
+        release();
+        cache = other.cache;
+        file = other.file;
+        page_id = other.page_id;
+        page_ptr = other.page_ptr;
+        other.cache = nullptr;
+    }
+    return *this;
+}
+
+void PinnedPage::release() {
+    if (cache) {
+        cache->unpin_page(*file, page_id);
+        cache = nullptr;
+    }
+}
@@ -17,8 +17,13 @@ public:
     ~BufferCache(); // Add destructor to clean up resources
     void set_storage_engine(StorageEngine* storage_engine);
     Page* get_page(const std::string& file, int page_id);
+    // Like get_page, but the page is not evicted until every pin is released
+    Page* pin_page(const std::string& file, int page_id);
+    void unpin_page(const std::string& file, int page_id);
     void put_page(const std::string& file, int page_id, Page* page);
     void flush_all();
+    void flush_file(const std::string& file); // Writes only the file's dirty pages
+    void drop_file(const std::string& file); // Forgets the file's pages without writing them
     void print_stats();
 
 private:
@@ -26,13 +31,34 @@ private:
     StorageEngine* storage_engine_ = nullptr;
     std::unordered_map<std::string, std::list<std::pair<std::string, std::unique_ptr<Page>>>::iterator> cache_map;
     std::list<std::pair<std::string, std::unique_ptr<Page>>> lru_list;
+    std::unordered_map<std::string, int> pin_counts; // Only pinned pages have an entry
     std::mutex mutex;
 
     size_t hits_ = 0;
     size_t misses_ = 0;
     size_t evictions_ = 0;
 
+    Page* fetch_page(const std::string& key, const std::string& file, int page_id);
     void evict();
 };
 
+// Holds a pin on a page for its lifetime. file must outlive the object.
+class PinnedPage {
+public:
+    PinnedPage() = default;
+    PinnedPage(BufferCache& cache, const std::string& file, int page_id);
+    PinnedPage(PinnedPage&& other) noexcept;
+    PinnedPage& operator=(PinnedPage&& other) noexcept;
+    ~PinnedPage() { release(); }
+    int id() const { return page_id; }
+    Page* page() const { return page_ptr; }
+
+private:
+    BufferCache* cache = nullptr;
+    const std::string* file = nullptr;
+    int page_id = -1;
+    Page* page_ptr = nullptr;
+    void release();
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "arena.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+void* Arena::allocate(size_t size, size_t align) {
+    uintptr_t start = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t(align) - 1);
+    if (!cursor || start + size > reinterpret_cast<uintptr_t>(limit)) {
+        // A request larger than the chunk size gets a chunk of its own
+        size_t chunk_size = std::max(next_chunk, size + align);
+        chunks.emplace_back(new char[chunk_size]); // Left uninitialised, unlike make_unique
+        next_chunk = std::min(next_chunk * 2, ARENA_MAX_CHUNK);
+        cursor = chunks.back().get();
+        limit = cursor + chunk_size;
+        start = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t(align) - 1);
+    }
+    cursor = reinterpret_cast<char*>(start + size);
+    allocated += size;
+    return reinterpret_cast<void*>(start);
+}
+
+std::string_view Arena::copy(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view();
+    }
+    char* bytes = static_cast<char*>(allocate(text.size(), 1));
+    std::memcpy(bytes, text.data(), text.size());
+    return std::string_view(bytes, text.size());
+}
+
+void Arena::reset() {
+    chunks.clear();
+    cursor = nullptr;
+    limit = nullptr;
+    next_chunk = ARENA_FIRST_CHUNK;
+    allocated = 0;
+}
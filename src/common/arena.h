@@ -0,0 +1,43 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+const size_t ARENA_FIRST_CHUNK = 64 * 1024; // Chunks double from here up to ARENA_MAX_CHUNK
+const size_t ARENA_MAX_CHUNK = 4 * 1024 * 1024;
+
+// Bump allocator for the rows and strings an operator holds: memory is cut
+// from large chunks and freed only all at once, by reset() or when the
+// arena goes away, so holding a million rows costs a few dozen mallocs
+// instead of millions. Nothing placed in it is destroyed; it suits
+// trivially destructible types such as ValueView.
+class Arena {
+public:
+    Arena() = default;
+    Arena(Arena&&) = default;
+    Arena& operator=(Arena&&) = default;
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+    template <typename T>
+    T* allocate_array(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+    std::string_view copy(std::string_view text);
+
+    // Bytes handed out since the last reset, for memory budgets; the chunks
+    // hold at most the unused tail of the current one more
+    size_t used() const { return allocated; }
+    void reset(); // Frees every chunk
+
+private:
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t next_chunk = ARENA_FIRST_CHUNK;
+    size_t allocated = 0;
+};
+
+#endif
@@ -19,15 +19,33 @@ struct PageHeader {
     uint16_t special_size; // Size of special space
 };
 
+// Header stored in front of every heap tuple; serialized column values follow
+struct TupleHeader {
+    uint16_t length;   // Total tuple length including this header
+    uint16_t infomask; // Hint bits caching the commit status of xmin/xmax
+    int xmin;
+    int xmax;
+    int cid;
+};
+
+const uint16_t HEAP_XMIN_COMMITTED = 0x0001;
+const uint16_t HEAP_XMIN_ABORTED = 0x0002;
+const uint16_t HEAP_XMAX_COMMITTED = 0x0004;
+const uint16_t HEAP_XMAX_ABORTED = 0x0008;
+
+// Item offsets and pd_lower/pd_upper are relative to Page::data
+const int PAGE_DATA_SIZE = PAGE_SIZE - sizeof(PageHeader) - sizeof(ItemPointer) * MAX_ITEM_POINTERS - sizeof(bool);
+
 struct Page {
     PageHeader header;
     ItemPointer item_pointers[MAX_ITEM_POINTERS]; // Fixed-size array instead of vector
     bool dirty;
-    char data[PAGE_SIZE - sizeof(PageHeader) - sizeof(ItemPointer) * MAX_ITEM_POINTERS - sizeof(bool)];
+    char data[PAGE_DATA_SIZE];
     
-    Page() : header{}, dirty(false) {
-        header.pd_lower = sizeof(PageHeader) + sizeof(ItemPointer) * MAX_ITEM_POINTERS;
-        header.pd_upper = PAGE_SIZE;
+    // Zeroed, as pages past the end of a file are not read into at all
+    Page() : header{}, item_pointers{}, dirty(false), data{} {
+        header.pd_lower = 0;
+        header.pd_upper = PAGE_DATA_SIZE;
         header.item_count = 0;
         header.special_size = 0;
     }
@@ -0,0 +1,156 @@
+#include "predicate.h"
+#include <algorithm>
+#include <stdexcept>
+
+CompareOp compare_op_from(const std::string& op) {
+    if (op == "=") return CompareOp::EQ;
+    if (op == "!=") return CompareOp::NE;
+    if (op == "<") return CompareOp::LT;
+    if (op == "<=") return CompareOp::LE;
+    if (op == ">") return CompareOp::GT;
+    if (op == ">=") return CompareOp::GE;
+    if (op == "LIKE") return CompareOp::LIKE;
+    throw std::runtime_error("Unsupported operator: " + op);
+}
+
+std::string flip_comparison(const std::string& op) {
+    if (op == "<") return ">";
+    if (op == "<=") return ">=";
+    if (op == ">") return "<";
+    if (op == ">=") return "<=";
+    return op;
+}
+
+namespace {
+
+// Instantiated for decoded values and for values viewed in a page
+template <CompareOp op>
+struct IntCompare {
+    template <typename V>
+    static bool compare(const V& value, const Value& constant) {
+        if (value.type != DataType::INT) return op == CompareOp::NE;
+        int a = value.int_value;
+        int b = constant.int_value;
+        if constexpr (op == CompareOp::EQ) return a == b;
+        if constexpr (op == CompareOp::NE) return a != b;
+        if constexpr (op == CompareOp::LT) return a < b;
+        if constexpr (op == CompareOp::LE) return a <= b;
+        if constexpr (op == CompareOp::GT) return a > b;
+        if constexpr (op == CompareOp::GE) return a >= b;
+        return false; // LIKE matches strings only
+    }
+};
+
+template <CompareOp op>
+struct StringCompare {
+    template <typename V>
+    static bool compare(const V& value, const Value& constant) {
+        if (value.type != DataType::STRING) return op == CompareOp::NE;
+        std::string_view a = value.str_value;
+        std::string_view b = constant.str_value;
+        if constexpr (op == CompareOp::EQ) return a == b;
+        if constexpr (op == CompareOp::NE) return a != b;
+        if constexpr (op == CompareOp::LT) return a < b;
+        if constexpr (op == CompareOp::LE) return a <= b;
+        if constexpr (op == CompareOp::GT) return a > b;
+        if constexpr (op == CompareOp::GE) return a >= b;
+        return a.find(b) != std::string_view::npos; // LIKE: contains
+    }
+};
+
+// A NULL constant is of no column's type
+template <CompareOp op>
+struct NullCompare {
+    template <typename V>
+    static bool compare(const V&, const Value&) { return op == CompareOp::NE; }
+};
+
+template <typename V>
+using CompareFn = bool (*)(const V&, const Value&);
+
+template <template <CompareOp> class Compare, typename V>
+CompareFn<V> bind(CompareOp op) {
+    switch (op) {
+        case CompareOp::EQ: return &Compare<CompareOp::EQ>::template compare<V>;
+        case CompareOp::NE: return &Compare<CompareOp::NE>::template compare<V>;
+        case CompareOp::LT: return &Compare<CompareOp::LT>::template compare<V>;
+        case CompareOp::LE: return &Compare<CompareOp::LE>::template compare<V>;
+        case CompareOp::GT: return &Compare<CompareOp::GT>::template compare<V>;
+        case CompareOp::GE: return &Compare<CompareOp::GE>::template compare<V>;
+        case CompareOp::LIKE: return &Compare<CompareOp::LIKE>::template compare<V>;
+    }
+    return nullptr;
+}
+
+template <typename V>
+CompareFn<V> bind_compare(CompareOp op, DataType type) {
+    switch (type) {
+        case DataType::INT: return bind<IntCompare, V>(op);
+        case DataType::STRING: return bind<StringCompare, V>(op);
+        default: return bind<NullCompare, V>(op);
+    }
+}
+
+// Default selectivities for want of column statistics
+double selectivity(CompareOp op) {
+    switch (op) {
+        case CompareOp::EQ: return 0.005;
+        case CompareOp::NE: return 0.995;
+        case CompareOp::LIKE: return 0.1;
+        default: return 1.0 / 3; // One side of a range
+    }
+}
+
+// Relative cost of one evaluation
+double cost(CompareOp op, DataType type) {
+    if (op == CompareOp::LIKE) return 4;
+    return type == DataType::STRING ? 2 : 1;
+}
+
+} // namespace
+
+bool compare_values(const ValueView& value, CompareOp op, const ValueView& other) {
+    if (other.type == DataType::NULL_TYPE || value.type != other.type) return op == CompareOp::NE;
+    if (op == CompareOp::LIKE) {
+        return value.type == DataType::STRING && value.str_value.find(other.str_value) != std::string_view::npos;
+    }
+    int cmp = value.type == DataType::INT ? (value.int_value > other.int_value) - (value.int_value < other.int_value)
+                                          : value.str_value.compare(other.str_value);
+    switch (op) {
+        case CompareOp::EQ: return cmp == 0;
+        case CompareOp::NE: return cmp != 0;
+        case CompareOp::LT: return cmp < 0;
+        case CompareOp::LE: return cmp <= 0;
+        case CompareOp::GT: return cmp > 0;
+        case CompareOp::GE: return cmp >= 0;
+        default: return false;
+    }
+}
+
+Predicate::Predicate(const std::vector<WhereCondition>& conditions, const std::vector<std::string>& columns) {
+    std::vector<std::pair<double, Term>> ranked;
+    for (const auto& condition : conditions) {
+        auto col = std::find(columns.begin(), columns.end(), condition.column);
+        if (col == columns.end()) {
+            throw std::runtime_error("Column '" + condition.column + "' not found in result set");
+        }
+        CompareOp op = compare_op_from(condition.op);
+        Term term{static_cast<size_t>(col - columns.begin()), op, condition.value,
+                  bind_compare<Value>(op, condition.value.type), bind_compare<ValueView>(op, condition.value.type)};
+        // Running conjuncts in ascending cost / (1 - selectivity) minimises the expected work per row
+        double rank = cost(op, condition.value.type) / std::max(1 - selectivity(op), 1e-6);
+        ranked.emplace_back(rank, std::move(term));
+    }
+    std::stable_sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (auto& [rank, term] : ranked) {
+        terms_.push_back(std::move(term));
+    }
+}
+
+size_t Predicate::column_span() const {
+    size_t span = 0;
+    for (const Term& term : terms_) {
+        span = std::max(span, term.position + 1);
+    }
+    return span;
+}
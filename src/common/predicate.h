@@ -0,0 +1,74 @@
+#ifndef PREDICATE_H
+#define PREDICATE_H
+
+#include <string>
+#include <vector>
+#include "value.h"
+#include "../parser/sql_parser.h"
+
+enum class CompareOp {
+    EQ,
+    NE,
+    LT,
+    LE,
+    GT,
+    GE,
+    LIKE // Substring match, STRING only
+};
+
+// Throws for operators the filters do not know
+CompareOp compare_op_from(const std::string& op);
+// a op b as b op' a
+std::string flip_comparison(const std::string& op);
+
+// value op other, by the rules of a Term whose constant is other
+bool compare_values(const ValueView& value, CompareOp op, const ValueView& other);
+
+// A conjunction of WHERE conditions compiled once per statement against a
+// row layout. Column names are resolved to ordinals, each condition is bound
+// to a comparison specialised for its operator and the constant's type, and
+// the conditions are ordered so that cheap, selective ones reject a row
+// before the others run. A value of another type than the constant, NULL
+// included, only satisfies NE.
+class Predicate {
+public:
+    struct Term {
+        size_t position;
+        CompareOp op;
+        Value constant;
+        bool (*compare)(const Value& value, const Value& constant);
+        bool (*compare_view)(const ValueView& value, const Value& constant);
+    };
+
+    Predicate() = default; // Matches every row
+    // Throws when a condition names a column not in columns
+    Predicate(const std::vector<WhereCondition>& conditions, const std::vector<std::string>& columns);
+
+    bool matches(const std::vector<Value>& row) const {
+        for (const Term& term : terms_) {
+            // Short records read as not matching
+            if (term.position >= row.size() || !term.compare(row[term.position], term.constant)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    // The same test on values viewed in a page, before anything is decoded
+    bool matches(const std::vector<ValueView>& row) const {
+        for (const Term& term : terms_) {
+            if (term.position >= row.size() || !term.compare_view(row[term.position], term.constant)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool empty() const { return terms_.empty(); }
+    // One past the highest column a term reads
+    size_t column_span() const;
+    const std::vector<Term>& terms() const { return terms_; }
+
+private:
+    std::vector<Term> terms_; // In evaluation order
+};
+
+#endif
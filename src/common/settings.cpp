@@ -0,0 +1,58 @@
+#include "settings.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cctype>
+
+const size_t MIN_WORK_MEM = 64 * 1024;
+
+// A size in kB, as an INT or a STRING with an optional kB, MB or GB suffix
+static size_t parse_memory(const std::string& name, const Value& value) {
+    long long amount = -1;
+    size_t unit = 1024;
+    if (value.type == DataType::INT) {
+        amount = value.int_value;
+    } else if (value.type == DataType::STRING) {
+        size_t digits = 0;
+        while (digits < value.str_value.size() && std::isdigit(static_cast<unsigned char>(value.str_value[digits]))) {
+            ++digits;
+        }
+        std::string suffix = value.str_value.substr(digits);
+        std::transform(suffix.begin(), suffix.end(), suffix.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (digits > 0 && digits <= 9 && (suffix.empty() || suffix == "kb" || suffix == "mb" || suffix == "gb")) {
+            amount = std::stoll(value.str_value.substr(0, digits));
+            unit = suffix == "mb" ? 1024 * 1024 : suffix == "gb" ? 1024 * 1024 * 1024 : 1024;
+        }
+    }
+    if (amount < 0 || static_cast<size_t>(amount) * unit < MIN_WORK_MEM) {
+        throw std::runtime_error(name + " must be a size of at least 64kB, such as 4096 (kB) or '64MB'.");
+    }
+    return static_cast<size_t>(amount) * unit;
+}
+
+void Settings::set(const std::string& name, const Value& value) {
+    std::string key = name;
+    std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (key == "max_parallel_workers") {
+        if (value.type != DataType::INT || value.int_value < 0) {
+            throw std::runtime_error("max_parallel_workers must be a non-negative integer.");
+        }
+        max_parallel_workers = value.int_value;
+    } else if (key == "lock_timeout") {
+        if (value.type != DataType::INT || value.int_value < 0) {
+            throw std::runtime_error("lock_timeout must be a non-negative integer (milliseconds).");
+        }
+        lock_timeout = value.int_value;
+    } else if (key == "work_mem") {
+        work_mem = parse_memory(name, value);
+    } else if (key == "output_format") {
+        std::string format = value.str_value;
+        std::transform(format.begin(), format.end(), format.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (value.type != DataType::STRING || (format != "tsv" && format != "csv" && format != "aligned" && format != "binary")) {
+            throw std::runtime_error("output_format must be one of tsv, csv, aligned or binary.");
+        }
+        output_format = format == "csv" ? OutputFormat::CSV : format == "aligned" ? OutputFormat::ALIGNED :
+                        format == "binary" ? OutputFormat::BINARY : OutputFormat::TSV;
+    } else {
+        throw std::runtime_error("Unknown setting: " + name);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <cstddef>
+#include <string>
+#include "value.h"
+#include "../transaction/lock_manager.h"
+
+// How query results are written out
+enum class OutputFormat {
+    TSV, // Each value followed by a tab, a line per row
+    CSV, // RFC 4180, NULL as an empty field
+    ALIGNED, // Padded columns under a header rule, with a row count
+    BINARY // Length-prefixed fields, for programs reading the output
+};
+
+// Session parameters, changed with SET name = value; names are case-insensitive
+struct Settings {
+    int max_parallel_workers = 4; // Threads a scan may start besides the session thread; 0 disables parallel scans
+    OutputFormat output_format = OutputFormat::TSV; // tsv, csv, aligned or binary
+    // Bytes each sort, hash table or materialized input of a query may hold
+    // before it spills to temporary files. Set in kB, or with a kB, MB or GB
+    // suffix: SET work_mem = '64MB'.
+    size_t work_mem = 16 * 1024 * 1024;
+    int lock_timeout = DEFAULT_LOCK_TIMEOUT_MS; // Milliseconds a lock wait may take before the statement fails; 0 fails at once
+
+    // Throws for unknown names and out-of-range values
+    void set(const std::string& name, const Value& value);
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define VALUE_H
 
 #include <string>
+#include <string_view>
 #include <stdexcept>
 
 enum class DataType {
@@ -22,6 +23,18 @@ struct Value {
     bool is_null() const { return type == DataType::NULL_TYPE; }
 };
 
+// A value still in its serialized form, STRING bytes viewed in place
+struct ValueView {
+    DataType type = DataType::NULL_TYPE;
+    int int_value = 0;
+    std::string_view str_value;
+};
+
+// Valid while value is unchanged
+inline ValueView view_of(const Value& value) {
+    return {value.type, value.int_value, value.str_value};
+}
+
 std::string to_string(const Value& val);
 
 #endif
\ No newline at end of file
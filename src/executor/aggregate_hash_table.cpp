@@ -0,0 +1,288 @@
+#include "aggregate_hash_table.h"
+#include "key_hash.h"
+#include "spill_file.h"
+#include <climits>
+#include <cstdio>
+#include <stdexcept>
+
+const size_t INITIAL_SLOTS = 64;
+
+AggregateFunction aggregate_function_from(const std::string& name) {
+    if (name == "COUNT") return AggregateFunction::COUNT;
+    if (name == "SUM") return AggregateFunction::SUM;
+    if (name == "MIN") return AggregateFunction::MIN;
+    if (name == "MAX") return AggregateFunction::MAX;
+    if (name == "AVG") return AggregateFunction::AVG;
+    throw std::runtime_error("Unknown aggregate function: " + name);
+}
+
+static bool less_value(const Value& a, const Value& b) {
+    return a.type == DataType::INT ? a.int_value < b.int_value : a.str_value < b.str_value;
+}
+
+AggregateHashTable::AggregateHashTable(const std::vector<AggregateFunction>& functions, size_t key_width, size_t memory_budget, int level)
+    : functions(functions), key_width(key_width), memory_budget(memory_budget), spill_level(level),
+      slots(INITIAL_SLOTS, Slot{0, EMPTY_SLOT}) {}
+
+AggregateHashTable::~AggregateHashTable() {
+    spill_out.clear();
+    for (const auto& file : spill_files) {
+        if (!file.empty()) std::remove(file.c_str());
+    }
+}
+
+void AggregateHashTable::add_batch(const RowBatch& batch, const std::vector<size_t>& key_positions, const std::vector<size_t>& input_positions) {
+    std::vector<const ColumnVector*> inputs(functions.size(), nullptr);
+    for (size_t i = 0; i < functions.size(); ++i) {
+        if (input_positions[i] != NO_AGGREGATE_INPUT) inputs[i] = &batch.columns[input_positions[i]];
+    }
+    std::vector<Value> key;
+    std::vector<AggregateState> partial;
+    for (uint32_t row : batch.selection) {
+        uint64_t hash = KEY_HASH_SEED;
+        for (size_t position : key_positions) {
+            hash = combine_hash(hash, hash_value(batch.columns[position], row));
+        }
+        size_t slot = probe(hash, [&](uint32_t group) {
+            const Value* group_key = &keys[group * key_width];
+            for (size_t i = 0; i < key_width; ++i) {
+                if (!equal_values(batch.columns[key_positions[i]], row, group_key[i])) return false;
+            }
+            return true;
+        });
+        uint32_t group = slots[slot].group;
+        if (group == EMPTY_SLOT) {
+            key.clear();
+            for (size_t position : key_positions) {
+                key.push_back(batch.columns[position].value_at(row));
+            }
+            if (at_budget()) {
+                partial.assign(functions.size(), AggregateState());
+                for (size_t i = 0; i < functions.size(); ++i) {
+                    accumulate(partial[i], functions[i], inputs[i], row);
+                }
+                spill(hash, key, partial.data());
+                continue;
+            }
+            group = add_group(slot, hash, key);
+        }
+        AggregateState* group_states = &states[group * functions.size()];
+        for (size_t i = 0; i < functions.size(); ++i) {
+            accumulate(group_states[i], functions[i], inputs[i], row);
+        }
+    }
+}
+
+void AggregateHashTable::merge(const std::vector<Value>& key, const AggregateState* partial) {
+    uint64_t hash = KEY_HASH_SEED;
+    for (const auto& value : key) {
+        hash = combine_hash(hash, hash_value(value));
+    }
+    size_t slot = probe(hash, [&](uint32_t group) {
+        const Value* group_key = &keys[group * key_width];
+        for (size_t i = 0; i < key_width; ++i) {
+            if (!equal_values(key[i], group_key[i])) return false;
+        }
+        return true;
+    });
+    uint32_t group = slots[slot].group;
+    if (group == EMPTY_SLOT) {
+        if (at_budget()) {
+            spill(hash, key, partial);
+            return;
+        }
+        std::vector<Value> copy = key;
+        group = add_group(slot, hash, copy);
+    }
+    AggregateState* group_states = &states[group * functions.size()];
+    for (size_t i = 0; i < functions.size(); ++i) {
+        combine(group_states[i], functions[i], partial[i]);
+    }
+}
+
+void AggregateHashTable::merge(AggregateHashTable& other) {
+    std::vector<Value> key;
+    for (size_t group = 0; group < other.group_count(); ++group) {
+        key.assign(other.keys.begin() + group * key_width, other.keys.begin() + (group + 1) * key_width);
+        merge(key, &other.states[group * functions.size()]);
+    }
+    for (const auto& file : other.take_spill_files()) {
+        merge_file(file);
+        std::remove(file.c_str());
+    }
+}
+
+void AggregateHashTable::merge_file(const std::string& file) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Could not open aggregate spill file: " + file);
+    }
+    std::vector<Value> key(key_width);
+    std::vector<AggregateState> partial(functions.size());
+    while (true) {
+        bool complete = true;
+        for (size_t i = 0; i < key_width && complete; ++i) {
+            complete = read_value(in, key[i]);
+        }
+        for (size_t i = 0; i < functions.size() && complete; ++i) {
+            in.read(reinterpret_cast<char*>(&partial[i].count), sizeof(partial[i].count));
+            in.read(reinterpret_cast<char*>(&partial[i].sum), sizeof(partial[i].sum));
+            complete = read_value(in, partial[i].extreme);
+        }
+        if (!complete) break;
+        merge(key, partial.data());
+    }
+}
+
+void AggregateHashTable::result_row(size_t group, std::vector<Value>& row) const {
+    row.assign(keys.begin() + group * key_width, keys.begin() + (group + 1) * key_width);
+    const AggregateState* group_states = &states[group * functions.size()];
+    for (size_t i = 0; i < functions.size(); ++i) {
+        const AggregateState& state = group_states[i];
+        switch (functions[i]) {
+            case AggregateFunction::COUNT:
+                if (state.count > INT_MAX) throw std::runtime_error("COUNT out of range for INT.");
+                row.push_back(Value(static_cast<int>(state.count)));
+                break;
+            case AggregateFunction::SUM:
+                if (state.sum > INT_MAX || state.sum < INT_MIN) throw std::runtime_error("SUM out of range for INT.");
+                row.push_back(state.count == 0 ? Value() : Value(static_cast<int>(state.sum)));
+                break;
+            case AggregateFunction::AVG:
+                row.push_back(state.count == 0 ? Value() : Value(static_cast<int>(state.sum / state.count)));
+                break;
+            case AggregateFunction::MIN:
+            case AggregateFunction::MAX:
+                row.push_back(state.extreme);
+                break;
+        }
+    }
+}
+
+std::vector<std::string> AggregateHashTable::take_spill_files() {
+    std::vector<std::string> files;
+    for (size_t i = 0; i < spill_out.size(); ++i) {
+        if (!spill_out[i]) continue;
+        spill_out[i]->close();
+        if (spill_out[i]->fail()) {
+            throw std::runtime_error("Could not write aggregate spill file: " + spill_files[i]);
+        }
+        files.push_back(spill_files[i]);
+    }
+    spill_out.clear();
+    spill_files.clear();
+    return files;
+}
+
+template <typename EqualKey>
+size_t AggregateHashTable::probe(uint64_t hash, const EqualKey& equal_key) const {
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const Slot& slot = slots[i];
+        if (slot.group == EMPTY_SLOT || (slot.hash == hash && equal_key(slot.group))) {
+            return i;
+        }
+    }
+}
+
+// A table always takes its first group, so a single huge group cannot spill
+// forever, and stops spilling once its level has used up the hash bits
+bool AggregateHashTable::at_budget() const {
+    return memory_used >= memory_budget && !hashes.empty() && AGGREGATE_SPILL_BITS * (spill_level + 1) <= 64;
+}
+
+uint32_t AggregateHashTable::add_group(size_t slot, uint64_t hash, std::vector<Value>& key) {
+    uint32_t group = static_cast<uint32_t>(hashes.size());
+    hashes.push_back(hash);
+    memory_used += sizeof(uint64_t) + 2 * sizeof(Slot) + key_width * sizeof(Value) + functions.size() * sizeof(AggregateState);
+    for (auto& value : key) {
+        memory_used += value.str_value.size();
+        keys.push_back(std::move(value));
+    }
+    states.resize(states.size() + functions.size());
+    slots[slot] = {hash, group};
+    if (hashes.size() * 2 > slots.size()) {
+        grow();
+    }
+    return group;
+}
+
+void AggregateHashTable::grow() {
+    slots.assign(slots.size() * 2, Slot{0, EMPTY_SLOT});
+    size_t mask = slots.size() - 1;
+    for (uint32_t group = 0; group < hashes.size(); ++group) {
+        size_t i = hashes[group] & mask;
+        while (slots[i].group != EMPTY_SLOT) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = {hashes[group], group};
+    }
+}
+
+// Partitions are taken from the top hash bits, below those of the levels
+// above, while slots are found by the bottom bits
+void AggregateHashTable::spill(uint64_t hash, const std::vector<Value>& key, const AggregateState* partial) {
+    size_t partitions = size_t(1) << AGGREGATE_SPILL_BITS;
+    size_t partition = (hash >> (64 - AGGREGATE_SPILL_BITS * (spill_level + 1))) & (partitions - 1);
+    if (spill_out.empty()) {
+        spill_out.resize(partitions);
+        spill_files.resize(partitions);
+    }
+    if (!spill_out[partition]) {
+        spill_files[partition] = new_spill_file("aggregate");
+        spill_out[partition] = std::make_unique<std::ofstream>(spill_files[partition], std::ios::binary | std::ios::trunc);
+        if (!*spill_out[partition]) {
+            throw std::runtime_error("Could not create aggregate spill file: " + spill_files[partition]);
+        }
+    }
+    std::ofstream& out = *spill_out[partition];
+    for (const auto& value : key) {
+        write_value(out, value);
+    }
+    for (size_t i = 0; i < functions.size(); ++i) {
+        out.write(reinterpret_cast<const char*>(&partial[i].count), sizeof(partial[i].count));
+        out.write(reinterpret_cast<const char*>(&partial[i].sum), sizeof(partial[i].sum));
+        write_value(out, partial[i].extreme);
+    }
+}
+
+void AggregateHashTable::accumulate(AggregateState& state, AggregateFunction function, const ColumnVector* input, uint32_t row) const {
+    if (!input) { // COUNT(*)
+        ++state.count;
+        return;
+    }
+    if (input->nulls[row]) {
+        return;
+    }
+    ++state.count;
+    if (function == AggregateFunction::SUM || function == AggregateFunction::AVG) {
+        state.sum += input->ints[row];
+    } else if (function == AggregateFunction::MIN || function == AggregateFunction::MAX) {
+        bool want_less = function == AggregateFunction::MIN;
+        if (input->type == DataType::INT) {
+            int value = input->ints[row];
+            if (state.extreme.is_null() || (want_less ? value < state.extreme.int_value : value > state.extreme.int_value)) {
+                state.extreme = Value(value);
+            }
+        } else {
+            std::string_view value = input->string_at(row);
+            std::string_view current = state.extreme.str_value;
+            if (state.extreme.is_null() || (want_less ? value < current : value > current)) {
+                state.extreme.type = DataType::STRING;
+                state.extreme.str_value.assign(value);
+            }
+        }
+    }
+}
+
+void AggregateHashTable::combine(AggregateState& state, AggregateFunction function, const AggregateState& partial) const {
+    state.count += partial.count;
+    state.sum += partial.sum;
+    if (partial.extreme.is_null()) {
+        return;
+    }
+    bool want_less = function == AggregateFunction::MIN;
+    if (state.extreme.is_null() || (want_less ? less_value(partial.extreme, state.extreme) : less_value(state.extreme, partial.extreme))) {
+        state.extreme = partial.extreme;
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef AGGREGATE_HASH_TABLE_H
+#define AGGREGATE_HASH_TABLE_H
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "row_batch.h"
+
+const int AGGREGATE_SPILL_BITS = 3; // A spilling table splits its overflow into 2^bits partition files
+const size_t NO_AGGREGATE_INPUT = SIZE_MAX; // Input position of COUNT(*)
+
+enum class AggregateFunction {
+    COUNT,
+    SUM,
+    MIN,
+    MAX,
+    AVG
+};
+
+AggregateFunction aggregate_function_from(const std::string& name);
+
+// Running result of one aggregate for one group. Partial states of the same
+// group, built on different threads or before and after a spill, merge
+// into the state of all their inputs.
+struct AggregateState {
+    int64_t count = 0; // Non-NULL inputs, or rows for COUNT(*)
+    int64_t sum = 0; // SUM and AVG
+    Value extreme; // MIN and MAX; NULL until the first input
+};
+
+// Groups of an aggregation, in an open-addressing table of (hash, group)
+// slots probed linearly; the keys and states of the groups sit in flat
+// arrays indexed by group. Once the groups use up memory_budget, input for
+// groups not yet in the table goes as partial states to one of the
+// 2^AGGREGATE_SPILL_BITS spill files picked by the hash bits of the
+// table's level, so every group is either complete in memory or wholly
+// in one spill file, and a spill file can be aggregated by a table of the
+// next level with the memory to itself.
+class AggregateHashTable {
+public:
+    AggregateHashTable(const std::vector<AggregateFunction>& functions, size_t key_width, size_t memory_budget, int level);
+    ~AggregateHashTable(); // Removes spill files not taken
+    AggregateHashTable(const AggregateHashTable&) = delete;
+    AggregateHashTable& operator=(const AggregateHashTable&) = delete;
+
+    // Accumulates the selected rows of batch, grouped by the columns at
+    // key_positions; input_positions holds the column of each aggregate,
+    // NO_AGGREGATE_INPUT for COUNT(*)
+    void add_batch(const RowBatch& batch, const std::vector<size_t>& key_positions, const std::vector<size_t>& input_positions);
+    // Folds in the partial states of one group
+    void merge(const std::vector<Value>& key, const AggregateState* states);
+    // Folds in every group of other, including those it spilled
+    void merge(AggregateHashTable& other);
+    // Folds in the partial states of a spill file
+    void merge_file(const std::string& file);
+
+    size_t group_count() const { return hashes.size(); }
+    // Key values of a group, then its finished aggregates
+    void result_row(size_t group, std::vector<Value>& row) const;
+    int level() const { return spill_level; }
+    // Closes the spill files and hands them, and their removal, to the caller
+    std::vector<std::string> take_spill_files();
+
+private:
+    struct Slot {
+        uint64_t hash;
+        uint32_t group; // EMPTY_SLOT when free
+    };
+    static const uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    std::vector<AggregateFunction> functions;
+    size_t key_width;
+    size_t memory_budget;
+    int spill_level;
+    size_t memory_used = 0;
+    std::vector<Slot> slots; // Power-of-two size, at most half full
+    std::vector<uint64_t> hashes; // Of each group
+    std::vector<Value> keys; // key_width values per group
+    std::vector<AggregateState> states; // One per function per group
+    std::vector<std::string> spill_files; // Per partition, empty until used
+    std::vector<std::unique_ptr<std::ofstream>> spill_out;
+
+    // Slot holding hash and a key equal_key accepts, or the free slot where
+    // it belongs
+    template <typename EqualKey>
+    size_t probe(uint64_t hash, const EqualKey& equal_key) const;
+    bool at_budget() const;
+    uint32_t add_group(size_t slot, uint64_t hash, std::vector<Value>& key);
+    void grow();
+    void spill(uint64_t hash, const std::vector<Value>& key, const AggregateState* partial);
+    void accumulate(AggregateState& state, AggregateFunction function, const ColumnVector* input, uint32_t row) const;
+    void combine(AggregateState& state, AggregateFunction function, const AggregateState& partial) const;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#include "filter_operator.h"
+
+FilterOperator::FilterOperator(std::unique_ptr<Operator> child, const std::vector<WhereCondition>& conditions)
+    : child(std::move(child)), predicate(conditions, this->child->columns()) {
+    output_columns = this->child->columns();
+    output_types = this->child->types();
+}
+
+void FilterOperator::open() {
+    child->open();
+}
+
+bool FilterOperator::next(RowBatch& batch) {
+    while (child->next(batch)) {
+        for (const auto& term : predicate.terms()) {
+            if (batch.selection.empty()) break; // AND logic: nothing left to reject
+            apply(term, batch);
+        }
+        if (!batch.selection.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FilterOperator::close() {
+    child->close();
+}
+
+void FilterOperator::apply(const Predicate::Term& term, RowBatch& batch) {
+    const ColumnVector& column = batch.columns[term.position];
+    if (term.constant.type != column.type) {
+        // Values of another type are never equal and never ordered
+        if (term.op != CompareOp::NE) batch.selection.clear();
+        return;
+    }
+    if (column.type == DataType::INT) {
+        select_int(column, term.op, term.constant.int_value, batch.selection, batch.size);
+    } else {
+        select_string(column, term.op, term.constant.str_value, batch.selection);
+    }
+}
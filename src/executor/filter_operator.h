@@ -0,0 +1,25 @@
+#ifndef FILTER_OPERATOR_H
+#define FILTER_OPERATOR_H
+
+#include <memory>
+#include "operator.h"
+#include "vector_kernels.h"
+
+// Rows of its child that meet every condition. Each condition, in the
+// predicate's order, narrows the batch's selection through a kernel for its
+// column type, so only rows still selected are looked at by the next one.
+class FilterOperator : public Operator {
+public:
+    FilterOperator(std::unique_ptr<Operator> child, const std::vector<WhereCondition>& conditions);
+    void open() override;
+    bool next(RowBatch& batch) override;
+    void close() override;
+
+private:
+    std::unique_ptr<Operator> child;
+    Predicate predicate;
+
+    static void apply(const Predicate::Term& term, RowBatch& batch);
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include "gather_operator.h"
+#include "../transaction/transaction_manager.h"
+#include <algorithm>
+#include <stdexcept>
+
+int parallel_scan_workers(int page_count, int max_parallel_workers) {
+    int hardware = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    return std::min({page_count / PAGES_PER_SCAN_WORKER, max_parallel_workers, hardware});
+}
+
+GatherOperator::GatherOperator(const ExecContext& ctx, const std::string& table_name, const std::vector<WhereCondition>& conditions,
+                               const std::vector<std::string>& columns, int worker_count)
+    : ctx(ctx), table_name(table_name),
+      filter(make_scan_filter(ctx.storage, table_name, conditions, columns, output_columns, output_types)),
+      worker_count(worker_count) {}
+
+GatherOperator::~GatherOperator() {
+    close();
+}
+
+void GatherOperator::open() {
+    if (ctx.tx_id != 0 && !ctx.tx_manager.lock_table(ctx.tx_id, table_name, LockMode::INTENTION_SHARED)) {
+        throw std::runtime_error("Failed to acquire intention shared lock for SELECT.");
+    }
+    page_count = ctx.storage.page_count(table_name);
+    next_page = 0;
+    stopping = false;
+    error = nullptr;
+    running = worker_count;
+    for (int i = 0; i < worker_count; ++i) {
+        workers.emplace_back(&GatherOperator::run_worker, this, i);
+    }
+}
+
+bool GatherOperator::next(RowBatch& batch) {
+    std::unique_lock<std::mutex> lock(mutex);
+    batch_ready.wait(lock, [this] { return !queue.empty() || running == 0 || error; });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if (queue.empty()) {
+        return false;
+    }
+    std::swap(batch, queue.front());
+    queue.pop_front();
+    queue_space.notify_one();
+    return true;
+}
+
+void GatherOperator::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queue_space.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    queue.clear();
+}
+
+void GatherOperator::run_parallel(const std::function<void(int worker, RowBatch& batch)>& consume) {
+    consumer = &consume;
+    open();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    consumer = nullptr;
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void GatherOperator::run_worker(int worker) {
+    try {
+        RowBatch batch;
+        batch.reset(output_types);
+        bool more = true;
+        while (more) {
+            int first = next_page.fetch_add(PARALLEL_SCAN_CHUNK);
+            if (first >= page_count) break;
+            int last = std::min(first + PARALLEL_SCAN_CHUNK, page_count);
+            ScanPosition position{first, 0};
+            while (more && position.page_id < last &&
+                   ctx.storage.scan_page(table_name, ctx.tx_id, ctx.cid, ctx.snapshot, ctx.tx_manager, filter, position, batch)) {
+                if (batch.full()) {
+                    more = deliver(worker, batch);
+                    batch.reset(output_types);
+                }
+            }
+        }
+        if (more && batch.size > 0) {
+            deliver(worker, batch);
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error) error = std::current_exception();
+        stopping = true;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    --running;
+    batch_ready.notify_all();
+}
+
+// Hands a batch on; false once the scan is being stopped
+bool GatherOperator::deliver(int worker, RowBatch& batch) {
+    if (consumer) {
+        (*consumer)(worker, batch);
+        return !stopping;
+    }
+    return push(batch);
+}
+
+// Queues a full batch, waiting while the consumer is behind; false once the
+// scan is being stopped
+bool GatherOperator::push(RowBatch& batch) {
+    std::unique_lock<std::mutex> lock(mutex);
+    queue_space.wait(lock, [this] { return stopping || queue.size() < static_cast<size_t>(2 * worker_count); });
+    if (stopping) {
+        return false;
+    }
+    queue.push_back(std::move(batch));
+    batch_ready.notify_one();
+    return true;
+}
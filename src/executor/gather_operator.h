@@ -0,0 +1,60 @@
+#ifndef GATHER_OPERATOR_H
+#define GATHER_OPERATOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include "operator.h"
+#include "seq_scan_operator.h"
+
+const int PARALLEL_SCAN_CHUNK = 8; // Pages a worker claims at a time
+const int PAGES_PER_SCAN_WORKER = 64; // Smallest share of the table worth a thread
+
+// Worker threads a parallel scan of page_count pages would use; below 2 the
+// scan stays on the session thread
+int parallel_scan_workers(int page_count, int max_parallel_workers);
+
+// A sequential scan run by worker threads, gathered onto the session
+// thread. Each worker claims PARALLEL_SCAN_CHUNK pages at a time from a
+// shared cursor, scans them with the pushed-down filter and visibility
+// checks, and queues the batches it fills; next() hands them on as they
+// arrive, so rows come out in no particular order.
+class GatherOperator : public Operator {
+public:
+    GatherOperator(const ExecContext& ctx, const std::string& table_name, const std::vector<WhereCondition>& conditions,
+                   const std::vector<std::string>& columns, int worker_count);
+    ~GatherOperator() override;
+    void open() override;
+    bool next(RowBatch& batch) override;
+    void close() override; // Also stops workers a consumer left early
+    int parallel_workers() const override { return worker_count; }
+    // The workers hand their batches to consume directly, bypassing the queue
+    void run_parallel(const std::function<void(int worker, RowBatch& batch)>& consume) override;
+
+private:
+    const ExecContext& ctx;
+    std::string table_name;
+    ScanFilter filter;
+    int worker_count;
+    int page_count = 0;
+    std::atomic<int> next_page{0};
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable batch_ready;
+    std::condition_variable queue_space;
+    std::deque<RowBatch> queue; // Bounded to two batches per worker
+    int running = 0; // Workers not yet finished
+    std::atomic<bool> stopping{false};
+    std::exception_ptr error; // First failure of any worker
+    const std::function<void(int, RowBatch&)>* consumer = nullptr; // Set by run_parallel
+
+    void run_worker(int worker);
+    bool deliver(int worker, RowBatch& batch);
+    bool push(RowBatch& batch);
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "hash_aggregate_operator.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+HashAggregateOperator::HashAggregateOperator(std::unique_ptr<Operator> child, const std::vector<std::string>& group_by,
+                                             const std::vector<AggregateCall>& aggregates, size_t memory_budget)
+    : child(std::move(child)), memory_budget(memory_budget) {
+    const auto& child_columns = this->child->columns();
+    auto position_of = [&](const std::string& column) {
+        auto col = std::find(child_columns.begin(), child_columns.end(), column);
+        if (col == child_columns.end()) {
+            throw std::runtime_error("Column '" + column + "' not found.");
+        }
+        return static_cast<size_t>(col - child_columns.begin());
+    };
+    for (const auto& column : group_by) {
+        key_positions.push_back(position_of(column));
+        output_columns.push_back(column);
+        output_types.push_back(this->child->types()[key_positions.back()]);
+    }
+    for (const auto& call : aggregates) {
+        AggregateFunction function = aggregate_function_from(call.function);
+        functions.push_back(function);
+        input_positions.push_back(call.column == "*" ? NO_AGGREGATE_INPUT : position_of(call.column));
+        output_columns.push_back(call.name());
+        bool keeps_type = function == AggregateFunction::MIN || function == AggregateFunction::MAX;
+        output_types.push_back(keeps_type ? this->child->types()[input_positions.back()] : DataType::INT);
+    }
+}
+
+HashAggregateOperator::~HashAggregateOperator() {
+    close();
+}
+
+void HashAggregateOperator::open() {
+    int workers = std::max(1, child->parallel_workers());
+    std::vector<std::unique_ptr<AggregateHashTable>> partials;
+    for (int i = 0; i < workers; ++i) {
+        partials.push_back(std::make_unique<AggregateHashTable>(functions, key_positions.size(), memory_budget / workers, 0));
+    }
+    child->run_parallel([&](int worker, RowBatch& batch) {
+        partials[worker]->add_batch(batch, key_positions, input_positions);
+    });
+    if (workers == 1) {
+        table = std::move(partials[0]);
+    } else {
+        table = std::make_unique<AggregateHashTable>(functions, key_positions.size(), memory_budget, 0);
+        for (auto& partial : partials) {
+            table->merge(*partial);
+            partial.reset();
+        }
+    }
+    if (key_positions.empty() && table->group_count() == 0) {
+        std::vector<AggregateState> no_input(functions.size());
+        table->merge({}, no_input.data());
+    }
+    next_group = 0;
+}
+
+bool HashAggregateOperator::next(RowBatch& batch) {
+    batch.reset(output_types);
+    while (table && !batch.full()) {
+        if (next_group < table->group_count()) {
+            table->result_row(next_group++, row);
+            batch.append(row);
+            continue;
+        }
+        for (const auto& file : table->take_spill_files()) {
+            pending.emplace_back(file, table->level() + 1);
+        }
+        if (pending.empty()) {
+            break;
+        }
+        const auto& [file, level] = pending.back();
+        table = std::make_unique<AggregateHashTable>(functions, key_positions.size(), memory_budget, level);
+        table->merge_file(file);
+        std::remove(file.c_str());
+        pending.pop_back();
+        next_group = 0;
+    }
+    return batch.size > 0;
+}
+
+void HashAggregateOperator::close() {
+    table.reset();
+    for (const auto& spilled : pending) {
+        std::remove(spilled.first.c_str());
+    }
+    pending.clear();
+}
@@ -0,0 +1,37 @@
+#ifndef HASH_AGGREGATE_OPERATOR_H
+#define HASH_AGGREGATE_OPERATOR_H
+
+#include <memory>
+#include "operator.h"
+#include "aggregate_hash_table.h"
+#include "../parser/sql_parser.h"
+
+// One row per group of its child's rows: the grouping columns, then the
+// aggregates in the order called; without grouping columns, one row even
+// for no input. open() drains the child, each of its threads into a
+// partial table of its own, and merges the partials. next() hands on the
+// groups held in memory, then those of each spill file, aggregated in turn
+// by a table of the next level. The partials share memory_budget between
+// them. Groups come out in no particular order.
+class HashAggregateOperator : public Operator {
+public:
+    HashAggregateOperator(std::unique_ptr<Operator> child, const std::vector<std::string>& group_by, const std::vector<AggregateCall>& aggregates,
+                          size_t memory_budget);
+    ~HashAggregateOperator() override; // Removes spill files not yet aggregated
+    void open() override;
+    bool next(RowBatch& batch) override;
+    void close() override;
+
+private:
+    std::unique_ptr<Operator> child;
+    std::vector<size_t> key_positions; // Child column of each grouping column
+    std::vector<size_t> input_positions; // Child column of each aggregate, NO_AGGREGATE_INPUT for COUNT(*)
+    std::vector<AggregateFunction> functions;
+    size_t memory_budget;
+    std::unique_ptr<AggregateHashTable> table; // Groups being handed on
+    size_t next_group = 0;
+    std::vector<std::pair<std::string, int>> pending; // Spill files left to aggregate, with the level to do it at
+    std::vector<Value> row;
+};
+
+#endif
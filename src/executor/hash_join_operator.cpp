@@ -0,0 +1,274 @@
+#include "hash_join_operator.h"
+#include "key_hash.h"
+#include "spill_file.h"
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+
+namespace {
+
+size_t partition_of(uint64_t hash, int level) {
+    return (hash >> (64 - JOIN_PARTITION_BITS * (level + 1))) & ((size_t(1) << JOIN_PARTITION_BITS) - 1);
+}
+
+bool read_row(std::ifstream& in, std::vector<Value>& row, size_t width) {
+    row.resize(width);
+    for (size_t i = 0; i < width; ++i) {
+        if (!read_value(in, row[i])) return false;
+    }
+    return true;
+}
+
+// One input split by key hash into a file per partition
+struct PartitionFiles {
+    std::vector<std::string> names;
+    std::vector<std::unique_ptr<std::ofstream>> outs;
+
+    explicit PartitionFiles(std::vector<std::string>& made) {
+        for (size_t i = 0; i < (size_t(1) << JOIN_PARTITION_BITS); ++i) {
+            names.push_back(new_spill_file("join"));
+            made.push_back(names.back());
+            outs.push_back(std::make_unique<std::ofstream>(names.back(), std::ios::binary | std::ios::trunc));
+            if (!*outs.back()) {
+                throw std::runtime_error("Could not create join partition file: " + names.back());
+            }
+        }
+    }
+
+    void write(uint64_t hash, int level, const ValueView* row, size_t width) {
+        std::ofstream& out = *outs[partition_of(hash, level)];
+        for (size_t i = 0; i < width; ++i) {
+            write_value(out, row[i]);
+        }
+    }
+
+    void write(uint64_t hash, int level, const std::vector<Value>& row) {
+        std::ofstream& out = *outs[partition_of(hash, level)];
+        for (const auto& value : row) {
+            write_value(out, value);
+        }
+    }
+
+    void close() {
+        for (size_t i = 0; i < outs.size(); ++i) {
+            outs[i]->close();
+            if (outs[i]->fail()) {
+                throw std::runtime_error("Could not write join partition file: " + names[i]);
+            }
+        }
+    }
+};
+
+} // namespace
+
+HashJoinOperator::HashJoinOperator(std::unique_ptr<Operator> left, std::unique_ptr<Operator> right, const std::vector<JoinCondition>& conditions, size_t memory_budget)
+    : JoinOperator(std::move(left), right->columns(), right->types()), right(std::move(right)), right_width(this->right->columns().size()),
+      memory_budget(memory_budget), table({}) {
+    for (const auto& comparison : bind_conditions(conditions)) {
+        bool left_first = comparison.left < left_width && comparison.right >= left_width;
+        bool right_first = comparison.right < left_width && comparison.left >= left_width;
+        if (comparison.op == CompareOp::EQ && (left_first || right_first)) {
+            probe_keys.push_back(left_first ? comparison.left : comparison.right);
+            build_keys.push_back((left_first ? comparison.right : comparison.left) - left_width);
+        } else {
+            residual.push_back(comparison);
+        }
+    }
+    if (probe_keys.empty()) {
+        throw std::runtime_error("Hash join needs an equality between its inputs");
+    }
+    table = JoinHashTable(build_keys);
+}
+
+HashJoinOperator::~HashJoinOperator() {
+    remove_files();
+}
+
+// Builds the table from the right input, copying rows straight from the
+// batches into its arena; if it grows past the budget, the rows so far and all that follow go to partition files instead, and so
+// does the whole left input
+void HashJoinOperator::open() {
+    partitioned = false;
+    match = JoinHashTable::NO_ROW;
+    std::unique_ptr<PartitionFiles> build_parts;
+    right->open();
+    RowBatch batch;
+    std::vector<Value> row;
+    bool null_key;
+    while (right->next(batch)) {
+        for (uint32_t row_index : batch.selection) {
+            uint64_t hash = key_hash(batch, row_index, build_keys, null_key);
+            if (null_key) continue;
+            if (build_parts) {
+                batch.row(row_index, row);
+                build_parts->write(hash, 0, row);
+                continue;
+            }
+            table.insert(batch.copy_row(row_index, table.arena()), hash);
+            if (table.memory_used() > memory_budget) {
+                build_parts = std::make_unique<PartitionFiles>(files);
+                for (uint32_t i = 0; i < table.row_count(); ++i) {
+                    build_parts->write(key_hash(table.row(i), build_keys), 0, table.row(i), right_width);
+                }
+                table.clear();
+            }
+        }
+    }
+    right->close();
+    left->open();
+    if (!build_parts) {
+        return;
+    }
+
+    PartitionFiles probe_parts(files);
+    while (next_left_row(row)) {
+        uint64_t hash = key_hash(row, probe_keys, null_key);
+        if (!null_key) probe_parts.write(hash, 0, row);
+    }
+    left->close();
+    build_parts->close();
+    probe_parts.close();
+    for (size_t i = 0; i < probe_parts.names.size(); ++i) {
+        pending.push_back({build_parts->names[i], probe_parts.names[i], 0});
+    }
+    partitioned = true;
+    load_partition();
+}
+
+bool HashJoinOperator::next(RowBatch& batch) {
+    batch.reset(output_types);
+    while (!batch.full()) {
+        if (match != JoinHashTable::NO_ROW) {
+            const ValueView* build_row = table.row(match);
+            match = table.next_match(match);
+            join_rows(probe_row, build_row, joined);
+            if (matches(residual, joined)) {
+                batch.append(joined.data());
+            }
+            continue;
+        }
+        if (!next_probe_row()) {
+            break;
+        }
+        bool null_key;
+        uint64_t hash = key_hash(probe_row, probe_keys, null_key);
+        if (!null_key) {
+            match = table.find(probe_row, probe_keys, hash);
+        }
+    }
+    return batch.size > 0;
+}
+
+void HashJoinOperator::close() {
+    if (!partitioned) {
+        left->close();
+    }
+    table.clear();
+    pending.clear();
+    remove_files();
+}
+
+// Hashes the same bits as key_hash of the row's values
+uint64_t HashJoinOperator::key_hash(const RowBatch& batch, uint32_t row, const std::vector<size_t>& keys, bool& null_key) {
+    null_key = false;
+    uint64_t hash = KEY_HASH_SEED;
+    for (size_t key : keys) {
+        null_key |= batch.columns[key].nulls[row];
+        hash = combine_hash(hash, hash_value(batch.columns[key], row));
+    }
+    return hash;
+}
+
+uint64_t HashJoinOperator::key_hash(const std::vector<Value>& row, const std::vector<size_t>& keys, bool& null_key) {
+    null_key = false;
+    uint64_t hash = KEY_HASH_SEED;
+    for (size_t key : keys) {
+        null_key |= row[key].is_null();
+        hash = combine_hash(hash, hash_value(row[key]));
+    }
+    return hash;
+}
+
+uint64_t HashJoinOperator::key_hash(const ValueView* row, const std::vector<size_t>& keys) {
+    uint64_t hash = KEY_HASH_SEED;
+    for (size_t key : keys) {
+        hash = combine_hash(hash, hash_value(row[key]));
+    }
+    return hash;
+}
+
+bool HashJoinOperator::next_probe_row() {
+    if (!partitioned) {
+        return next_left_row(probe_row);
+    }
+    while (!read_row(probe_in, probe_row, left_width)) {
+        if (!load_partition()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A partition whose build side is still too large is split by the hash
+// bits of the next level, until the bits run out
+bool HashJoinOperator::load_partition() {
+    probe_in.close();
+    while (!pending.empty()) {
+        Partition part = pending.back();
+        pending.pop_back();
+        table.clear();
+        if (std::filesystem::file_size(part.probe_file) == 0) {
+            std::remove(part.build_file.c_str());
+            std::remove(part.probe_file.c_str());
+            continue;
+        }
+        std::ifstream build_in(part.build_file, std::ios::binary);
+        std::vector<Value> row;
+        bool too_large = false;
+        bool null_key;
+        while (!too_large && read_row(build_in, row, right_width)) {
+            const ValueView* stored = copy_row(row, table.arena());
+            table.insert(stored, key_hash(stored, build_keys));
+            too_large = table.memory_used() > memory_budget && JOIN_PARTITION_BITS * (part.level + 2) <= 64;
+        }
+        if (too_large) {
+            int level = part.level + 1;
+            PartitionFiles build_parts(files);
+            PartitionFiles probe_parts(files);
+            for (uint32_t i = 0; i < table.row_count(); ++i) {
+                build_parts.write(key_hash(table.row(i), build_keys), level, table.row(i), right_width);
+            }
+            table.clear();
+            while (read_row(build_in, row, right_width)) {
+                build_parts.write(key_hash(row, build_keys, null_key), level, row);
+            }
+            std::ifstream probe_source(part.probe_file, std::ios::binary);
+            while (read_row(probe_source, row, left_width)) {
+                probe_parts.write(key_hash(row, probe_keys, null_key), level, row);
+            }
+            build_parts.close();
+            probe_parts.close();
+            for (size_t i = 0; i < build_parts.names.size(); ++i) {
+                pending.push_back({build_parts.names[i], probe_parts.names[i], level});
+            }
+        }
+        build_in.close();
+        std::remove(part.build_file.c_str());
+        if (too_large || table.row_count() == 0) {
+            std::remove(part.probe_file.c_str());
+            continue;
+        }
+        probe_in.clear();
+        probe_in.open(part.probe_file, std::ios::binary);
+        return true;
+    }
+    return false;
+}
+
+void HashJoinOperator::remove_files() {
+    probe_in.close();
+    for (const auto& file : files) {
+        std::remove(file.c_str());
+    }
+    files.clear();
+}
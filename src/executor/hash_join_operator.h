@@ -0,0 +1,59 @@
+#ifndef HASH_JOIN_OPERATOR_H
+#define HASH_JOIN_OPERATOR_H
+
+#include <fstream>
+#include "join_operator.h"
+#include "join_hash_table.h"
+
+const int JOIN_PARTITION_BITS = 3; // A partitioning pass splits each input into 2^bits files
+
+// Equi-join that builds a hash table of the right input and probes it with
+// the left one, streamed batch by batch. Rows with a NULL key never match.
+// When the build side outgrows its memory budget the join turns into a Grace
+// hash join: both inputs are split by key hash into partition files, and
+// each pair of partitions is joined in memory, split again by further hash
+// bits if its build side is still too large.
+class HashJoinOperator : public JoinOperator {
+public:
+    // Needs at least one equality between the inputs; other conditions are
+    // tested on each joined row. memory_budget bounds the build rows kept in
+    // memory.
+    HashJoinOperator(std::unique_ptr<Operator> left, std::unique_ptr<Operator> right, const std::vector<JoinCondition>& conditions, size_t memory_budget);
+    ~HashJoinOperator() override; // Removes the partition files
+    void open() override;
+    bool next(RowBatch& batch) override;
+    void close() override;
+
+private:
+    struct Partition {
+        std::string build_file;
+        std::string probe_file;
+        int level;
+    };
+
+    std::unique_ptr<Operator> right;
+    size_t right_width;
+    size_t memory_budget;
+    std::vector<size_t> probe_keys; // Key columns of the left input
+    std::vector<size_t> build_keys; // Key columns of the right input
+    std::vector<ColumnComparison> residual;
+    JoinHashTable table;
+
+    bool partitioned = false; // Probe rows come from probe_in rather than the left input
+    std::vector<Partition> pending;
+    std::ifstream probe_in;
+    std::vector<std::string> files; // Every partition file made, removed on close
+
+    std::vector<Value> probe_row;
+    uint32_t match = JoinHashTable::NO_ROW; // Next build row to pair with probe_row
+    std::vector<ValueView> joined;
+
+    static uint64_t key_hash(const RowBatch& batch, uint32_t row, const std::vector<size_t>& keys, bool& null_key);
+    static uint64_t key_hash(const std::vector<Value>& row, const std::vector<size_t>& keys, bool& null_key);
+    static uint64_t key_hash(const ValueView* row, const std::vector<size_t>& keys);
+    bool next_probe_row();
+    bool load_partition(); // Builds the table of the next pending partition; false when none is left
+    void remove_files();
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include "index_nested_loop_join_operator.h"
+#include "../transaction/transaction_manager.h"
+#include <stdexcept>
+
+static std::vector<std::string> qualified_columns(const std::vector<Column>& columns, const std::string& alias) {
+    std::vector<std::string> names;
+    for (const auto& col : columns) {
+        names.push_back(alias + "." + col.name);
+    }
+    return names;
+}
+
+static std::vector<DataType> column_types(const std::vector<Column>& columns) {
+    std::vector<DataType> types;
+    for (const auto& col : columns) {
+        types.push_back(col.type);
+    }
+    return types;
+}
+
+IndexNestedLoopJoinOperator::IndexNestedLoopJoinOperator(const ExecContext& ctx, std::unique_ptr<Operator> left, const std::string& table_name,
+                                                         const std::string& alias, const std::string& index_name,
+                                                         const std::vector<WhereCondition>& conditions,
+                                                         const std::vector<JoinCondition>& join_conditions)
+    : JoinOperator(std::move(left), qualified_columns(ctx.storage.get_table_metadata(table_name), alias),
+                   column_types(ctx.storage.get_table_metadata(table_name))),
+      ctx(ctx), table_name(table_name), index_name(index_name), conditions(conditions) {
+    comparisons = bind_conditions(join_conditions);
+    for (size_t i = 0; i < comparisons.size(); ++i) {
+        const auto& comparison = comparisons[i];
+        bool right_first = comparison.left >= left_width && comparison.right < left_width;
+        bool left_first = comparison.left < left_width && comparison.right >= left_width;
+        const std::string& op = join_conditions[i].op;
+        if ((!left_first && !right_first) || op == "!=" || op == "<>") continue;
+        size_t right_position = right_first ? comparison.left : comparison.right;
+        lookups.push_back({output_columns[right_position].substr(alias.size() + 1), right_first ? op : flip_comparison(op),
+                           right_first ? comparison.right : comparison.left});
+    }
+}
+
+void IndexNestedLoopJoinOperator::open() {
+    if (ctx.tx_id != 0 && !ctx.tx_manager.lock_table(ctx.tx_id, table_name, LockMode::INTENTION_SHARED)) {
+        throw std::runtime_error("Failed to acquire intention shared lock for SELECT.");
+    }
+    left->open();
+    matches_found.clear();
+    match_position = 0;
+}
+
+bool IndexNestedLoopJoinOperator::next(RowBatch& batch) {
+    batch.reset(output_types);
+    std::vector<WhereCondition> lookup_conditions;
+    while (!batch.full()) {
+        if (match_position < matches_found.size()) {
+            const auto& record = matches_found[match_position++];
+            join_rows(left_row, record.columns, joined);
+            if (matches(comparisons, joined)) {
+                batch.append(joined.data());
+            }
+            continue;
+        }
+        matches_found.clear();
+        match_position = 0;
+        if (!next_left_row(left_row)) {
+            break;
+        }
+        // A NULL can match nothing, so the row needs no lookup
+        lookup_conditions = conditions;
+        bool null_value = false;
+        for (const auto& lookup : lookups) {
+            const Value& value = left_row[lookup.left_position];
+            null_value |= value.is_null();
+            lookup_conditions.push_back({lookup.column, lookup.op, value});
+        }
+        if (!null_value) {
+            matches_found = ctx.storage.index_scan(table_name, index_name, lookup_conditions, ctx.tx_id, ctx.cid, ctx.snapshot, ctx.tx_manager);
+        }
+    }
+    return batch.size > 0;
+}
+
+void IndexNestedLoopJoinOperator::close() {
+    left->close();
+    matches_found.clear();
+}
@@ -0,0 +1,42 @@
+#ifndef INDEX_NESTED_LOOP_JOIN_OPERATOR_H
+#define INDEX_NESTED_LOOP_JOIN_OPERATOR_H
+
+#include "join_operator.h"
+#include "../storage/storage_engine.h"
+
+// Join whose right input is a table looked up through an index once per
+// left row, with the row's values bound into the join conditions on the
+// right table's columns. Used for joins without an equality, where a range
+// lookup beats pairing every row.
+class IndexNestedLoopJoinOperator : public JoinOperator {
+public:
+    // conditions are the right table's own, on unqualified columns; the
+    // right columns come out qualified with alias
+    IndexNestedLoopJoinOperator(const ExecContext& ctx, std::unique_ptr<Operator> left, const std::string& table_name, const std::string& alias,
+                                const std::string& index_name, const std::vector<WhereCondition>& conditions,
+                                const std::vector<JoinCondition>& join_conditions);
+    void open() override;
+    bool next(RowBatch& batch) override;
+    void close() override;
+
+private:
+    // A right column bound to a left one for the lookup
+    struct Lookup {
+        std::string column; // Unqualified
+        std::string op; // right column op left value
+        size_t left_position;
+    };
+
+    const ExecContext& ctx;
+    std::string table_name;
+    std::string index_name;
+    std::vector<WhereCondition> conditions;
+    std::vector<Lookup> lookups;
+    std::vector<ColumnComparison> comparisons;
+    std::vector<Record> matches_found;
+    size_t match_position = 0; // Next record of matches_found to pair with left_row
+    std::vector<Value> left_row;
+    std::vector<ValueView> joined;
+};
+
+#endif
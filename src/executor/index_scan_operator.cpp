@@ -0,0 +1,47 @@
+#include "index_scan_operator.h"
+#include "../transaction/transaction_manager.h"
+#include <stdexcept>
+#include <algorithm>
+
+IndexScanOperator::IndexScanOperator(const ExecContext& ctx, const std::string& table_name, const std::string& index_name,
+                                     const std::vector<WhereCondition>& conditions, bool index_only)
+    : ctx(ctx), table_name(table_name), index_name(index_name), conditions(conditions), index_only(index_only) {
+    const auto& table_cols = ctx.storage.get_table_metadata(table_name);
+    if (index_only) {
+        output_columns = ctx.storage.index_columns(index_name);
+        for (const auto& name : output_columns) {
+            auto col = std::find_if(table_cols.begin(), table_cols.end(), [&](const Column& c) { return c.name == name; });
+            output_types.push_back(col != table_cols.end() ? col->type : DataType::STRING);
+        }
+    } else {
+        for (const auto& col : table_cols) {
+            output_columns.push_back(col.name);
+            output_types.push_back(col.type);
+        }
+    }
+}
+
+void IndexScanOperator::open() {
+    if (ctx.tx_id != 0 && !ctx.tx_manager.lock_table(ctx.tx_id, table_name, LockMode::INTENTION_SHARED)) {
+        throw std::runtime_error("Failed to acquire intention shared lock for SELECT.");
+    }
+    if (index_only) {
+        records = ctx.storage.index_only_scan(table_name, index_name, conditions, ctx.tx_id, ctx.cid, ctx.snapshot, ctx.tx_manager);
+    } else {
+        records = ctx.storage.index_scan(table_name, index_name, conditions, ctx.tx_id, ctx.cid, ctx.snapshot, ctx.tx_manager);
+    }
+    position = 0;
+}
+
+bool IndexScanOperator::next(RowBatch& batch) {
+    batch.reset(output_types);
+    while (!batch.full() && position < records.size()) {
+        batch.append(records[position++].columns);
+    }
+    return batch.size > 0;
+}
+
+void IndexScanOperator::close() {
+    records.clear();
+    records.shrink_to_fit();
+}
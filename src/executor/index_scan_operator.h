@@ -0,0 +1,28 @@
+#ifndef INDEX_SCAN_OPERATOR_H
+#define INDEX_SCAN_OPERATOR_H
+
+#include "operator.h"
+#include "../storage/storage_engine.h"
+
+// Rows found through an index, either the full heap rows or, for an
+// index-only scan, just the index's columns. The lookup runs in open();
+// its result is bounded by the index conditions rather than the table.
+class IndexScanOperator : public Operator {
+public:
+    IndexScanOperator(const ExecContext& ctx, const std::string& table_name, const std::string& index_name,
+                      const std::vector<WhereCondition>& conditions, bool index_only);
+    void open() override;
+    bool next(RowBatch& batch) override;
+    void close() override;
+
+private:
+    const ExecContext& ctx;
+    std::string table_name;
+    std::string index_name;
+    std::vector<WhereCondition> conditions;
+    bool index_only;
+    std::vector<Record> records;
+    size_t position = 0;
+};
+
+#endif
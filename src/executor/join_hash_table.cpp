@@ -0,0 +1,85 @@
+#include "join_hash_table.h"
+#include "key_hash.h"
+
+const size_t INITIAL_JOIN_SLOTS = 64;
+
+const uint32_t JoinHashTable::NO_ROW;
+
+JoinHashTable::JoinHashTable(const std::vector<size_t>& key_positions)
+    : key_positions(key_positions), slots(INITIAL_JOIN_SLOTS, Slot{0, NO_ROW}) {}
+
+void JoinHashTable::insert(const ValueView* row, uint64_t hash) {
+    uint32_t index = static_cast<uint32_t>(rows.size());
+    size_t mask = slots.size() - 1;
+    size_t i = hash & mask;
+    while (slots[i].head != NO_ROW && !(slots[i].hash == hash && same_key(slots[i].head, row, key_positions))) {
+        i = (i + 1) & mask;
+    }
+    rows.push_back(row);
+    if (slots[i].head == NO_ROW) {
+        chain.push_back(NO_ROW);
+        slots[i] = {hash, index};
+        if (++used_slots * 2 > slots.size()) {
+            grow();
+        }
+    } else {
+        chain.push_back(slots[i].head);
+        slots[i].head = index;
+    }
+}
+
+uint32_t JoinHashTable::find(const std::vector<Value>& probe, const std::vector<size_t>& probe_positions, uint64_t hash) const {
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask; slots[i].head != NO_ROW; i = (i + 1) & mask) {
+        if (slots[i].hash == hash && same_key(slots[i].head, probe, probe_positions)) {
+            return slots[i].head;
+        }
+    }
+    return NO_ROW;
+}
+
+void JoinHashTable::clear() {
+    slots.assign(INITIAL_JOIN_SLOTS, Slot{0, NO_ROW});
+    used_slots = 0;
+    row_arena.reset();
+    rows.clear();
+    rows.shrink_to_fit();
+    chain.clear();
+    chain.shrink_to_fit();
+}
+
+// The arena's chunks plus the row and slot arrays
+size_t JoinHashTable::memory_used() const {
+    return row_arena.used() + rows.capacity() * (sizeof(const ValueView*) + sizeof(uint32_t)) + slots.size() * sizeof(Slot);
+}
+
+bool JoinHashTable::same_key(uint32_t row, const ValueView* other, const std::vector<size_t>& other_positions) const {
+    const ValueView* stored = rows[row];
+    for (size_t i = 0; i < key_positions.size(); ++i) {
+        if (!equal_values(stored[key_positions[i]], other[other_positions[i]])) return false;
+    }
+    return true;
+}
+
+bool JoinHashTable::same_key(uint32_t row, const std::vector<Value>& other, const std::vector<size_t>& other_positions) const {
+    const ValueView* stored = rows[row];
+    for (size_t i = 0; i < key_positions.size(); ++i) {
+        if (!equal_values(stored[key_positions[i]], view_of(other[other_positions[i]]))) return false;
+    }
+    return true;
+}
+
+void JoinHashTable::grow() {
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.assign(old.size() * 2, Slot{0, NO_ROW});
+    size_t mask = slots.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.head == NO_ROW) continue;
+        size_t i = slot.hash & mask;
+        while (slots[i].head != NO_ROW) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = slot;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef JOIN_HASH_TABLE_H
+#define JOIN_HASH_TABLE_H
+
+#include <cstdint>
+#include <vector>
+#include "../common/arena.h"
+#include "../common/value.h"
+
+// Build side of a hash join: rows held as views in the table's arena,
+// found by the values at key_positions. An open-addressing table of
+// (hash, first row) slots, probed linearly, heads one chain per distinct key.
+class JoinHashTable {
+public:
+    static const uint32_t NO_ROW = UINT32_MAX;
+
+    explicit JoinHashTable(const std::vector<size_t>& key_positions);
+
+    Arena& arena() { return row_arena; } // Where rows to insert are placed
+    void insert(const ValueView* row, uint64_t hash); // row must live in arena()
+    // First row whose key equals the values of probe at probe_positions
+    uint32_t find(const std::vector<Value>& probe, const std::vector<size_t>& probe_positions, uint64_t hash) const;
+    uint32_t next_match(uint32_t row) const { return chain[row]; }
+    const ValueView* row(uint32_t row) const { return rows[row]; }
+    size_t row_count() const { return rows.size(); }
+    size_t memory_used() const;
+    void clear();
+
+private:
+    struct Slot {
+        uint64_t hash;
+        uint32_t head; // NO_ROW when free
+    };
+
+    std::vector<size_t> key_positions;
+    std::vector<Slot> slots; // Power-of-two size, at most half full
+    size_t used_slots = 0;
+    Arena row_arena;
+    std::vector<const ValueView*> rows;
+    std::vector<uint32_t> chain; // Next row with the same key
+
+    bool same_key(uint32_t row, const ValueView* other, const std::vector<size_t>& other_positions) const;
+    bool same_key(uint32_t row, const std::vector<Value>& other, const std::vector<size_t>& other_positions) const;
+    void grow();
+};
+
+#endif
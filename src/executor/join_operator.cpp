@@ -0,0 +1,65 @@
+#include "join_operator.h"
+#include <algorithm>
+#include <stdexcept>
+
+JoinOperator::JoinOperator(std::unique_ptr<Operator> left, const std::vector<std::string>& right_columns, const std::vector<DataType>& right_types)
+    : left(std::move(left)) {
+    output_columns = this->left->columns();
+    output_types = this->left->types();
+    left_width = output_columns.size();
+    output_columns.insert(output_columns.end(), right_columns.begin(), right_columns.end());
+    output_types.insert(output_types.end(), right_types.begin(), right_types.end());
+}
+
+std::vector<ColumnComparison> JoinOperator::bind_conditions(const std::vector<JoinCondition>& conditions) const {
+    auto position_of = [this](const std::string& column) {
+        auto col = std::find(output_columns.begin(), output_columns.end(), column);
+        if (col == output_columns.end()) {
+            throw std::runtime_error("Column '" + column + "' not found in result set");
+        }
+        return static_cast<size_t>(col - output_columns.begin());
+    };
+    std::vector<ColumnComparison> comparisons;
+    for (const auto& cond : conditions) {
+        comparisons.push_back({position_of(cond.left_column), compare_op_from(cond.op), position_of(cond.right_column)});
+    }
+    return comparisons;
+}
+
+bool JoinOperator::matches(const std::vector<ColumnComparison>& comparisons, const std::vector<ValueView>& row) {
+    for (const auto& comparison : comparisons) {
+        if (!compare_values(row[comparison.left], comparison.op, row[comparison.right])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void JoinOperator::join_rows(const std::vector<Value>& left_row, const ValueView* right_row, std::vector<ValueView>& joined) const {
+    joined.clear();
+    for (const auto& value : left_row) {
+        joined.push_back(view_of(value));
+    }
+    joined.insert(joined.end(), right_row, right_row + (output_columns.size() - left_width));
+}
+
+void JoinOperator::join_rows(const std::vector<Value>& left_row, const std::vector<Value>& right_row, std::vector<ValueView>& joined) const {
+    joined.clear();
+    for (const auto& value : left_row) {
+        joined.push_back(view_of(value));
+    }
+    for (const auto& value : right_row) {
+        joined.push_back(view_of(value));
+    }
+}
+
+bool JoinOperator::next_left_row(std::vector<Value>& row) {
+    while (left_position >= left_batch.selection.size()) {
+        if (!left->next(left_batch)) {
+            return false;
+        }
+        left_position = 0;
+    }
+    left_batch.row(left_batch.selection[left_position++], row);
+    return true;
+}
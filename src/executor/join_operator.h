@@ -0,0 +1,38 @@
+#ifndef JOIN_OPERATOR_H
+#define JOIN_OPERATOR_H
+
+#include <memory>
+#include "operator.h"
+#include "../common/predicate.h"
+
+// Two columns of a joined row compared, by their positions in it
+struct ColumnComparison {
+    size_t left;
+    CompareOp op;
+    size_t right;
+};
+
+// Base of the join operators, whose rows are a row of the left input
+// followed by a matching row of the right one
+class JoinOperator : public Operator {
+protected:
+    JoinOperator(std::unique_ptr<Operator> left, const std::vector<std::string>& right_columns, const std::vector<DataType>& right_types);
+
+    // Throws when a condition names a column of neither input
+    std::vector<ColumnComparison> bind_conditions(const std::vector<JoinCondition>& conditions) const;
+    static bool matches(const std::vector<ColumnComparison>& comparisons, const std::vector<ValueView>& row);
+    // Views of left_row followed by right_row, valid while both are unchanged
+    void join_rows(const std::vector<Value>& left_row, const ValueView* right_row, std::vector<ValueView>& joined) const;
+    void join_rows(const std::vector<Value>& left_row, const std::vector<Value>& right_row, std::vector<ValueView>& joined) const;
+    // The next row of the left input; false once it is exhausted
+    bool next_left_row(std::vector<Value>& row);
+
+    std::unique_ptr<Operator> left;
+    size_t left_width;
+
+private:
+    RowBatch left_batch;
+    size_t left_position = 0; // Into left_batch.selection
+};
+
+#endif
@@ -0,0 +1,46 @@
+#include "key_hash.h"
+#include <functional>
+
+static uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t hash_value(const ColumnVector& column, uint32_t row) {
+    if (column.nulls[row]) return 0;
+    if (column.type == DataType::INT) return static_cast<uint32_t>(column.ints[row]) + 1;
+    return std::hash<std::string_view>()(column.string_at(row));
+}
+
+uint64_t hash_value(const Value& value) {
+    return hash_value(view_of(value));
+}
+
+uint64_t hash_value(const ValueView& value) {
+    if (value.type == DataType::NULL_TYPE) return 0;
+    if (value.type == DataType::INT) return static_cast<uint32_t>(value.int_value) + 1;
+    return std::hash<std::string_view>()(value.str_value);
+}
+
+uint64_t combine_hash(uint64_t hash, uint64_t value) {
+    return mix(hash ^ (value + KEY_HASH_SEED + (hash << 6) + (hash >> 2)));
+}
+
+bool equal_values(const ColumnVector& column, uint32_t row, const Value& value) {
+    if (column.nulls[row] || value.is_null()) return column.nulls[row] && value.is_null();
+    if (column.type == DataType::INT) return column.ints[row] == value.int_value;
+    return column.string_at(row) == value.str_value;
+}
+
+bool equal_values(const Value& a, const Value& b) {
+    return equal_values(view_of(a), view_of(b));
+}
+
+bool equal_values(const ValueView& a, const ValueView& b) {
+    if (a.type != b.type) return false;
+    return a.type == DataType::INT ? a.int_value == b.int_value : a.str_value == b.str_value;
+}
@@ -0,0 +1,23 @@
+#ifndef KEY_HASH_H
+#define KEY_HASH_H
+
+#include <cstdint>
+#include "row_batch.h"
+
+const uint64_t KEY_HASH_SEED = 0x9e3779b97f4a7c15ULL;
+
+// Hashes of grouping and join keys. A key column hashes to the same bits
+// whether it is read from a batch or from a stored value, so keys from
+// either can meet in one hash table; a key is folded column by column into
+// KEY_HASH_SEED with combine_hash.
+uint64_t hash_value(const ColumnVector& column, uint32_t row);
+uint64_t hash_value(const Value& value);
+uint64_t hash_value(const ValueView& value);
+uint64_t combine_hash(uint64_t hash, uint64_t value);
+
+// Key equality, NULL equal to NULL
+bool equal_values(const ColumnVector& column, uint32_t row, const Value& value);
+bool equal_values(const Value& a, const Value& b);
+bool equal_values(const ValueView& a, const ValueView& b);
+
+#endif
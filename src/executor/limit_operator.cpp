@@ -0,0 +1,27 @@
+#include "limit_operator.h"
+
+LimitOperator::LimitOperator(std::unique_ptr<Operator> child, int limit)
+    : child(std::move(child)), limit(limit) {
+    output_columns = this->child->columns();
+    output_types = this->child->types();
+}
+
+void LimitOperator::open() {
+    remaining = static_cast<size_t>(limit);
+    child->open();
+}
+
+bool LimitOperator::next(RowBatch& batch) {
+    if (remaining == 0 || !child->next(batch)) {
+        return false;
+    }
+    if (batch.selection.size() > remaining) {
+        batch.selection.resize(remaining);
+    }
+    remaining -= batch.selection.size();
+    return true;
+}
+
+void LimitOperator::close() {
+    child->close();
+}
@@ -0,0 +1,22 @@
+#ifndef LIMIT_OPERATOR_H
+#define LIMIT_OPERATOR_H
+
+#include <memory>
+#include "operator.h"
+
+// The first limit rows of its child. Once they are handed on the child is
+// not asked for more, so the operators below stop early.
+class LimitOperator : public Operator {
+public:
+    LimitOperator(std::unique_ptr<Operator> child, int limit);
+    void open() override;
+    bool next(RowBatch& batch) override;
+    void close() override;
+
+private:
+    std::unique_ptr<Operator> child;
+    int limit;
+    size_t remaining = 0;
+};
+
+#endif
@@ -0,0 +1,145 @@
+#include "nested_loop_join_operator.h"
+#include "spill_file.h"
+#include <cstdio>
+#include <stdexcept>
+
+NestedLoopJoinOperator::NestedLoopJoinOperator(std::unique_ptr<Operator> left, std::unique_ptr<Operator> right, const std::vector<JoinCondition>& conditions, size_t memory_budget)
+    : JoinOperator(std::move(left), right->columns(), right->types()), right(std::move(right)), right_width(this->right->columns().size()),
+      memory_budget(memory_budget) {
+    comparisons = bind_conditions(conditions);
+}
+
+NestedLoopJoinOperator::~NestedLoopJoinOperator() {
+    remove_file();
+}
+
+void NestedLoopJoinOperator::open() {
+    right->open();
+    RowBatch batch;
+    std::vector<Value> row;
+    std::ofstream right_out;
+    while (right->next(batch)) {
+        for (uint32_t row_index : batch.selection) {
+            if (!right_file.empty()) {
+                batch.row(row_index, row);
+                for (const auto& value : row) {
+                    write_value(right_out, value);
+                }
+                continue;
+            }
+            right_rows.push_back(batch.copy_row(row_index, arena));
+            if (arena.used() + right_rows.capacity() * sizeof(const ValueView*) > memory_budget) {
+                spill_right(right_out);
+            }
+        }
+    }
+    right->close();
+    if (!right_file.empty()) {
+        right_out.close();
+        if (right_out.fail()) {
+            throw std::runtime_error("Could not write join spill file: " + right_file);
+        }
+        right_in.open(right_file, std::ios::binary);
+        block_position = 0;
+        left_block.clear();
+    }
+    left->open();
+    has_left_row = false;
+}
+
+bool NestedLoopJoinOperator::next(RowBatch& batch) {
+    batch.reset(output_types);
+    if (!right_file.empty()) {
+        return next_spilled(batch);
+    }
+    while (!batch.full()) {
+        if (!has_left_row || right_position == right_rows.size()) {
+            if (right_rows.empty() || !next_left_row(left_row)) {
+                break;
+            }
+            has_left_row = true;
+            right_position = 0;
+        }
+        join_rows(left_row, right_rows[right_position++], joined);
+        if (matches(comparisons, joined)) {
+            batch.append(joined.data());
+        }
+    }
+    return batch.size > 0;
+}
+
+void NestedLoopJoinOperator::close() {
+    left->close();
+    right_rows.clear();
+    right_rows.shrink_to_fit();
+    left_block.clear();
+    arena.reset();
+    remove_file();
+}
+
+// Opens out on a new file and writes the right rows held so far to it
+void NestedLoopJoinOperator::spill_right(std::ofstream& out) {
+    right_file = new_spill_file("join");
+    out.open(right_file, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Could not create join spill file: " + right_file);
+    }
+    for (const ValueView* stored : right_rows) {
+        for (size_t i = 0; i < right_width; ++i) {
+            write_value(out, stored[i]);
+        }
+    }
+    right_rows.clear();
+    right_rows.shrink_to_fit();
+    arena.reset();
+}
+
+bool NestedLoopJoinOperator::next_block() {
+    left_block.clear();
+    arena.reset();
+    while (arena.used() + left_block.size() * sizeof(const ValueView*) < memory_budget && next_left_row(left_row)) {
+        left_block.push_back(copy_row(left_row, arena));
+    }
+    block_position = left_block.size(); // Waits for a right row
+    return !left_block.empty();
+}
+
+// Pairs each right row read from the file with the whole left block, then
+// rewinds the file for the next block
+bool NestedLoopJoinOperator::next_spilled(RowBatch& batch) {
+    while (!batch.full()) {
+        if (block_position == left_block.size()) {
+            bool complete = !left_block.empty();
+            right_row.resize(right_width);
+            for (size_t i = 0; i < right_width && complete; ++i) {
+                complete = read_value(right_in, right_row[i]);
+            }
+            if (!complete) {
+                if (!next_block()) {
+                    break;
+                }
+                right_in.clear();
+                right_in.seekg(0);
+                continue;
+            }
+            block_position = 0;
+        }
+        const ValueView* block_row = left_block[block_position++];
+        joined.assign(block_row, block_row + left_width);
+        for (const auto& value : right_row) {
+            joined.push_back(view_of(value));
+        }
+        if (matches(comparisons, joined)) {
+            batch.append(joined.data());
+        }
+    }
+    return batch.size > 0;
+}
+
+void NestedLoopJoinOperator::remove_file() {
+    right_in.close();
+    if (!right_file.empty()) {
+        std::remove(right_file.c_str());
+        right_file.clear();
+    }
+}
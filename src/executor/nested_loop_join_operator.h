@@ -0,0 +1,44 @@
+#ifndef NESTED_LOOP_JOIN_OPERATOR_H
+#define NESTED_LOOP_JOIN_OPERATOR_H
+
+#include <fstream>
+#include "join_operator.h"
+
+// Join on arbitrary conditions: the right input is read into memory in
+// open(), then every left row is paired with every right row and the
+// pairs that satisfy all conditions are kept. A right input larger than
+// the memory budget goes to a file instead, which is read once for each
+// block of left rows that fits the budget.
+class NestedLoopJoinOperator : public JoinOperator {
+public:
+    NestedLoopJoinOperator(std::unique_ptr<Operator> left, std::unique_ptr<Operator> right, const std::vector<JoinCondition>& conditions, size_t memory_budget);
+    ~NestedLoopJoinOperator() override; // Removes the right file
+    void open() override;
+    bool next(RowBatch& batch) override;
+    void close() override;
+
+private:
+    std::unique_ptr<Operator> right;
+    size_t right_width;
+    size_t memory_budget;
+    std::vector<ColumnComparison> comparisons;
+    Arena arena; // Right rows, or the left block once the right input is in a file
+    std::vector<const ValueView*> right_rows;
+    size_t right_position = 0; // Next right row to pair with left_row
+    bool has_left_row = false;
+    std::vector<Value> left_row;
+    std::vector<ValueView> joined;
+
+    std::string right_file; // Empty while the right input fits in memory
+    std::ifstream right_in;
+    std::vector<Value> right_row; // Last read from right_in
+    std::vector<const ValueView*> left_block;
+    size_t block_position = 0; // Next left row of the block to pair with right_row
+
+    void spill_right(std::ofstream& out);
+    bool next_block(); // False once the left input is exhausted
+    bool next_spilled(RowBatch& batch);
+    void remove_file();
+};
+
+#endif
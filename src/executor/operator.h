@@ -0,0 +1,64 @@
+#ifndef OPERATOR_H
+#define OPERATOR_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "../common/value.h"
+#include "row_batch.h"
+#include "../transaction/snapshot.h"
+#include "../common/settings.h"
+
+class StorageEngine;
+class TransactionManager;
+
+// What every operator of one statement runs against
+struct ExecContext {
+    StorageEngine& storage;
+    TransactionManager& tx_manager;
+    int tx_id;
+    int cid;
+    const Snapshot& snapshot;
+    const Settings& settings;
+};
+
+// Physical operator of a query, pulled one batch at a time: open() prepares
+// it, each next() produces a batch of up to BATCH_SIZE rows, and close()
+// releases what open() acquired. Batches flow up the tree as they are
+// produced, so no operator holds more than its own working state.
+class Operator {
+public:
+    virtual ~Operator() = default;
+    virtual void open() = 0;
+    // Refills batch, which may come back with no row selected; false once
+    // the operator is exhausted
+    virtual bool next(RowBatch& batch) = 0;
+    virtual void close() = 0;
+    // Threads the operator produces its rows on
+    virtual int parallel_workers() const { return 1; }
+    // Runs the operator from open to close, handing every batch to consume
+    // on the thread that produced it, numbered below parallel_workers(), so
+    // a consumer can keep per-thread state
+    virtual void run_parallel(const std::function<void(int worker, RowBatch& batch)>& consume) {
+        open();
+        RowBatch batch;
+        while (next(batch)) {
+            consume(0, batch);
+        }
+        close();
+    }
+    // Names the output columns alias.column, as a table in a join is read
+    void qualify_columns(const std::string& alias) {
+        for (auto& column : output_columns) {
+            column = alias + "." + column;
+        }
+    }
+    const std::vector<std::string>& columns() const { return output_columns; }
+    const std::vector<DataType>& types() const { return output_types; }
+
+protected:
+    std::vector<std::string> output_columns;
+    std::vector<DataType> output_types;
+};
+
+#endif
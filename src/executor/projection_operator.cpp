@@ -0,0 +1,53 @@
+#include "projection_operator.h"
+#include <algorithm>
+
+ProjectionOperator::ProjectionOperator(std::unique_ptr<Operator> child, const std::vector<std::string>& projection_columns)
+    : child(std::move(child)) {
+    const auto& child_columns = this->child->columns();
+    all_columns = projection_columns.size() == 1 && projection_columns[0] == "*";
+    if (all_columns) {
+        output_columns = child_columns;
+        output_types = this->child->types();
+        return;
+    }
+    for (const auto& proj_col : projection_columns) {
+        auto col = std::find(child_columns.begin(), child_columns.end(), proj_col);
+        if (col != child_columns.end()) {
+            size_t position = static_cast<size_t>(col - child_columns.begin());
+            output_columns.push_back(proj_col);
+            output_types.push_back(this->child->types()[position]);
+            positions.push_back(position);
+        }
+    }
+    for (size_t i = 0; i < positions.size(); ++i) {
+        reused.push_back(std::find(positions.begin() + i + 1, positions.end(), positions[i]) != positions.end());
+    }
+}
+
+void ProjectionOperator::open() {
+    child->open();
+}
+
+bool ProjectionOperator::next(RowBatch& batch) {
+    if (all_columns) {
+        return child->next(batch);
+    }
+    if (!child->next(input)) {
+        return false;
+    }
+    batch.columns.resize(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        if (reused[i]) {
+            batch.columns[i] = input.columns[positions[i]];
+        } else {
+            std::swap(batch.columns[i], input.columns[positions[i]]); // The child refills the old buffers
+        }
+    }
+    batch.size = input.size;
+    batch.selection.swap(input.selection);
+    return true;
+}
+
+void ProjectionOperator::close() {
+    child->close();
+}
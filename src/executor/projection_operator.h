@@ -0,0 +1,25 @@
+#ifndef PROJECTION_OPERATOR_H
+#define PROJECTION_OPERATOR_H
+
+#include <memory>
+#include "operator.h"
+
+// The named columns of its child's rows, in the order named; "*" passes
+// batches through unchanged. Names the child lacks are dropped. Columns
+// move between batches whole, and the selection is kept as it is.
+class ProjectionOperator : public Operator {
+public:
+    ProjectionOperator(std::unique_ptr<Operator> child, const std::vector<std::string>& projection_columns);
+    void open() override;
+    bool next(RowBatch& batch) override;
+    void close() override;
+
+private:
+    std::unique_ptr<Operator> child;
+    bool all_columns;
+    std::vector<size_t> positions; // Child column of each output column
+    std::vector<bool> reused; // Whether a later output column reads the same child column
+    RowBatch input;
+};
+
+#endif
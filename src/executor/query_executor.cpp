@@ -3,14 +3,68 @@
 #include <vector>
 #include "../common/value.h"
 #include <algorithm>
+#include "seq_scan_operator.h"
+#include "gather_operator.h"
+#include "index_scan_operator.h"
+#include "filter_operator.h"
+#include "hash_aggregate_operator.h"
+#include "hash_join_operator.h"
+#include "nested_loop_join_operator.h"
+#include "index_nested_loop_join_operator.h"
+#include "projection_operator.h"
+#include "sort_operator.h"
+#include "limit_operator.h"
 
-// Helper to print a Value
-void print_value(const Value& val) {
-    std::cout << to_string(val);
+std::unique_ptr<Operator> build_operator(const std::shared_ptr<LogicalPlanNode>& plan, const ExecContext& ctx) {
+    switch (plan->type) {
+        case LogicalOperatorType::SEQ_SCAN:
+        case LogicalOperatorType::INDEX_SCAN: {
+            std::unique_ptr<Operator> scan;
+            int workers = plan->type == LogicalOperatorType::SEQ_SCAN
+                ? parallel_scan_workers(ctx.storage.page_count(plan->table_name), ctx.settings.max_parallel_workers) : 0;
+            if (plan->type == LogicalOperatorType::INDEX_SCAN) {
+                scan = std::make_unique<IndexScanOperator>(ctx, plan->table_name, plan->index_name, plan->conditions, plan->index_only);
+            } else if (workers >= 2) {
+                scan = std::make_unique<GatherOperator>(ctx, plan->table_name, plan->conditions, plan->scan_columns, workers);
+            } else {
+                scan = std::make_unique<SeqScanOperator>(ctx, plan->table_name, plan->conditions, plan->scan_columns);
+            }
+            if (!plan->alias.empty()) {
+                scan->qualify_columns(plan->alias);
+            }
+            return scan;
+        }
+        case LogicalOperatorType::JOIN: {
+            std::unique_ptr<Operator> left = build_operator(plan->children[0], ctx);
+            if (plan->join_method == JoinMethod::INDEX_NESTED_LOOP) {
+                const auto& inner = plan->children[1];
+                return std::make_unique<IndexNestedLoopJoinOperator>(ctx, std::move(left), inner->table_name, inner->alias, plan->index_name,
+                                                                     inner->conditions, plan->join_conditions);
+            }
+            std::unique_ptr<Operator> right = build_operator(plan->children[1], ctx);
+            if (plan->join_method == JoinMethod::HASH) {
+                return std::make_unique<HashJoinOperator>(std::move(left), std::move(right), plan->join_conditions, ctx.settings.work_mem);
+            }
+            return std::make_unique<NestedLoopJoinOperator>(std::move(left), std::move(right), plan->join_conditions, ctx.settings.work_mem);
+        }
+        case LogicalOperatorType::FILTER:
+            return std::make_unique<FilterOperator>(build_operator(plan->children[0], ctx), plan->conditions);
+        case LogicalOperatorType::AGGREGATE:
+            return std::make_unique<HashAggregateOperator>(build_operator(plan->children[0], ctx), plan->group_by, plan->aggregates, ctx.settings.work_mem);
+        case LogicalOperatorType::SORT:
+            return std::make_unique<SortOperator>(build_operator(plan->children[0], ctx), plan->sort_keys, plan->limit, ctx.settings.work_mem);
+        case LogicalOperatorType::PROJECTION:
+            return std::make_unique<ProjectionOperator>(build_operator(plan->children[0], ctx), plan->projection_columns);
+        case LogicalOperatorType::LIMIT:
+            return std::make_unique<LimitOperator>(build_operator(plan->children[0], ctx), plan->limit);
+        default:
+            throw std::runtime_error("Not a query operator");
+    }
 }
 
-ResultSet execute_plan(std::shared_ptr<LogicalPlanNode> plan, StorageEngine& storage, TransactionManager& tx_manager, int tx_id, const std::map<int, int>& snapshot) {
-    if (!plan) return {};
+void execute_plan(std::shared_ptr<LogicalPlanNode> plan, StorageEngine& storage, TransactionManager& tx_manager, int tx_id, const Snapshot& snapshot,
+                  const Settings& settings, ResultSink& sink) {
+    if (!plan) return;
 
     int cid = 0;
     if (tx_id != 0) {
@@ -20,31 +74,34 @@ ResultSet execute_plan(std::shared_ptr<LogicalPlanNode> plan, StorageEngine& sto
     switch (plan->type) {
         case LogicalOperatorType::CREATE_TABLE: {
             if (plan->table_name == "BEGIN" || plan->table_name == "COMMIT" || plan->table_name == "ROLLBACK") {
-                 std::cout << plan->table_name << std::endl;
+                 std::cout << plan->table_name << '\n';
             } else {
                 if (!tx_manager.lock_table(tx_id, plan->table_name, LockMode::EXCLUSIVE)) {
                     throw std::runtime_error("Failed to acquire exclusive lock for CREATE TABLE.");
                 }
                 storage.create_table(plan->table_name, plan->columns, tx_id, cid);
-                std::cout << "Table created." << std::endl;
+                std::cout << "Table created.\n";
             }
-            return {};
+            return;
         }
         case LogicalOperatorType::INSERT: {
-            if (!tx_manager.lock_table(tx_id, plan->table_name, LockMode::EXCLUSIVE)) {
-                throw std::runtime_error("Failed to acquire exclusive lock for INSERT.");
+            // Rows are new and invisible to others, so only announce the intent
+            if (!tx_manager.lock_table(tx_id, plan->table_name, LockMode::INTENTION_EXCLUSIVE)) {
+                throw std::runtime_error("Failed to acquire intention exclusive lock for INSERT.");
             }
             
             int rows_inserted = 0;
             
             // Handle multi-row INSERT
             if (!plan->multi_values.empty()) {
+                std::vector<Record> records;
                 for (const auto& row_values : plan->multi_values) {
                     Record rec{tx_id, 0, cid, {}};
                     rec.columns = row_values;
-                    storage.insert_record(plan->table_name, rec, tx_id, cid);
+                    records.push_back(rec);
                     rows_inserted++;
                 }
+                storage.insert_records(plan->table_name, records, tx_id, cid);
             } else {
                 // Fallback to single-row INSERT for backward compatibility
                 Record rec{tx_id, 0, cid, {}};
@@ -53,165 +110,70 @@ ResultSet execute_plan(std::shared_ptr<LogicalPlanNode> plan, StorageEngine& sto
                 rows_inserted = 1;
             }
             
-            std::cout << rows_inserted << " row(s) inserted." << std::endl;
-            return {};
+            std::cout << rows_inserted << " row(s) inserted.\n";
+            return;
         }
-        case LogicalOperatorType::SEQ_SCAN: {
-            if (!tx_manager.lock_table(tx_id, plan->table_name, LockMode::SHARED)) {
-                throw std::runtime_error("Failed to acquire shared lock for SELECT.");
-            }
-            auto records = storage.scan_table(plan->table_name, tx_id, cid, snapshot, tx_manager);
-            const auto& table_cols = storage.get_table_metadata(plan->table_name);
-            
-            ResultSet rs;
-            for(const auto& col : table_cols) {
-                rs.columns.push_back(col.name);
+        case LogicalOperatorType::SEQ_SCAN:
+        case LogicalOperatorType::INDEX_SCAN:
+        case LogicalOperatorType::FILTER:
+        case LogicalOperatorType::JOIN:
+        case LogicalOperatorType::AGGREGATE:
+        case LogicalOperatorType::SORT:
+        case LogicalOperatorType::PROJECTION:
+        case LogicalOperatorType::LIMIT: {
+            ExecContext ctx{storage, tx_manager, tx_id, cid, snapshot, settings};
+            std::unique_ptr<Operator> root = build_operator(plan, ctx);
+            sink.begin(root->columns(), root->types());
+            root->open();
+            RowBatch batch;
+            while (root->next(batch)) {
+                sink.batch(batch);
             }
-            for (const auto& rec : records) {
-                rs.rows.push_back(rec.columns);
-            }
-            return rs;
-        }
-        case LogicalOperatorType::FILTER: {
-            auto child_rs = execute_plan(plan->children[0], storage, tx_manager, tx_id, snapshot);
-            ResultSet rs;
-            rs.columns = child_rs.columns;
-            
-            for (const auto& row : child_rs.rows) {
-                bool row_matches = true;
-                
-                // Check all WHERE conditions
-                for (const auto& condition : plan->conditions) {
-                    bool condition_met = false;
-                    
-                    // Find the column index
-                    int col_index = -1;
-                    for (size_t i = 0; i < rs.columns.size(); ++i) {
-                        if (rs.columns[i] == condition.column) {
-                            col_index = i;
-                            break;
-                        }
-                    }
-                    
-                    if (col_index == -1) {
-                        throw std::runtime_error("Column '" + condition.column + "' not found in result set");
-                    }
-                    
-                    // Apply the condition
-                    const Value& col_value = row[col_index];
-                    const Value& filter_value = condition.value;
-                    
-                    if (condition.op == "=") {
-                        condition_met = (col_value.type == filter_value.type) &&
-                                       ((col_value.type == DataType::INT && col_value.int_value == filter_value.int_value) ||
-                                        (col_value.type == DataType::STRING && col_value.str_value == filter_value.str_value));
-                    } else if (condition.op == "!=") {
-                        condition_met = (col_value.type != filter_value.type) ||
-                                       ((col_value.type == DataType::INT && col_value.int_value != filter_value.int_value) ||
-                                        (col_value.type == DataType::STRING && col_value.str_value != filter_value.str_value));
-                    } else if (condition.op == "<") {
-                        if (col_value.type == DataType::INT && filter_value.type == DataType::INT) {
-                            condition_met = col_value.int_value < filter_value.int_value;
-                        } else if (col_value.type == DataType::STRING && filter_value.type == DataType::STRING) {
-                            condition_met = col_value.str_value < filter_value.str_value;
-                        }
-                    } else if (condition.op == ">") {
-                        if (col_value.type == DataType::INT && filter_value.type == DataType::INT) {
-                            condition_met = col_value.int_value > filter_value.int_value;
-                        } else if (col_value.type == DataType::STRING && filter_value.type == DataType::STRING) {
-                            condition_met = col_value.str_value > filter_value.str_value;
-                        }
-                    } else if (condition.op == "<=") {
-                        if (col_value.type == DataType::INT && filter_value.type == DataType::INT) {
-                            condition_met = col_value.int_value <= filter_value.int_value;
-                        } else if (col_value.type == DataType::STRING && filter_value.type == DataType::STRING) {
-                            condition_met = col_value.str_value <= filter_value.str_value;
-                        }
-                    } else if (condition.op == ">=") {
-                        if (col_value.type == DataType::INT && filter_value.type == DataType::INT) {
-                            condition_met = col_value.int_value >= filter_value.int_value;
-                        } else if (col_value.type == DataType::STRING && filter_value.type == DataType::STRING) {
-                            condition_met = col_value.str_value >= filter_value.str_value;
-                        }
-                    } else if (condition.op == "LIKE") {
-                        if (col_value.type == DataType::STRING && filter_value.type == DataType::STRING) {
-                            // Simple LIKE implementation (contains)
-                            condition_met = col_value.str_value.find(filter_value.str_value) != std::string::npos;
-                        }
-                    }
-                    
-                    if (!condition_met) {
-                        row_matches = false;
-                        break; // AND logic: if any condition fails, the row doesn't match
-                    }
-                }
-                
-                if (row_matches) {
-                    rs.rows.push_back(row);
-                }
-            }
-            return rs;
-        }
-        case LogicalOperatorType::PROJECTION: {
-            auto child_rs = execute_plan(plan->children[0], storage, tx_manager, tx_id, snapshot);
-            ResultSet rs;
-            
-            // Handle wildcard projection (SELECT *)
-            if (plan->projection_columns.size() == 1 && plan->projection_columns[0] == "*") {
-                // Return all columns
-                return child_rs;
-            }
-            
-            // Handle specific column projection
-            std::vector<int> proj_indices;
-            for (const auto& proj_col : plan->projection_columns) {
-                for (size_t i = 0; i < child_rs.columns.size(); ++i) {
-                    if (child_rs.columns[i] == proj_col) {
-                        rs.columns.push_back(proj_col);
-                        proj_indices.push_back(i);
-                        break;
-                    }
-                }
-            }
-            for (const auto& row : child_rs.rows) {
-                std::vector<Value> new_row;
-                for (int idx : proj_indices) {
-                    new_row.push_back(row[idx]);
-                }
-                rs.rows.push_back(new_row);
-            }
-            return rs;
+            root->close();
+            sink.end();
+            return;
         }
         case LogicalOperatorType::UPDATE: {
-            if (!tx_manager.lock_table(tx_id, plan->table_name, LockMode::EXCLUSIVE)) {
-                throw std::runtime_error("Failed to acquire exclusive lock for UPDATE.");
+            // Individual rows are locked through their xmax by the storage engine
+            if (!tx_manager.lock_table(tx_id, plan->table_name, LockMode::INTENTION_EXCLUSIVE)) {
+                throw std::runtime_error("Failed to acquire intention exclusive lock for UPDATE.");
             }
             int updated_rows = storage.update_records(plan->table_name, plan->conditions, plan->set_clause, tx_id, cid, snapshot, tx_manager);
-            std::cout << updated_rows << " row(s) updated." << std::endl;
-            return {};
+            std::cout << updated_rows << " row(s) updated.\n";
+            return;
         }
         case LogicalOperatorType::DELETE: {
-            if (!tx_manager.lock_table(tx_id, plan->table_name, LockMode::EXCLUSIVE)) {
-                throw std::runtime_error("Failed to acquire exclusive lock for DELETE.");
+            // Individual rows are locked through their xmax by the storage engine
+            if (!tx_manager.lock_table(tx_id, plan->table_name, LockMode::INTENTION_EXCLUSIVE)) {
+                throw std::runtime_error("Failed to acquire intention exclusive lock for DELETE.");
             }
             int deleted_rows = storage.delete_records(plan->table_name, plan->conditions, tx_id, cid, snapshot, tx_manager);
-            std::cout << deleted_rows << " row(s) deleted." << std::endl;
-            return {};
+            std::cout << deleted_rows << " row(s) deleted.\n";
+            return;
         }
         case LogicalOperatorType::CREATE_INDEX: {
-            storage.create_index(plan->index_name, plan->table_name, plan->index_column);
-            std::cout << "Index created." << std::endl;
-            return {};
+            IndexType type = plan->index_method == "HASH" ? IndexType::HASH : IndexType::BTREE;
+            storage.create_index(plan->index_name, plan->table_name, plan->index_columns, plan->include_columns, type, plan->fill_factor, tx_id, cid);
+            std::cout << "Index created.\n";
+            return;
         }
         case LogicalOperatorType::DROP_TABLE: {
             storage.drop_table(plan->table_name);
-            std::cout << "Table dropped." << std::endl;
-            return {};
+            std::cout << "Table dropped.\n";
+            return;
         }
         case LogicalOperatorType::DROP_INDEX: {
-            storage.drop_index(plan->index_name);
-            std::cout << "Index dropped." << std::endl;
-            return {};
+            storage.drop_index(plan->index_name, tx_id, cid, snapshot, tx_manager);
+            std::cout << "Index dropped.\n";
+            return;
+        }
+        case LogicalOperatorType::VACUUM: {
+            std::vector<std::string> tables = plan->table_name.empty() ? storage.table_names() : std::vector<std::string>{plan->table_name};
+            for (const auto& table_name : tables) {
+                storage.vacuum_table(table_name, tx_manager);
+            }
+            std::cout << "VACUUM\n";
+            return;
         }
         default: {
             throw std::runtime_error("Unsupported logical operator");
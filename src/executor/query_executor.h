@@ -4,14 +4,16 @@
 #include "../optimizer/plan_generator.h"
 #include "../storage/storage_engine.h"
 #include "../transaction/transaction_manager.h"
+#include "operator.h"
+#include "result_sink.h"
 #include <map>
 #include <vector>
+#include <memory>
 
-struct ResultSet {
-    std::vector<std::string> columns;
-    std::vector<std::vector<Value>> rows;
-};
-
-ResultSet execute_plan(std::shared_ptr<LogicalPlanNode> plan, StorageEngine& storage, TransactionManager& tx_manager, int tx_id, const std::map<int, int>& snapshot);
+// Statements other than queries report to stdout and leave sink untouched
+void execute_plan(std::shared_ptr<LogicalPlanNode> plan, StorageEngine& storage, TransactionManager& tx_manager, int tx_id, const Snapshot& snapshot,
+                  const Settings& settings, ResultSink& sink);
+// Physical operator tree of a query plan
+std::unique_ptr<Operator> build_operator(const std::shared_ptr<LogicalPlanNode>& plan, const ExecContext& ctx);
 
 #endif
\ No newline at end of file
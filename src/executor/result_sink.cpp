@@ -0,0 +1,276 @@
+#include "result_sink.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+
+OutputBuffer::OutputBuffer(std::ostream& out) : out(out), buffer(OUTPUT_BUFFER_SIZE) {}
+
+OutputBuffer::~OutputBuffer() {
+    flush();
+}
+
+void OutputBuffer::write(std::string_view text) {
+    while (!text.empty()) {
+        if (used == buffer.size()) flush();
+        size_t count = std::min(text.size(), buffer.size() - used);
+        std::copy(text.begin(), text.begin() + count, buffer.begin() + used);
+        used += count;
+        text.remove_prefix(count);
+    }
+}
+
+void OutputBuffer::write_int(int value) {
+    char digits[16];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    write(std::string_view(digits, result.ptr - digits));
+}
+
+void OutputBuffer::flush() {
+    if (used > 0) {
+        out.write(buffer.data(), static_cast<std::streamsize>(used));
+        used = 0;
+    }
+}
+
+namespace {
+
+size_t int_width(int value) {
+    char digits[16];
+    return static_cast<size_t>(std::to_chars(digits, digits + sizeof(digits), value).ptr - digits);
+}
+
+void write_value(OutputBuffer& out, const ColumnVector& column, uint32_t row) {
+    if (column.type == DataType::INT) {
+        out.write_int(column.ints[row]);
+    } else {
+        out.write(column.string_at(row));
+    }
+}
+
+// Each value followed by a tab, NULL written out, as the shell has always
+// printed results
+class TsvSink : public ResultSink {
+public:
+    explicit TsvSink(OutputBuffer& out) : out(out) {}
+
+    void begin(const std::vector<std::string>& columns, const std::vector<DataType>&) override {
+        for (const auto& column : columns) {
+            out.write(column);
+            out.put('\t');
+        }
+        out.put('\n');
+    }
+
+    void batch(const RowBatch& batch) override {
+        for (uint32_t row : batch.selection) {
+            for (const auto& column : batch.columns) {
+                if (column.nulls[row]) {
+                    out.write("NULL");
+                } else {
+                    write_value(out, column, row);
+                }
+                out.put('\t');
+            }
+            out.put('\n');
+        }
+    }
+
+    void end() override { out.flush(); }
+
+private:
+    OutputBuffer& out;
+};
+
+class CsvSink : public ResultSink {
+public:
+    explicit CsvSink(OutputBuffer& out) : out(out) {}
+
+    void begin(const std::vector<std::string>& columns, const std::vector<DataType>&) override {
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (i > 0) out.put(',');
+            write_field(columns[i]);
+        }
+        out.write("\r\n");
+    }
+
+    void batch(const RowBatch& batch) override {
+        for (uint32_t row : batch.selection) {
+            for (size_t i = 0; i < batch.columns.size(); ++i) {
+                const ColumnVector& column = batch.columns[i];
+                if (i > 0) out.put(',');
+                if (column.nulls[row]) continue;
+                if (column.type == DataType::INT) {
+                    out.write_int(column.ints[row]);
+                } else {
+                    write_field(column.string_at(row)); // Quoted when empty, unlike NULL
+                }
+            }
+            out.write("\r\n");
+        }
+    }
+
+    void end() override { out.flush(); }
+
+private:
+    OutputBuffer& out;
+
+    // Quoted, with quotes doubled, when it holds a separator, a quote or a
+    // line break, or is empty and so would read as NULL
+    void write_field(std::string_view text) {
+        if (!text.empty() && text.find_first_of(",\"\r\n") == std::string_view::npos) {
+            out.write(text);
+            return;
+        }
+        out.put('"');
+        for (char c : text) {
+            if (c == '"') out.put('"');
+            out.put(c);
+        }
+        out.put('"');
+    }
+};
+
+// Widths are set by the header and the first batch, so rows can go out as
+// they come; a later, wider value pushes its row out of line
+class AlignedSink : public ResultSink {
+public:
+    explicit AlignedSink(OutputBuffer& out) : out(out) {}
+
+    void begin(const std::vector<std::string>& columns, const std::vector<DataType>& types) override {
+        names = columns;
+        this->types = types;
+        widths.clear();
+        for (const auto& name : names) {
+            widths.push_back(name.size());
+        }
+        header_written = false;
+        rows = 0;
+    }
+
+    void batch(const RowBatch& batch) override {
+        if (!header_written) {
+            for (uint32_t row : batch.selection) {
+                for (size_t i = 0; i < batch.columns.size(); ++i) {
+                    widths[i] = std::max(widths[i], value_width(batch.columns[i], row));
+                }
+            }
+            write_header();
+        }
+        for (uint32_t row : batch.selection) {
+            for (size_t i = 0; i < batch.columns.size(); ++i) {
+                const ColumnVector& column = batch.columns[i];
+                out.write(i == 0 ? " " : " | ");
+                size_t padding = widths[i] - std::min(widths[i], value_width(column, row));
+                bool right_aligned = types[i] == DataType::INT;
+                if (right_aligned) pad(padding);
+                if (!column.nulls[row]) write_value(out, column, row); // NULL shows as blank
+                if (!right_aligned && i + 1 < batch.columns.size()) pad(padding);
+            }
+            out.put('\n');
+        }
+        rows += batch.selection.size();
+    }
+
+    void end() override {
+        if (!header_written) write_header();
+        out.write("(");
+        out.write(std::to_string(rows));
+        out.write(rows == 1 ? " row)\n" : " rows)\n");
+        out.flush();
+    }
+
+private:
+    OutputBuffer& out;
+    std::vector<std::string> names;
+    std::vector<DataType> types;
+    std::vector<size_t> widths;
+    bool header_written = false;
+    size_t rows = 0;
+
+    static size_t value_width(const ColumnVector& column, uint32_t row) {
+        if (column.nulls[row]) return 0;
+        return column.type == DataType::INT ? int_width(column.ints[row]) : column.string_at(row).size();
+    }
+
+    void pad(size_t count) {
+        for (size_t i = 0; i < count; ++i) out.put(' ');
+    }
+
+    void write_header() {
+        for (size_t i = 0; i < names.size(); ++i) {
+            out.write(i == 0 ? " " : " | ");
+            size_t padding = widths[i] - names[i].size();
+            pad(padding / 2);
+            out.write(names[i]);
+            if (i + 1 < names.size()) pad(padding - padding / 2);
+        }
+        out.put('\n');
+        for (size_t i = 0; i < names.size(); ++i) {
+            out.write(i == 0 ? "-" : "-+-");
+            for (size_t j = 0; j < widths[i]; ++j) out.put('-');
+        }
+        out.write("-\n");
+        header_written = true;
+    }
+};
+
+// Big-endian throughout. A header of the column count (uint16), then per
+// column its type (uint8: 0 NULL, 1 INT, 2 STRING) and name; a row is its
+// field count (int16) and per field a length (int32, -1 for NULL) and the
+// bytes, 4 for an INT. A field count of -1 ends the result.
+class BinarySink : public ResultSink {
+public:
+    explicit BinarySink(OutputBuffer& out) : out(out) {}
+
+    void begin(const std::vector<std::string>& columns, const std::vector<DataType>& types) override {
+        write_uint(columns.size(), 2);
+        for (size_t i = 0; i < columns.size(); ++i) {
+            out.put(static_cast<char>(types[i] == DataType::INT ? 1 : types[i] == DataType::STRING ? 2 : 0));
+            write_uint(columns[i].size(), 4);
+            out.write(columns[i]);
+        }
+    }
+
+    void batch(const RowBatch& batch) override {
+        for (uint32_t row : batch.selection) {
+            write_uint(batch.columns.size(), 2);
+            for (const auto& column : batch.columns) {
+                if (column.nulls[row]) {
+                    write_uint(UINT32_MAX, 4);
+                } else if (column.type == DataType::INT) {
+                    write_uint(4, 4);
+                    write_uint(static_cast<uint32_t>(column.ints[row]), 4);
+                } else {
+                    std::string_view text = column.string_at(row);
+                    write_uint(text.size(), 4);
+                    out.write(text);
+                }
+            }
+        }
+    }
+
+    void end() override {
+        write_uint(UINT16_MAX, 2);
+        out.flush();
+    }
+
+private:
+    OutputBuffer& out;
+
+    void write_uint(uint64_t value, int bytes) {
+        for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+            out.put(static_cast<char>((value >> shift) & 0xff));
+        }
+    }
+};
+
+} // namespace
+
+std::unique_ptr<ResultSink> make_result_sink(OutputFormat format, OutputBuffer& out) {
+    switch (format) {
+        case OutputFormat::CSV: return std::make_unique<CsvSink>(out);
+        case OutputFormat::ALIGNED: return std::make_unique<AlignedSink>(out);
+        case OutputFormat::BINARY: return std::make_unique<BinarySink>(out);
+        default: return std::make_unique<TsvSink>(out);
+    }
+}
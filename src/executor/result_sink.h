@@ -0,0 +1,50 @@
+#ifndef RESULT_SINK_H
+#define RESULT_SINK_H
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "row_batch.h"
+#include "../common/settings.h"
+
+const size_t OUTPUT_BUFFER_SIZE = 1024 * 1024; // Bytes of output gathered before they are handed to the stream
+
+// Gathers output in one large buffer and hands it to a stream a buffer at
+// a time, so printing a result costs a write per megabyte instead of one
+// per row. Output written to the stream directly must wait for flush().
+class OutputBuffer {
+public:
+    explicit OutputBuffer(std::ostream& out);
+    ~OutputBuffer();
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void write(std::string_view text);
+    void put(char c) {
+        if (used == buffer.size()) flush();
+        buffer[used++] = c;
+    }
+    void write_int(int value);
+    void flush(); // Hands what is gathered to the stream
+
+private:
+    std::ostream& out;
+    std::vector<char> buffer;
+    size_t used = 0;
+};
+
+// Receives a query's result as the operators produce it, batch by batch,
+// and writes it out in one of the output formats
+class ResultSink {
+public:
+    virtual ~ResultSink() = default;
+    virtual void begin(const std::vector<std::string>& columns, const std::vector<DataType>& types) = 0;
+    virtual void batch(const RowBatch& batch) = 0; // The selected rows
+    virtual void end() = 0; // Flushes the output
+};
+
+std::unique_ptr<ResultSink> make_result_sink(OutputFormat format, OutputBuffer& out);
+
+#endif
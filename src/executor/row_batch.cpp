@@ -0,0 +1,99 @@
+#include "row_batch.h"
+#include <new>
+
+void ColumnVector::clear() {
+    ints.clear();
+    bytes.clear();
+    offsets.assign(1, 0);
+    nulls.clear();
+    has_nulls = false;
+}
+
+void ColumnVector::append(const Value& value) {
+    append(view_of(value));
+}
+
+void ColumnVector::append(const ValueView& value) {
+    bool null = value.type != type; // Short records read NULL for columns added later
+    nulls.push_back(null);
+    has_nulls |= null;
+    if (type == DataType::INT) {
+        ints.push_back(null ? 0 : value.int_value);
+    } else {
+        if (!null) bytes += value.str_value;
+        offsets.push_back(static_cast<uint32_t>(bytes.size()));
+    }
+}
+
+Value ColumnVector::value_at(uint32_t row) const {
+    if (nulls[row]) {
+        return Value();
+    }
+    if (type == DataType::INT) {
+        return Value(ints[row]);
+    }
+    return Value(std::string(string_at(row)));
+}
+
+void RowBatch::reset(const std::vector<DataType>& types) {
+    columns.resize(types.size());
+    for (size_t i = 0; i < types.size(); ++i) {
+        columns[i].type = types[i];
+        columns[i].clear();
+    }
+    size = 0;
+    selection.clear();
+}
+
+void RowBatch::append(const std::vector<Value>& row) {
+    for (size_t i = 0; i < columns.size(); ++i) {
+        columns[i].append(i < row.size() ? row[i] : Value());
+    }
+    selection.push_back(static_cast<uint32_t>(size++));
+}
+
+void RowBatch::row(uint32_t row_index, std::vector<Value>& values) const {
+    values.resize(columns.size());
+    for (size_t i = 0; i < columns.size(); ++i) {
+        values[i] = columns[i].value_at(row_index);
+    }
+}
+
+void RowBatch::append(const ValueView* row) {
+    for (size_t i = 0; i < columns.size(); ++i) {
+        columns[i].append(row[i]);
+    }
+    selection.push_back(static_cast<uint32_t>(size++));
+}
+
+ValueView* RowBatch::copy_row(uint32_t row_index, Arena& arena) const {
+    ValueView* row = arena.allocate_array<ValueView>(columns.size());
+    for (size_t i = 0; i < columns.size(); ++i) {
+        const ColumnVector& column = columns[i];
+        ValueView* value = new (&row[i]) ValueView();
+        if (column.nulls[row_index]) continue;
+        value->type = column.type;
+        if (column.type == DataType::INT) {
+            value->int_value = column.ints[row_index];
+        } else {
+            value->str_value = arena.copy(column.string_at(row_index));
+        }
+    }
+    return row;
+}
+
+ValueView* copy_row(const std::vector<Value>& values, Arena& arena) {
+    ValueView* row = arena.allocate_array<ValueView>(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        new (&row[i]) ValueView{values[i].type, values[i].int_value, arena.copy(values[i].str_value)};
+    }
+    return row;
+}
+
+ValueView* copy_row(const ValueView* values, size_t width, Arena& arena) {
+    ValueView* row = arena.allocate_array<ValueView>(width);
+    for (size_t i = 0; i < width; ++i) {
+        new (&row[i]) ValueView{values[i].type, values[i].int_value, arena.copy(values[i].str_value)};
+    }
+    return row;
+}
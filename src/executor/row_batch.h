@@ -0,0 +1,58 @@
+#ifndef ROW_BATCH_H
+#define ROW_BATCH_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "../common/value.h"
+#include "../common/arena.h"
+
+const size_t BATCH_SIZE = 1024; // Rows an operator hands on per next()
+
+// One column of a batch, stored by its declared type: INT values in a plain
+// array the filter kernels can load with SIMD, STRING values back to back in
+// one buffer with an offset per row. NULLs hold 0 or "" and are flagged.
+struct ColumnVector {
+    DataType type = DataType::NULL_TYPE;
+    std::vector<int32_t> ints;
+    std::string bytes;
+    std::vector<uint32_t> offsets = {0}; // Row i of a STRING column is bytes[offsets[i], offsets[i + 1])
+    std::vector<uint8_t> nulls;
+    bool has_nulls = false;
+
+    void clear();
+    void append(const Value& value);
+    void append(const ValueView& value);
+    std::string_view string_at(uint32_t row) const {
+        return std::string_view(bytes.data() + offsets[row], offsets[row + 1] - offsets[row]);
+    }
+    Value value_at(uint32_t row) const;
+};
+
+// Rows of an operator's output, column by column. Only the rows listed in
+// selection, in ascending order, are part of the result; a filter narrows
+// the selection instead of moving the surviving values.
+struct RowBatch {
+    std::vector<ColumnVector> columns;
+    size_t size = 0; // Rows held, selected or not
+    std::vector<uint32_t> selection;
+
+    // Empties the batch for columns of the given types
+    void reset(const std::vector<DataType>& types);
+    // Appends a row and selects it
+    void append(const std::vector<Value>& row);
+    void append(const ValueView* row); // One value per column
+    // Selected rows as values, in order
+    void row(uint32_t row_index, std::vector<Value>& values) const;
+    // A row as views placed in arena, its strings copied there too
+    ValueView* copy_row(uint32_t row_index, Arena& arena) const;
+    bool full() const { return size >= BATCH_SIZE; }
+    bool all_selected() const { return selection.size() == size; }
+};
+
+// values as views placed in arena, their strings copied there too
+ValueView* copy_row(const std::vector<Value>& values, Arena& arena);
+ValueView* copy_row(const ValueView* values, size_t width, Arena& arena);
+
+#endif
@@ -0,0 +1,48 @@
+#include "seq_scan_operator.h"
+#include "../transaction/transaction_manager.h"
+#include <stdexcept>
+#include <algorithm>
+
+ScanFilter make_scan_filter(StorageEngine& storage, const std::string& table_name, const std::vector<WhereCondition>& conditions,
+                            const std::vector<std::string>& columns, std::vector<std::string>& output_columns,
+                            std::vector<DataType>& output_types) {
+    const auto& table_cols = storage.get_table_metadata(table_name);
+    ScanFilter filter;
+    std::vector<std::string> names;
+    output_columns.clear();
+    output_types.clear();
+    for (size_t i = 0; i < table_cols.size(); ++i) {
+        const Column& col = table_cols[i];
+        names.push_back(col.name);
+        if (columns.empty() || std::find(columns.begin(), columns.end(), col.name) != columns.end()) {
+            filter.columns.push_back(i);
+            output_columns.push_back(col.name);
+            output_types.push_back(col.type);
+        }
+    }
+    filter.predicate = Predicate(conditions, names);
+    return filter;
+}
+
+SeqScanOperator::SeqScanOperator(const ExecContext& ctx, const std::string& table_name, const std::vector<WhereCondition>& conditions,
+                                 const std::vector<std::string>& columns)
+    : ctx(ctx), table_name(table_name),
+      filter(make_scan_filter(ctx.storage, table_name, conditions, columns, output_columns, output_types)) {}
+
+void SeqScanOperator::open() {
+    // MVCC readers never block row writers; IS only fences off DDL.
+    // Read-only statements run without an xid and skip even that.
+    if (ctx.tx_id != 0 && !ctx.tx_manager.lock_table(ctx.tx_id, table_name, LockMode::INTENTION_SHARED)) {
+        throw std::runtime_error("Failed to acquire intention shared lock for SELECT.");
+    }
+    position = ScanPosition();
+}
+
+bool SeqScanOperator::next(RowBatch& batch) {
+    batch.reset(output_types);
+    while (!batch.full() && ctx.storage.scan_page(table_name, ctx.tx_id, ctx.cid, ctx.snapshot, ctx.tx_manager, filter, position, batch)) {
+    }
+    return batch.size > 0;
+}
+
+void SeqScanOperator::close() {}
@@ -0,0 +1,32 @@
+#ifndef SEQ_SCAN_OPERATOR_H
+#define SEQ_SCAN_OPERATOR_H
+
+#include "operator.h"
+#include "../storage/storage_engine.h"
+
+// Filter of a scan of table_name that reads columns, or every column when
+// empty; sets the names and types of the columns the scan outputs
+ScanFilter make_scan_filter(StorageEngine& storage, const std::string& table_name, const std::vector<WhereCondition>& conditions,
+                            const std::vector<std::string>& columns, std::vector<std::string>& output_columns,
+                            std::vector<DataType>& output_types);
+
+// Visible rows of a table in heap order, read a page at a time and handed
+// on in batches. The conditions are tested by the storage engine on the
+// page bytes, and only the requested columns are decoded, in table order.
+class SeqScanOperator : public Operator {
+public:
+    // An empty column list reads every column
+    SeqScanOperator(const ExecContext& ctx, const std::string& table_name, const std::vector<WhereCondition>& conditions,
+                    const std::vector<std::string>& columns);
+    void open() override;
+    bool next(RowBatch& batch) override;
+    void close() override;
+
+private:
+    const ExecContext& ctx;
+    std::string table_name;
+    ScanFilter filter;
+    ScanPosition position;
+};
+
+#endif
@@ -0,0 +1,264 @@
+#include "sort_operator.h"
+#include "spill_file.h"
+#include "../index/index_key.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+static bool key_less(std::string_view a, std::string_view b) {
+    return a < b; // Compares as unsigned bytes
+}
+
+static void write_key(std::ofstream& out, std::string_view key) {
+    uint32_t length = static_cast<uint32_t>(key.size());
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(key.data(), length);
+}
+
+SortOperator::SortOperator(std::unique_ptr<Operator> child, const std::vector<OrderItem>& keys, int limit, size_t memory_budget)
+    : child(std::move(child)), limit(limit), memory_budget(memory_budget),
+      fan_in(std::max<size_t>(2, memory_budget / SORT_READ_AHEAD)), read_ahead(std::min(SORT_READ_AHEAD, memory_budget / fan_in)) {
+    output_columns = this->child->columns();
+    output_types = this->child->types();
+    for (const auto& key : keys) {
+        auto col = std::find(output_columns.begin(), output_columns.end(), key.column);
+        if (col == output_columns.end()) {
+            throw std::runtime_error("Column '" + key.column + "' not found in result set");
+        }
+        key_positions.push_back(static_cast<size_t>(col - output_columns.begin()));
+        descending.push_back(key.descending);
+    }
+}
+
+SortOperator::~SortOperator() {
+    remove_runs();
+}
+
+void SortOperator::open() {
+    rows.clear();
+    arena.reset();
+    live_bytes = 0;
+    position = 0;
+    emitted = 0;
+    bounded = limit >= 0;
+    child->open();
+    RowBatch batch;
+    while (limit != 0 && child->next(batch)) {
+        for (uint32_t row_index : batch.selection) {
+            add(batch, row_index);
+        }
+    }
+    child->close();
+    if (run_files.empty()) {
+        std::sort(rows.begin(), rows.end(), [](const SortRow& a, const SortRow& b) { return key_less(a.key, b.key); });
+        return;
+    }
+    if (!rows.empty()) {
+        spill_run();
+    }
+    while (run_files.size() > fan_in) {
+        merge_pass();
+    }
+    start_merge(run_files.size());
+}
+
+bool SortOperator::next(RowBatch& batch) {
+    batch.reset(output_types);
+    while (!batch.full() && (limit < 0 || emitted < limit)) {
+        if (runs.empty()) {
+            if (position == rows.size()) break;
+            batch.append(rows[position++].values);
+        } else {
+            if (heads.empty()) break;
+            std::pop_heap(heads.begin(), heads.end(), head_greater);
+            batch.append(heads.back().values);
+            advance_run();
+        }
+        ++emitted;
+    }
+    return batch.size > 0;
+}
+
+void SortOperator::close() {
+    rows.clear();
+    rows.shrink_to_fit();
+    arena.reset();
+    remove_runs();
+}
+
+// While bounded, a row is kept only if it sorts before the greatest one
+// held, which it replaces once limit rows are held
+void SortOperator::add(const RowBatch& batch, uint32_t row_index) {
+    auto by_key = [](const SortRow& a, const SortRow& b) { return key_less(a.key, b.key); };
+    std::string key = encode_key(batch, row_index);
+    if (bounded && rows.size() == static_cast<size_t>(limit)) {
+        if (!key_less(key, rows.front().key)) {
+            return;
+        }
+        std::pop_heap(rows.begin(), rows.end(), by_key);
+        live_bytes -= row_bytes(rows.back());
+        rows.pop_back();
+    }
+    rows.push_back({arena.copy(key), batch.copy_row(row_index, arena)});
+    live_bytes += row_bytes(rows.back());
+    if (bounded) {
+        std::push_heap(rows.begin(), rows.end(), by_key);
+    }
+    size_t row_array = rows.capacity() * sizeof(SortRow);
+    if (arena.used() + row_array <= memory_budget) {
+        return;
+    }
+    // Rows the heap replaced still fill the arena; if the rows held fit in
+    // half the budget they are moved to a fresh one. A limit too large for
+    // memory is applied on output instead.
+    if (bounded && (live_bytes + row_array) * 2 <= memory_budget) {
+        compact();
+    } else {
+        bounded = false;
+        spill_run();
+    }
+}
+
+// Index key encoding is order-preserving and prefix-free per column, so
+// inverting a column's bytes reverses its order without disturbing the
+// columns after it. NULLs sort last, and first when descending.
+std::string SortOperator::encode_key(const RowBatch& batch, uint32_t row_index) const {
+    std::string key;
+    std::vector<Value> column(1);
+    for (size_t i = 0; i < key_positions.size(); ++i) {
+        column[0] = batch.columns[key_positions[i]].value_at(row_index);
+        size_t start = key.size();
+        key += encode_index_key(column, KeyFormat::BYTES);
+        if (descending[i]) {
+            for (size_t j = start; j < key.size(); ++j) {
+                key[j] = static_cast<char>(~key[j]);
+            }
+        }
+    }
+    return key;
+}
+
+size_t SortOperator::row_bytes(const SortRow& row) const {
+    size_t bytes = row.key.size() + output_types.size() * sizeof(ValueView);
+    for (size_t i = 0; i < output_types.size(); ++i) {
+        bytes += row.values[i].str_value.size();
+    }
+    return bytes;
+}
+
+void SortOperator::compact() {
+    Arena fresh;
+    for (auto& row : rows) {
+        row.key = fresh.copy(row.key);
+        row.values = copy_row(row.values, output_types.size(), fresh);
+    }
+    arena = std::move(fresh);
+}
+
+void SortOperator::spill_run() {
+    std::sort(rows.begin(), rows.end(), [](const SortRow& a, const SortRow& b) { return key_less(a.key, b.key); });
+    std::string file = new_spill_file("sort");
+    run_files.push_back(file);
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Could not create sort run file: " + file);
+    }
+    for (const auto& row : rows) {
+        write_key(out, row.key);
+        for (size_t i = 0; i < output_types.size(); ++i) {
+            write_value(out, row.values[i]);
+        }
+    }
+    out.close();
+    if (out.fail()) {
+        throw std::runtime_error("Could not write sort run file: " + file);
+    }
+    rows.clear();
+    arena.reset();
+    live_bytes = 0;
+}
+
+void SortOperator::start_merge(size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        run_buffers.push_back(std::make_unique<char[]>(read_ahead));
+        runs.push_back(std::make_unique<std::ifstream>());
+        runs[i]->rdbuf()->pubsetbuf(run_buffers[i].get(), read_ahead); // Before open to take effect
+        runs[i]->open(run_files[i], std::ios::binary);
+        if (!*runs[i]) {
+            throw std::runtime_error("Could not open sort run file: " + run_files[i]);
+        }
+        RunHead head{std::string(), {}, i};
+        if (read_row(*runs[i], head)) {
+            heads.push_back(std::move(head));
+        }
+    }
+    std::make_heap(heads.begin(), heads.end(), head_greater);
+}
+
+void SortOperator::merge_pass() {
+    start_merge(fan_in);
+    std::string file = new_spill_file("sort");
+    run_files.push_back(file);
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Could not create sort run file: " + file);
+    }
+    while (!heads.empty()) {
+        std::pop_heap(heads.begin(), heads.end(), head_greater);
+        write_key(out, heads.back().key);
+        for (const auto& value : heads.back().values) {
+            write_value(out, value);
+        }
+        advance_run();
+    }
+    out.close();
+    if (out.fail()) {
+        throw std::runtime_error("Could not write sort run file: " + file);
+    }
+    close_runs();
+    for (size_t i = 0; i < fan_in; ++i) {
+        std::remove(run_files[i].c_str());
+    }
+    run_files.erase(run_files.begin(), run_files.begin() + fan_in);
+}
+
+bool SortOperator::head_greater(const RunHead& a, const RunHead& b) {
+    return key_less(b.key, a.key);
+}
+
+void SortOperator::advance_run() {
+    RunHead& head = heads.back();
+    if (read_row(*runs[head.run], head)) {
+        std::push_heap(heads.begin(), heads.end(), head_greater);
+    } else {
+        heads.pop_back();
+    }
+}
+
+bool SortOperator::read_row(std::ifstream& in, RunHead& head) const {
+    uint32_t length;
+    if (!in.read(reinterpret_cast<char*>(&length), sizeof(length))) {
+        return false;
+    }
+    head.key.resize(length);
+    in.read(&head.key[0], length);
+    head.values.resize(output_types.size());
+    for (auto& value : head.values) {
+        if (!read_value(in, value)) return false;
+    }
+    return true;
+}
+
+void SortOperator::close_runs() {
+    heads.clear();
+    runs.clear();
+    run_buffers.clear();
+}
+
+void SortOperator::remove_runs() {
+    close_runs();
+    for (const auto& file : run_files) {
+        std::remove(file.c_str());
+    }
+    run_files.clear();
+}
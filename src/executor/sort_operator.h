@@ -0,0 +1,73 @@
+#ifndef SORT_OPERATOR_H
+#define SORT_OPERATOR_H
+
+#include <fstream>
+#include <memory>
+#include "operator.h"
+#include "../parser/sql_parser.h"
+
+const size_t SORT_READ_AHEAD = 256 * 1024; // Largest read buffer of each run during a merge
+
+// Orders its child's rows, read in full in open(). Each row gets a
+// normalized key, its sort columns encoded so that keys compare bytewise
+// in the order wanted, and the rows are sorted by key alone. Rows and keys
+// are held in an arena; input past the memory budget is sorted in runs
+// spilled to files, which next() merges k-way. A merge reads at most
+// fan_in runs, each through a read buffer counted against the budget; with
+// more runs than that, open() first merges them fan_in at a time into
+// longer runs. With a limit only the
+// first limit rows are wanted; they are kept in a bounded heap as long as
+// it fits in memory.
+class SortOperator : public Operator {
+public:
+    SortOperator(std::unique_ptr<Operator> child, const std::vector<OrderItem>& keys, int limit, size_t memory_budget);
+    ~SortOperator() override; // Removes the run files
+    void open() override;
+    bool next(RowBatch& batch) override;
+    void close() override;
+
+private:
+    struct SortRow { // In arena
+        std::string_view key;
+        const ValueView* values;
+    };
+    struct RunHead {
+        std::string key;
+        std::vector<Value> values;
+        size_t run;
+    };
+
+    std::unique_ptr<Operator> child;
+    std::vector<size_t> key_positions;
+    std::vector<bool> descending;
+    int limit; // -1 for all rows
+    size_t memory_budget;
+    size_t fan_in; // Runs merged at once
+    size_t read_ahead; // Read buffer of each run being merged
+
+    Arena arena;
+    std::vector<SortRow> rows; // Max-heap by key while bounded
+    bool bounded = false;
+    size_t live_bytes = 0; // Of the rows held, less than arena.used() once the heap has replaced some
+    size_t position = 0; // Next of rows to hand on once sorted
+    int emitted = 0;
+    std::vector<std::string> run_files;
+    std::vector<std::unique_ptr<char[]>> run_buffers;
+    std::vector<std::unique_ptr<std::ifstream>> runs;
+    std::vector<RunHead> heads; // Min-heap over the next row of each run
+
+    void add(const RowBatch& batch, uint32_t row_index);
+    std::string encode_key(const RowBatch& batch, uint32_t row_index) const;
+    size_t row_bytes(const SortRow& row) const;
+    void compact();
+    void spill_run();
+    static bool head_greater(const RunHead& a, const RunHead& b); // Orders heads as a min-heap
+    void start_merge(size_t count); // Opens the first count runs
+    void merge_pass(); // Replaces the first fan_in runs by their merge
+    void advance_run(); // Refills heads.back(), taken by pop_heap, from its run
+    bool read_row(std::ifstream& in, RunHead& head) const;
+    void close_runs();
+    void remove_runs();
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "spill_file.h"
+#include <atomic>
+#include <cstdint>
+
+static std::atomic<int> spill_file_counter{0};
+
+std::string new_spill_file(const std::string& kind) {
+    return "data/" + kind + "_" + std::to_string(spill_file_counter++) + ".tmp";
+}
+
+void write_value(std::ofstream& out, const Value& value) {
+    write_value(out, view_of(value));
+}
+
+void write_value(std::ofstream& out, const ValueView& value) {
+    uint8_t type = static_cast<uint8_t>(value.type);
+    out.write(reinterpret_cast<const char*>(&type), sizeof(type));
+    if (value.type == DataType::INT) {
+        out.write(reinterpret_cast<const char*>(&value.int_value), sizeof(value.int_value));
+    } else if (value.type == DataType::STRING) {
+        uint32_t length = static_cast<uint32_t>(value.str_value.size());
+        out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        out.write(value.str_value.data(), length);
+    }
+}
+
+bool read_value(std::ifstream& in, Value& value) {
+    uint8_t type;
+    if (!in.read(reinterpret_cast<char*>(&type), sizeof(type))) {
+        return false;
+    }
+    value = Value();
+    value.type = static_cast<DataType>(type);
+    if (value.type == DataType::INT) {
+        in.read(reinterpret_cast<char*>(&value.int_value), sizeof(value.int_value));
+    } else if (value.type == DataType::STRING) {
+        uint32_t length;
+        in.read(reinterpret_cast<char*>(&length), sizeof(length));
+        value.str_value.resize(length);
+        in.read(&value.str_value[0], length);
+    }
+    return static_cast<bool>(in);
+}
@@ -0,0 +1,17 @@
+#ifndef SPILL_FILE_H
+#define SPILL_FILE_H
+
+#include <fstream>
+#include <string>
+#include "../common/value.h"
+
+// Temporary files of operators that outgrow their memory budget. Names are
+// unique within the process and lie in the data directory; the operator
+// that creates a file removes it.
+std::string new_spill_file(const std::string& kind);
+
+void write_value(std::ofstream& out, const Value& value);
+void write_value(std::ofstream& out, const ValueView& value);
+bool read_value(std::ifstream& in, Value& value); // False at the end of the file
+
+#endif
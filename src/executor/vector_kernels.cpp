@@ -0,0 +1,171 @@
+#include "vector_kernels.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define X86_SIMD_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace {
+
+template <CompareOp op, typename T>
+inline bool compare(const T& a, const T& b) {
+    if constexpr (op == CompareOp::EQ) return a == b;
+    if constexpr (op == CompareOp::NE) return a != b;
+    if constexpr (op == CompareOp::LT) return a < b;
+    if constexpr (op == CompareOp::LE) return a <= b;
+    if constexpr (op == CompareOp::GT) return a > b;
+    if constexpr (op == CompareOp::GE) return a >= b;
+    return false;
+}
+
+// Keeps the selected rows for which matches(row) holds, writing in place
+template <typename Matches>
+void refine(std::vector<uint32_t>& selection, Matches matches) {
+    size_t count = 0;
+    for (uint32_t row : selection) {
+        selection[count] = row;
+        count += matches(row); // No branch on the outcome
+    }
+    selection.resize(count);
+}
+
+template <CompareOp op>
+size_t select_int_scalar(const int32_t* values, size_t begin, size_t size, int32_t constant, uint32_t* selection, size_t count) {
+    for (size_t i = begin; i < size; ++i) {
+        selection[count] = static_cast<uint32_t>(i);
+        count += compare<op>(values[i], constant);
+    }
+    return count;
+}
+
+#ifdef X86_SIMD_KERNELS
+// SIMD compares offer only == and >; the other operators swap the operands
+// or negate the lane mask
+template <CompareOp op>
+constexpr bool negated() {
+    return op == CompareOp::NE || op == CompareOp::LE || op == CompareOp::GE;
+}
+
+inline size_t append_lanes(unsigned mask, size_t base, uint32_t* selection, size_t count) {
+    while (mask) {
+        selection[count++] = static_cast<uint32_t>(base + __builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+template <CompareOp op>
+__attribute__((target("avx2")))
+size_t select_int_avx2(const int32_t* values, size_t size, int32_t constant, uint32_t* selection) {
+    const __m256i c = _mm256_set1_epi32(constant);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        __m256i cmp;
+        if constexpr (op == CompareOp::EQ || op == CompareOp::NE) cmp = _mm256_cmpeq_epi32(v, c);
+        else if constexpr (op == CompareOp::LT || op == CompareOp::GE) cmp = _mm256_cmpgt_epi32(c, v);
+        else cmp = _mm256_cmpgt_epi32(v, c);
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(cmp)));
+        if constexpr (negated<op>()) mask ^= 0xFFu;
+        count = append_lanes(mask, i, selection, count);
+    }
+    return select_int_scalar<op>(values, i, size, constant, selection, count);
+}
+
+template <CompareOp op>
+size_t select_int_sse2(const int32_t* values, size_t size, int32_t constant, uint32_t* selection) {
+    const __m128i c = _mm_set1_epi32(constant);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        __m128i cmp;
+        if constexpr (op == CompareOp::EQ || op == CompareOp::NE) cmp = _mm_cmpeq_epi32(v, c);
+        else if constexpr (op == CompareOp::LT || op == CompareOp::GE) cmp = _mm_cmpgt_epi32(c, v);
+        else cmp = _mm_cmpgt_epi32(v, c);
+        unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(cmp)));
+        if constexpr (negated<op>()) mask ^= 0xFu;
+        count = append_lanes(mask, i, selection, count);
+    }
+    return select_int_scalar<op>(values, i, size, constant, selection, count);
+}
+#endif
+
+// Every row of the batch is selected, so the values are compared as one
+// contiguous array
+template <CompareOp op>
+size_t select_int_dense(const int32_t* values, size_t size, int32_t constant, uint32_t* selection) {
+#ifdef X86_SIMD_KERNELS
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2) {
+        return select_int_avx2<op>(values, size, constant, selection);
+    }
+    return select_int_sse2<op>(values, size, constant, selection);
+#else
+    return select_int_scalar<op>(values, 0, size, constant, selection, 0);
+#endif
+}
+
+template <CompareOp op>
+void select_int_op(const ColumnVector& column, int32_t constant, std::vector<uint32_t>& selection, size_t size) {
+    const int32_t* values = column.ints.data();
+    if (!column.has_nulls && selection.size() == size) {
+        selection.resize(select_int_dense<op>(values, size, constant, selection.data()));
+        return;
+    }
+    const uint8_t* nulls = column.nulls.data();
+    refine(selection, [&](uint32_t row) {
+        return nulls[row] ? op == CompareOp::NE : compare<op>(values[row], constant);
+    });
+}
+
+template <CompareOp op>
+void select_string_op(const ColumnVector& column, const std::string& constant, std::vector<uint32_t>& selection) {
+    const uint8_t* nulls = column.nulls.data();
+    const uint32_t* offsets = column.offsets.data();
+    const char* bytes = column.bytes.data();
+    std::string_view key(constant);
+    refine(selection, [&](uint32_t row) {
+        if (nulls[row]) {
+            return op == CompareOp::NE;
+        }
+        uint32_t length = offsets[row + 1] - offsets[row];
+        std::string_view value(bytes + offsets[row], length);
+        if constexpr (op == CompareOp::EQ || op == CompareOp::NE) {
+            // Values of another length differ without touching their bytes
+            bool equal = length == key.size() && std::char_traits<char>::compare(value.data(), key.data(), length) == 0;
+            return op == CompareOp::EQ ? equal : !equal;
+        } else if constexpr (op == CompareOp::LIKE) {
+            return value.find(key) != std::string_view::npos;
+        } else {
+            return compare<op>(value, key);
+        }
+    });
+}
+
+} // namespace
+
+void select_int(const ColumnVector& column, CompareOp op, int32_t constant, std::vector<uint32_t>& selection, size_t size) {
+    switch (op) {
+        case CompareOp::EQ: select_int_op<CompareOp::EQ>(column, constant, selection, size); break;
+        case CompareOp::NE: select_int_op<CompareOp::NE>(column, constant, selection, size); break;
+        case CompareOp::LT: select_int_op<CompareOp::LT>(column, constant, selection, size); break;
+        case CompareOp::LE: select_int_op<CompareOp::LE>(column, constant, selection, size); break;
+        case CompareOp::GT: select_int_op<CompareOp::GT>(column, constant, selection, size); break;
+        case CompareOp::GE: select_int_op<CompareOp::GE>(column, constant, selection, size); break;
+        case CompareOp::LIKE: selection.clear(); break; // LIKE matches strings only
+    }
+}
+
+void select_string(const ColumnVector& column, CompareOp op, const std::string& constant, std::vector<uint32_t>& selection) {
+    switch (op) {
+        case CompareOp::EQ: select_string_op<CompareOp::EQ>(column, constant, selection); break;
+        case CompareOp::NE: select_string_op<CompareOp::NE>(column, constant, selection); break;
+        case CompareOp::LT: select_string_op<CompareOp::LT>(column, constant, selection); break;
+        case CompareOp::LE: select_string_op<CompareOp::LE>(column, constant, selection); break;
+        case CompareOp::GT: select_string_op<CompareOp::GT>(column, constant, selection); break;
+        case CompareOp::GE: select_string_op<CompareOp::GE>(column, constant, selection); break;
+        case CompareOp::LIKE: select_string_op<CompareOp::LIKE>(column, constant, selection); break;
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef VECTOR_KERNELS_H
+#define VECTOR_KERNELS_H
+
+#include <string>
+#include <cstdint>
+#include "row_batch.h"
+#include "../common/predicate.h"
+
+// Narrows selection to the rows of column whose value compares true against
+// constant. NULL only satisfies NE, as in the row-at-a-time filter.
+//
+// INT columns whose selection still holds every row are compared with
+// AVX2, or SSE2 where the CPU lacks it, eight or four values per
+// instruction; a sparse selection is refined one row at a time. STRING
+// equality compares lengths before any bytes.
+void select_int(const ColumnVector& column, CompareOp op, int32_t constant, std::vector<uint32_t>& selection, size_t size);
+void select_string(const ColumnVector& column, CompareOp op, const std::string& constant, std::vector<uint32_t>& selection);
+
+#endif
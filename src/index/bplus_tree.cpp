@@ -1,229 +1,735 @@
 #include "bplus_tree.h"
 #include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+namespace {
+const uint32_t INDEX_MAGIC = 0x32525442; // "BTR2"
+const uint32_t OLD_INDEX_MAGIC = 0x31525442; // "BTR1": slots without key prefixes
+const int META_PAGE = 0;
+const int NO_PAGE = -1;
+
+// Sorts before every real tid, so (key, MIN_TID) finds the first entry for key
+const Tid MIN_TID = {std::numeric_limits<int>::min(), std::numeric_limits<short>::min()};
+
+struct IndexMeta {
+    uint32_t magic;
+    int32_t root;
+    int32_t page_count;
+    KeyFormat key_format;
+};
+
+// Node layout inside Page::data: header, slot array growing up, key bytes
+// growing down from the end of the page
+struct NodeHeader {
+    uint8_t is_leaf;
+    KeyFormat key_format; // Copied from the meta page so node searches need only the node
+    uint16_t key_count;
+    uint16_t heap_start;  // Key bytes occupy [heap_start, PAGE_DATA_SIZE)
+    uint16_t reserved;
+    int32_t first_child;  // Internal: subtree holding entries below the first key
+    int32_t next_leaf;    // Leaf: right sibling, NO_PAGE for the last leaf
+};
+
+struct NodeSlot {
+    uint64_t prefix; // Order-preserving integer form of the key's first 8 bytes
+    uint16_t key_offset;
+    uint16_t key_length;
+    int32_t tid_page;
+    int16_t tid_slot;
+    uint16_t reserved;
+    int32_t child;
+};
+
+const size_t NODE_CAPACITY = PAGE_DATA_SIZE - sizeof(NodeHeader);
+const int MAX_SLOTS = NODE_CAPACITY / sizeof(NodeSlot);
+// Keeps at least four entries per node so a split always leaves both halves non-empty
+const size_t MAX_KEY_SIZE = NODE_CAPACITY / 4 - sizeof(NodeSlot);
+// Inner nodes with less free space than this are split before a descent passes them
+const int MAX_ENTRY_SIZE = MAX_KEY_SIZE + sizeof(NodeSlot);
+
+const uint64_t WRITE_LOCKED = 2;
+const size_t LATCH_CHUNK = 1024;
+const size_t MAX_LATCH_CHUNKS = 1 << 16;
+
+// Page::data has no alignment guarantee, so all node fields go through memcpy
+template <typename T>
+T read_at(const char* ptr) {
+    T value;
+    std::memcpy(&value, ptr, sizeof(T));
+    return value;
+}
 
-BPlusTree::BPlusTree(int degree) : root(std::make_shared<Node>()), degree(degree), cache(nullptr), index_name("") {
-    root->is_leaf = true;
+template <typename T>
+void write_at(char* ptr, const T& value) {
+    std::memcpy(ptr, &value, sizeof(T));
 }
 
-BPlusTree::BPlusTree(BufferCache& cache, const std::string& index_name) : root(std::make_shared<Node>()), degree(4), cache(&cache), index_name(index_name) {
-    root->is_leaf = true;
+NodeHeader node_header(const Page* page) { return read_at<NodeHeader>(page->data); }
+void set_node_header(Page* page, const NodeHeader& header) { write_at(page->data, header); }
+
+char* slot_ptr(Page* page, int i) { return page->data + sizeof(NodeHeader) + i * sizeof(NodeSlot); }
+NodeSlot node_slot(const Page* page, int i) {
+    return read_at<NodeSlot>(page->data + sizeof(NodeHeader) + i * sizeof(NodeSlot));
 }
 
-void BPlusTree::insert(const std::string& key, Tid tid) {
-    std::shared_ptr<Node> leaf = find_leaf(key);
-    insert_into_leaf(leaf, key, tid);
+// Unlatched readers may see a node mid-update; the clamps keep such a read
+// inside the page until version validation discards it
+int slot_count(const NodeHeader& header) { return std::min<int>(header.key_count, MAX_SLOTS); }
+
+std::string_view slot_key(const Page* page, const NodeSlot& slot) {
+    size_t offset = std::min<size_t>(slot.key_offset, PAGE_DATA_SIZE);
+    return std::string_view(page->data + offset, std::min<size_t>(slot.key_length, PAGE_DATA_SIZE - offset));
+}
+
+int free_space(const Page* page) {
+    NodeHeader header = node_header(page);
+    return static_cast<int>(header.heap_start) - static_cast<int>(sizeof(NodeHeader) + slot_count(header) * sizeof(NodeSlot));
+}
+
+int compare_entry(KeyFormat format, std::string_view key_a, const Tid& tid_a, std::string_view key_b, const Tid& tid_b) {
+    int cmp = compare_index_keys(key_a, key_b, format);
+    if (cmp != 0) return cmp;
+    if (tid_a.page_id != tid_b.page_id) return tid_a.page_id < tid_b.page_id ? -1 : 1;
+    if (tid_a.offset != tid_b.offset) return tid_a.offset < tid_b.offset ? -1 : 1;
+    return 0;
+}
+
+int compare_slot(KeyFormat format, const Page* page, int i, std::string_view key, const Tid& tid) {
+    NodeSlot slot = node_slot(page, i);
+    return compare_entry(format, slot_key(page, slot), {slot.tid_page, slot.tid_slot}, key, tid);
+}
 
-    if (leaf->keys.size() >= degree) {
-        split_leaf(leaf);
+// If a sorts before b, key_prefix(a) <= key_prefix(b): INT64 keys map their
+// first column to unsigned order, BYTES keys read their first 8 bytes
+// big-endian, zero padded. Only equal prefixes need the full comparison.
+uint64_t key_prefix(std::string_view key, KeyFormat format) {
+    if (format == KeyFormat::INT64) {
+        if (key.size() < sizeof(int64_t)) return 0;
+        return static_cast<uint64_t>(read_at<int64_t>(key.data())) ^ (1ULL << 63);
+    }
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < sizeof(prefix); ++i) {
+        prefix = prefix << 8 | (i < key.size() ? static_cast<uint8_t>(key[i]) : 0);
     }
+    return prefix;
 }
 
-std::vector<Tid> BPlusTree::search(const std::string& key) {
-    std::shared_ptr<Node> leaf = find_leaf(key);
-    std::vector<Tid> results;
-    auto it = std::lower_bound(leaf->keys.begin(), leaf->keys.end(), key);
-    while (it != leaf->keys.end() && *it == key) {
-        size_t index = std::distance(leaf->keys.begin(), it);
-        results.push_back(leaf->tids[index]);
-        ++it;
+uint64_t slot_prefix(const Page* page, int i) {
+    return read_at<uint64_t>(page->data + sizeof(NodeHeader) + i * sizeof(NodeSlot) + offsetof(NodeSlot, prefix));
+}
+
+// First slot in [0, count) whose prefix is >= target. The loop has a fixed
+// trip count for a given count and no data-dependent branch.
+int prefix_lower_bound(const Page* page, int count, uint64_t target) {
+    if (count == 0) return 0;
+    int base = 0;
+    while (count > 1) {
+        int half = count / 2;
+        base += (slot_prefix(page, base + half) < target) * half;
+        count -= half;
     }
-    return results;
+    return base + (slot_prefix(page, base) < target);
 }
 
-std::vector<Tid> BPlusTree::search_range(const std::string& start_key, const std::string& end_key) {
-    std::vector<Tid> results;
-    std::shared_ptr<Node> leaf = find_leaf(start_key);
+// Narrows [lo, hi) to the slots sharing the key's prefix, which is usually
+// one slot, before comparing whole entries
+template <typename Before>
+int search_node(const Page* page, std::string_view key, Before before) {
+    NodeHeader header = node_header(page);
+    int count = slot_count(header);
+    uint64_t prefix = key_prefix(key, header.key_format);
+    int lo = prefix_lower_bound(page, count, prefix);
+    int hi = prefix == UINT64_MAX ? count : prefix_lower_bound(page, count, prefix + 1);
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (before(mid)) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
 
-    bool done = false;
-    while (leaf && !done) {
-        for (size_t i = 0; i < leaf->keys.size(); ++i) {
-            if (leaf->keys[i] > end_key) {
-                done = true;
-                break;
-            }
-            if (leaf->keys[i] >= start_key) {
-                results.push_back(leaf->tids[i]);
-            }
-        }
-        leaf = leaf->next_leaf;
+// First slot whose entry is >= (key, tid)
+int lower_bound(const Page* page, std::string_view key, const Tid& tid) {
+    KeyFormat format = node_header(page).key_format;
+    return search_node(page, key, [&](int i) { return compare_slot(format, page, i, key, tid) < 0; });
+}
+
+// First slot whose entry is > (key, tid)
+int upper_bound(const Page* page, std::string_view key, const Tid& tid) {
+    KeyFormat format = node_header(page).key_format;
+    return search_node(page, key, [&](int i) { return compare_slot(format, page, i, key, tid) <= 0; });
+}
+
+// Shortest separator between the last entry of a left leaf and the first
+// entry of its right sibling. Distinct BYTES keys need only the right key's
+// bytes up to the first difference; (prefix, MIN_TID) still sorts above the
+// left key and not above the right entry.
+std::pair<std::string, Tid> leaf_separator(KeyFormat format, const std::string& left_key, const std::string& right_key, const Tid& right_tid) {
+    if (format != KeyFormat::BYTES || left_key == right_key) {
+        return {right_key, right_tid};
     }
-    return results;
+    auto diff = std::mismatch(left_key.begin(), left_key.end(), right_key.begin(), right_key.end());
+    return {right_key.substr(0, diff.second - right_key.begin() + 1), MIN_TID};
 }
 
-// --- Helper function implementations ---
+int child_at(const Page* page, int pos) {
+    return pos == 0 ? node_header(page).first_child : node_slot(page, pos - 1).child;
+}
 
-std::shared_ptr<BPlusTree::Node> BPlusTree::find_leaf(const std::string& key) {
-    std::shared_ptr<Node> current = root;
-    while (!current->is_leaf) {
-        auto it = std::upper_bound(current->keys.begin(), current->keys.end(), key);
-        size_t index = std::distance(current->keys.begin(), it);
-        current->children[index]->parent = current;
-        current = current->children[index];
+// Inserts at pos if the node has room; returns false when it must split
+bool insert_into_node(Page* page, int pos, const std::string& key, const Tid& tid, int child) {
+    NodeHeader header = node_header(page);
+    size_t slots_end = sizeof(NodeHeader) + (header.key_count + 1) * sizeof(NodeSlot);
+    if (slots_end + key.size() > header.heap_start) {
+        return false;
     }
-    return current;
+    header.heap_start -= static_cast<uint16_t>(key.size());
+    std::memcpy(page->data + header.heap_start, key.data(), key.size());
+    std::memmove(slot_ptr(page, pos + 1), slot_ptr(page, pos), (header.key_count - pos) * sizeof(NodeSlot));
+    NodeSlot slot = {key_prefix(key, header.key_format), header.heap_start, static_cast<uint16_t>(key.size()), tid.page_id, tid.offset, 0, child};
+    write_at(slot_ptr(page, pos), slot);
+    header.key_count++;
+    set_node_header(page, header);
+    page->dirty = true;
+    return true;
 }
 
-void BPlusTree::insert_into_leaf(std::shared_ptr<Node> leaf, const std::string& key, Tid tid) {
-    auto it = std::lower_bound(leaf->keys.begin(), leaf->keys.end(), key);
-    size_t index = std::distance(leaf->keys.begin(), it);
-    leaf->keys.insert(it, key);
-    leaf->tids.insert(leaf->tids.begin() + index, tid);
+// Fails while a writer holds the node; the caller restarts
+bool read_lock(const std::atomic<uint64_t>& latch, uint64_t& version) {
+    version = latch.load(std::memory_order_acquire);
+    if (version & WRITE_LOCKED) {
+        std::this_thread::yield();
+        return false;
+    }
+    return true;
 }
 
-void BPlusTree::split_leaf(std::shared_ptr<Node> leaf) {
-    auto new_leaf = std::make_shared<Node>();
-    new_leaf->is_leaf = true;
+// True when nothing was written to the node since version was read
+bool validate(const std::atomic<uint64_t>& latch, uint64_t version) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return latch.load(std::memory_order_relaxed) == version;
+}
 
-    size_t mid_index = degree / 2;
+bool upgrade(std::atomic<uint64_t>& latch, uint64_t version) {
+    return latch.compare_exchange_strong(version, version + WRITE_LOCKED, std::memory_order_acquire);
+}
 
-    new_leaf->keys.assign(leaf->keys.begin() + mid_index, leaf->keys.end());
-    new_leaf->tids.assign(leaf->tids.begin() + mid_index, leaf->tids.end());
+void write_unlock(std::atomic<uint64_t>& latch) {
+    latch.fetch_add(WRITE_LOCKED, std::memory_order_release);
+}
+
+int read_root(const Page* meta) { return read_at<int32_t>(meta->data + offsetof(IndexMeta, root)); }
+}
 
-    leaf->keys.resize(mid_index);
-    leaf->tids.resize(mid_index);
+BPlusTree::BPlusTree(BufferCache& cache, const std::string& index_file, KeyFormat key_format, WalWriter wal_writer)
+    : cache(cache), index_file(index_file), format(key_format), wal_writer(std::move(wal_writer)),
+      latch_chunks(new std::atomic<Latch*>[MAX_LATCH_CHUNKS]()) {
+    if (!std::filesystem::exists(index_file)) {
+        std::ofstream create(index_file, std::ios::binary);
+        if (!create) {
+            throw std::runtime_error("Could not create index file: " + index_file);
+        }
+    }
 
-    new_leaf->next_leaf = leaf->next_leaf;
-    leaf->next_leaf = new_leaf;
+    PinnedPage meta = pin(META_PAGE);
+    IndexMeta info = read_at<IndexMeta>(meta.page()->data);
+    if (info.magic == INDEX_MAGIC) {
+        format = info.key_format;
+        return; // Existing index, usable as is
+    }
+    if (info.magic == OLD_INDEX_MAGIC) {
+        throw std::runtime_error("Index file has an outdated node format, drop and recreate the index: " + index_file);
+    }
 
-    std::string key_to_promote = new_leaf->keys[0];
-    insert_into_parent(leaf, key_to_promote, new_leaf);
+    // New index: a single empty leaf as the root
+    write_at(meta.page()->data, IndexMeta{INDEX_MAGIC, 1, 2, format});
+    meta.page()->dirty = true;
+    std::vector<PinnedPage> touched;
+    touched.push_back(std::move(meta));
+    touched.push_back(pin(1));
+    Page* root = touched.back().page();
+    *root = Page();
+    set_node_header(root, {1, format, 0, static_cast<uint16_t>(PAGE_DATA_SIZE), 0, NO_PAGE, NO_PAGE});
+    root->dirty = true;
+    log_pages(touched);
 }
 
-void BPlusTree::insert_into_parent(std::shared_ptr<Node> left, const std::string& key, std::shared_ptr<Node> right) {
-    std::shared_ptr<Node> parent = left->parent.lock();
+BPlusTree::~BPlusTree() {
+    for (size_t i = 0; i < MAX_LATCH_CHUNKS; ++i) {
+        delete[] latch_chunks[i].load();
+    }
+}
+
+void BPlusTree::insert(const std::string& key, Tid tid) {
+    insert_sorted({{key, tid}});
+}
+
+void BPlusTree::insert_sorted(const std::vector<std::pair<std::string, Tid>>& entries) {
+    for (const auto& [key, tid] : entries) {
+        if (key.size() > MAX_KEY_SIZE) {
+            throw std::runtime_error("Index key exceeds " + std::to_string(MAX_KEY_SIZE) + " bytes.");
+        }
+    }
+
+    size_t i = 0;
+    while (i < entries.size()) {
+        insert_run(entries, i);
+    }
+}
 
-    if (!parent) {
-        root = std::make_shared<Node>();
-        root->keys.push_back(key);
-        root->children.push_back(left);
-        root->children.push_back(right);
-        left->parent = root;
-        right->parent = root;
+// Inserts the entries from i on that fall into one leaf and advances i past
+// them. Returns early, possibly without progress, when the descent or a
+// latch upgrade has to restart.
+void BPlusTree::insert_run(const std::vector<std::pair<std::string, Tid>>& entries, size_t& i) {
+    Descent descent;
+    if (!descend(entries[i].first, entries[i].second, descent, true) ||
+        !upgrade(latch(descent.leaf.id()), descent.leaf_version)) {
         return;
     }
+    Page* leaf = descent.leaf.page();
+    const auto& fence = descent.fence;
+
+    // Everything below the fence belongs to this leaf; a split changes
+    // the leaf's range, so the next entry descends again
+    do {
+        const auto& [key, tid] = entries[i];
+        if (!insert_into_node(leaf, lower_bound(leaf, key, tid), key, tid, NO_PAGE)) {
+            // The parent had room for a separator when the descent passed it;
+            // if it changed since, start over
+            if (upgrade(latch(descent.parent.id()), descent.parent_version)) {
+                std::vector<PinnedPage> touched;
+                split_node(descent.parent.id(), descent.leaf.id(), Entry{key, tid, NO_PAGE}, touched);
+                log_pages(touched);
+                write_unlock(latch(descent.parent.id()));
+                ++i;
+            }
+            break;
+        }
+        ++i;
+    } while (i < entries.size() &&
+             (!fence || compare_entry(format, entries[i].first, entries[i].second, fence->key, fence->tid) < 0));
+    write_unlock(latch(descent.leaf.id()));
+}
 
-    auto it = std::upper_bound(parent->keys.begin(), parent->keys.end(), key);
-    size_t index = std::distance(parent->keys.begin(), it);
-    parent->keys.insert(it, key);
-    parent->children.insert(parent->children.begin() + index + 1, right);
-    right->parent = parent;
+void BPlusTree::bulk_load(const std::function<bool(std::pair<std::string, Tid>&)>& next, int fill_factor) {
+    IndexMeta info = read_at<IndexMeta>(get_page(META_PAGE)->data);
+    if (info.page_count != 2 || node_header(get_page(info.root)).key_count != 0) {
+        throw std::runtime_error("Bulk load needs an empty index: " + index_file);
+    }
+    size_t fill_limit = NODE_CAPACITY * std::clamp(fill_factor, 10, 100) / 100;
+
+    // Leaves, starting with the empty root leaf; level collects the first
+    // entry of every node as its separator for the level above
+    std::vector<Entry> level;
+    int page_id = info.root;
+    Page* page = get_page(page_id);
+    size_t used = 0;
+    std::pair<std::string, Tid> entry;
+    std::string last_key;
+    while (next(entry)) {
+        const auto& [key, tid] = entry;
+        if (key.size() > MAX_KEY_SIZE) {
+            throw std::runtime_error("Index key exceeds " + std::to_string(MAX_KEY_SIZE) + " bytes.");
+        }
+        NodeHeader header = node_header(page);
+        size_t size = sizeof(NodeSlot) + key.size();
+        if (header.key_count > 0 && used + size > fill_limit) {
+            header.next_leaf = info.page_count++;
+            set_node_header(page, header);
+            page_id = header.next_leaf;
+            page = get_page(page_id);
+            *page = Page();
+            set_node_header(page, {1, format, 0, static_cast<uint16_t>(PAGE_DATA_SIZE), 0, NO_PAGE, NO_PAGE});
+            header = node_header(page);
+            used = 0;
+        }
+        if (level.empty()) {
+            level.push_back({key, tid, page_id});
+        } else if (header.key_count == 0) {
+            auto [separator_key, separator_tid] = leaf_separator(format, last_key, key, tid);
+            level.push_back({std::move(separator_key), separator_tid, page_id});
+        }
+        insert_into_node(page, header.key_count, key, tid, NO_PAGE);
+        used += size;
+        last_key = key;
+    }
+    if (level.empty()) {
+        return;
+    }
 
-    if (parent->keys.size() >= degree) {
-        split_internal(parent);
+    // Internal levels: the first child of each node becomes first_child and
+    // its separator moves up to the next level. Every node takes at least two
+    // children so each level is smaller than the one below.
+    while (level.size() > 1) {
+        std::vector<Entry> parents;
+        for (const Entry& child : level) {
+            size_t size = sizeof(NodeSlot) + child.key.size();
+            if (parents.empty() || (used > 0 && used + size > fill_limit)) {
+                page_id = info.page_count++;
+                page = get_page(page_id);
+                *page = Page();
+                set_node_header(page, {0, format, 0, static_cast<uint16_t>(PAGE_DATA_SIZE), 0, child.child, NO_PAGE});
+                page->dirty = true;
+                parents.push_back({child.key, child.tid, page_id});
+                used = 0;
+                continue;
+            }
+            page = get_page(page_id);
+            insert_into_node(page, node_header(page).key_count, child.key, child.tid, child.child);
+            used += size;
+        }
+        level = std::move(parents);
     }
+
+    info.root = level.front().child;
+    Page* meta = get_page(META_PAGE);
+    write_at(meta->data, info);
+    meta->dirty = true;
 }
 
-void BPlusTree::split_internal(std::shared_ptr<Node> node) {
-    auto new_internal = std::make_shared<Node>();
-    
-    size_t mid_index = (degree - 1) / 2;
-    std::string key_to_promote = node->keys[mid_index];
+// Deletes only from the leaf; emptied nodes stay in the tree and are reused
+// by later inserts into their key range
+void BPlusTree::remove(const std::string& key, const Tid& tid) {
+    Descent descent;
+    while (!descend(key, tid, descent, false) || !upgrade(latch(descent.leaf.id()), descent.leaf_version)) {
+    }
+    Page* leaf = descent.leaf.page();
+    NodeHeader header = node_header(leaf);
+    int pos = lower_bound(leaf, key, tid);
+    if (pos == header.key_count || compare_slot(format, leaf, pos, key, tid) != 0) {
+        write_unlock(latch(descent.leaf.id()));
+        return;
+    }
 
-    new_internal->keys.assign(node->keys.begin() + mid_index + 1, node->keys.end());
-    new_internal->children.assign(node->children.begin() + mid_index + 1, node->children.end());
-    
-    for(auto& child : new_internal->children) {
-        child->parent = new_internal;
+    // Rewrite the node so the key bytes are reclaimed along with the slot
+    std::vector<std::pair<std::string, NodeSlot>> kept;
+    for (int i = 0; i < header.key_count; ++i) {
+        if (i == pos) continue;
+        NodeSlot slot = node_slot(leaf, i);
+        kept.emplace_back(std::string(slot_key(leaf, slot)), slot);
+    }
+    header.key_count = 0;
+    header.heap_start = static_cast<uint16_t>(PAGE_DATA_SIZE);
+    set_node_header(leaf, header);
+    for (size_t i = 0; i < kept.size(); ++i) {
+        const NodeSlot& slot = kept[i].second;
+        insert_into_node(leaf, static_cast<int>(i), kept[i].first, {slot.tid_page, slot.tid_slot}, slot.child);
     }
+    leaf->dirty = true;
+    write_unlock(latch(descent.leaf.id()));
+}
 
-    node->keys.resize(mid_index);
-    node->children.resize(mid_index + 1);
+std::vector<Tid> BPlusTree::search(const std::string& key) {
+    return search_range(key, key);
+}
 
-    insert_into_parent(node, key_to_promote, new_internal);
+std::vector<Tid> BPlusTree::search_range(const std::string& start_key, const std::optional<std::string>& end_key) {
+    return scan(start_key, end_key, nullptr);
 }
 
-// --- Deletion Implementation ---
+std::vector<Tid> BPlusTree::search_range(const std::string& start_key, const std::optional<std::string>& end_key, std::vector<std::string>& keys) {
+    keys.clear();
+    return scan(start_key, end_key, &keys);
+}
 
-void BPlusTree::remove(const std::string& key, const Tid& tid) {
-    std::shared_ptr<Node> leaf = find_leaf(key);
-    remove_entry(leaf, key, tid);
+// Leaves are read unlatched and validated before their entries count. After
+// a failed validation the scan descends again and resumes behind the last
+// entry it returned. Column encodings are prefix-free, so cutting a key to
+// end_key's length compares just the columns end_key has.
+std::vector<Tid> BPlusTree::scan(const std::string& start_key, const std::optional<std::string>& end_key, std::vector<std::string>* keys) {
+    std::vector<Tid> results;
+    std::string resume_key = start_key;
+    Tid resume_tid = MIN_TID;
+    bool resumed = false;
+
+    while (true) {
+        Descent descent;
+        if (!descend(resume_key, resume_tid, descent, false)) {
+            continue;
+        }
+        PinnedPage leaf = std::move(descent.leaf);
+        uint64_t version = descent.leaf_version;
+        int pos = resumed ? upper_bound(leaf.page(), resume_key, resume_tid) : lower_bound(leaf.page(), resume_key, resume_tid);
+
+        while (true) {
+            Page* page = leaf.page();
+            NodeHeader header = node_header(page);
+            size_t first = results.size();
+            bool done = false;
+            for (; pos < slot_count(header); ++pos) {
+                NodeSlot slot = node_slot(page, pos);
+                std::string_view key = slot_key(page, slot);
+                if (end_key && compare_index_keys(key.substr(0, end_key->size()), *end_key, format) > 0) {
+                    done = true;
+                    break;
+                }
+                results.push_back({slot.tid_page, slot.tid_slot});
+                if (keys) keys->emplace_back(key);
+            }
+            std::string last_key = results.size() > first ? std::string(slot_key(page, node_slot(page, pos - 1))) : "";
+            if (!validate(latch(leaf.id()), version)) {
+                results.resize(first);
+                if (keys) keys->resize(first);
+                break;
+            }
+            if (results.size() > first) {
+                resume_key = std::move(last_key);
+                resume_tid = results.back();
+                resumed = true;
+            }
+            if (done || header.next_leaf == NO_PAGE) {
+                return results;
+            }
+
+            PinnedPage next = pin(header.next_leaf);
+            uint64_t next_version;
+            if (!read_lock(latch(next.id()), next_version) || !validate(latch(leaf.id()), version)) {
+                break;
+            }
+            leaf = std::move(next);
+            version = next_version;
+            pos = 0;
+        }
+    }
 }
 
-void BPlusTree::remove_entry(std::shared_ptr<Node> node, const std::string& key, const Tid& tid) {
-    // Remove entry from node
-    auto it = std::lower_bound(node->keys.begin(), node->keys.end(), key);
-    size_t index = std::distance(node->keys.begin(), it);
-    node->keys.erase(it);
-    if (node->is_leaf) {
-        node->tids.erase(node->tids.begin() + index);
-    } else {
-        node->children.erase(node->children.begin() + index + 1);
+// Descends optimistically to the leaf whose range covers (key, tid). Each
+// child is read only after its parent validates, so a node seen at a valid
+// version really covers the key. A descent for an insert splits inner nodes
+// that might not take another separator, so a later leaf split always finds
+// room in its parent. Returns false when the descent must restart.
+bool BPlusTree::descend(const std::string& key, const Tid& tid, Descent& descent, bool for_insert) {
+    descent.fence.reset();
+    descent.parent = pin(META_PAGE);
+    if (!read_lock(latch(META_PAGE), descent.parent_version)) {
+        return false;
+    }
+    int page_id = read_root(descent.parent.page());
+    if (!validate(latch(META_PAGE), descent.parent_version)) {
+        return false;
+    }
+    descent.leaf = pin(page_id);
+    if (!read_lock(latch(page_id), descent.leaf_version) || !validate(latch(META_PAGE), descent.parent_version)) {
+        return false;
     }
 
-    // Handle underflow
-    if (node == root) {
-        if (root->keys.empty() && !root->children.empty()) {
-            root = root->children[0];
-            root->parent.reset();
+    while (true) {
+        Page* page = descent.leaf.page();
+        NodeHeader header = node_header(page);
+        if (header.is_leaf) {
+            return validate(latch(descent.leaf.id()), descent.leaf_version);
         }
-        return;
+        if (for_insert && free_space(page) < MAX_ENTRY_SIZE) {
+            split_full_node(descent);
+            return false;
+        }
+
+        int pos = upper_bound(page, key, tid);
+        std::optional<Entry> fence = descent.fence;
+        if (pos < slot_count(header)) {
+            NodeSlot slot = node_slot(page, pos);
+            fence = Entry{std::string(slot_key(page, slot)), {slot.tid_page, slot.tid_slot}, slot.child};
+        }
+        int child_id = child_at(page, pos);
+        if (!validate(latch(descent.leaf.id()), descent.leaf_version)) {
+            return false;
+        }
+        PinnedPage child = pin(child_id);
+        uint64_t child_version;
+        if (!read_lock(latch(child_id), child_version) || !validate(latch(descent.leaf.id()), descent.leaf_version)) {
+            return false;
+        }
+        descent.fence = std::move(fence);
+        descent.parent = std::move(descent.leaf);
+        descent.parent_version = descent.leaf_version;
+        descent.leaf = std::move(child);
+        descent.leaf_version = child_version;
     }
+}
 
-    if (node->keys.size() < (degree -1) / 2) {
-        auto parent = node->parent.lock();
-        int node_idx = get_node_index(node);
-        int neighbor_idx = (node_idx == 0) ? 1 : node_idx - 1;
-        auto neighbor = parent->children[neighbor_idx];
+// Splits the inner node a descent stopped at, with its parent latched for
+// the new separator
+void BPlusTree::split_full_node(Descent& descent) {
+    if (!upgrade(latch(descent.parent.id()), descent.parent_version)) {
+        return;
+    }
+    if (upgrade(latch(descent.leaf.id()), descent.leaf_version)) {
+        std::vector<PinnedPage> touched;
+        split_node(descent.parent.id(), descent.leaf.id(), std::nullopt, touched);
+        log_pages(touched);
+        write_unlock(latch(descent.leaf.id()));
+    }
+    write_unlock(latch(descent.parent.id()));
+}
 
-        if (node->keys.size() + neighbor->keys.size() < degree) {
-            if (node_idx == 0) { // node is left child
-                coalesce_nodes(node, neighbor, neighbor_idx, parent->keys[0]);
-            } else { // node is right child
-                coalesce_nodes(neighbor, node, node_idx, parent->keys[node_idx - 1]);
-            }
+BPlusTree::Latch& BPlusTree::latch(int page_id) {
+    size_t chunk_index = static_cast<size_t>(page_id) / LATCH_CHUNK;
+    if (chunk_index >= MAX_LATCH_CHUNKS) {
+        throw std::runtime_error("Index page out of latch range: " + index_file);
+    }
+    auto& chunk = latch_chunks[chunk_index];
+    Latch* latches = chunk.load(std::memory_order_acquire);
+    if (!latches) {
+        Latch* fresh = new Latch[LATCH_CHUNK]();
+        if (chunk.compare_exchange_strong(latches, fresh, std::memory_order_acq_rel)) {
+            latches = fresh;
         } else {
-            redistribute_nodes(node, neighbor, neighbor_idx);
+            delete[] fresh;
         }
     }
+    return latches[page_id % LATCH_CHUNK];
+}
+
+// Only page_count is written here, so readers of the root field are unaffected
+int BPlusTree::allocate_page(std::vector<PinnedPage>& touched) {
+    std::lock_guard<std::mutex> guard(meta_mutex);
+    PinnedPage meta = pin(META_PAGE);
+    char* page_count = meta.page()->data + offsetof(IndexMeta, page_count);
+    int page_id = read_at<int32_t>(page_count);
+    write_at<int32_t>(page_count, page_id + 1);
+    meta.page()->dirty = true;
+    touched.push_back(std::move(meta));
+    return page_id;
 }
 
-void BPlusTree::coalesce_nodes(std::shared_ptr<Node> node, std::shared_ptr<Node> neighbor, int neighbor_index, const std::string& k_prime) {
-    // Simplified coalesce logic
-    if (!node->is_leaf) {
-        node->keys.push_back(k_prime);
+// Splits page_id, adding entry if given, and inserts the new separator into
+// parent_id, or grows a new root when the parent is the meta page. The
+// caller holds both latches and made sure the parent has room.
+void BPlusTree::split_node(int parent_id, int page_id, const std::optional<Entry>& entry, std::vector<PinnedPage>& touched) {
+    PinnedPage node = pin(page_id);
+    Page* page = node.page();
+    NodeHeader header = node_header(page);
+    bool is_leaf = header.is_leaf;
+
+    std::vector<Entry> entries;
+    entries.reserve(header.key_count + 1);
+    for (int i = 0; i < header.key_count; ++i) {
+        NodeSlot slot = node_slot(page, i);
+        entries.push_back({std::string(slot_key(page, slot)), {slot.tid_page, slot.tid_slot}, slot.child});
+    }
+    if (entry) {
+        entries.insert(entries.begin() + lower_bound(page, entry->key, entry->tid), *entry);
+    }
+
+    // Split by bytes rather than by count so variable-length keys balance
+    size_t total = 0;
+    for (const auto& e : entries) total += sizeof(NodeSlot) + e.key.size();
+    size_t split = 0;
+    for (size_t bytes = 0; split < entries.size() && bytes < total / 2; ++split) {
+        bytes += sizeof(NodeSlot) + entries[split].key.size();
+    }
+    split = std::clamp<size_t>(split, 1, entries.size() - (is_leaf ? 1 : 2));
+
+    // The new node is unreachable until the parent or the left leaf links it,
+    // and both are latched
+    int right_id = allocate_page(touched);
+    PinnedPage right_node = pin(right_id);
+    Page* right = right_node.page();
+    *right = Page();
+
+    // In a leaf the separator is a copy of the right node's first entry; in an
+    // internal node the middle entry moves up and its child becomes the right
+    // node's first child
+    Entry separator = {entries[split].key, entries[split].tid, right_id};
+    if (is_leaf) {
+        auto [key, tid] = leaf_separator(format, entries[split - 1].key, entries[split].key, entries[split].tid);
+        separator = {std::move(key), tid, right_id};
     }
-    node->keys.insert(node->keys.end(), neighbor->keys.begin(), neighbor->keys.end());
-    if (node->is_leaf) {
-        node->tids.insert(node->tids.end(), neighbor->tids.begin(), neighbor->tids.end());
-        node->next_leaf = neighbor->next_leaf;
+    NodeHeader left_header = {header.is_leaf, format, 0, static_cast<uint16_t>(PAGE_DATA_SIZE), 0, header.first_child, NO_PAGE};
+    NodeHeader right_header = left_header;
+    size_t right_begin = split;
+    if (is_leaf) {
+        right_header.next_leaf = header.next_leaf;
+        left_header.next_leaf = right_id;
     } else {
-        node->children.insert(node->children.end(), neighbor->children.begin(), neighbor->children.end());
-        for(auto& child : neighbor->children) child->parent = node;
+        right_header.first_child = entries[split].child;
+        right_begin = split + 1;
     }
 
-    remove_entry(node->parent.lock(), k_prime, {});
+    set_node_header(right, right_header);
+    for (size_t i = right_begin; i < entries.size(); ++i) {
+        insert_into_node(right, static_cast<int>(i - right_begin), entries[i].key, entries[i].tid, entries[i].child);
+    }
+    set_node_header(page, left_header);
+    for (size_t i = 0; i < split; ++i) {
+        insert_into_node(page, static_cast<int>(i), entries[i].key, entries[i].tid, entries[i].child);
+    }
+    page->dirty = true;
+    right->dirty = true;
+    touched.push_back(std::move(node));
+    touched.push_back(std::move(right_node));
+
+    if (parent_id == META_PAGE) {
+        // Splitting the root grows the tree by one level
+        int root_id = allocate_page(touched);
+        PinnedPage root_node = pin(root_id);
+        Page* root = root_node.page();
+        *root = Page();
+        set_node_header(root, {0, format, 0, static_cast<uint16_t>(PAGE_DATA_SIZE), 0, page_id, NO_PAGE});
+        insert_into_node(root, 0, separator.key, separator.tid, right_id);
+        touched.push_back(std::move(root_node));
+
+        std::lock_guard<std::mutex> guard(meta_mutex);
+        PinnedPage meta = pin(META_PAGE);
+        write_at<int32_t>(meta.page()->data + offsetof(IndexMeta, root), root_id);
+        meta.page()->dirty = true;
+        touched.push_back(std::move(meta));
+        return;
+    }
+
+    PinnedPage parent = pin(parent_id);
+    if (!insert_into_node(parent.page(), upper_bound(parent.page(), separator.key, separator.tid), separator.key, separator.tid, right_id)) {
+        throw std::runtime_error("Index parent node has no room for a separator: " + index_file);
+    }
+    touched.push_back(std::move(parent));
 }
 
-void BPlusTree::redistribute_nodes(std::shared_ptr<Node> node, std::shared_ptr<Node> neighbor, int neighbor_index) {
-    // Simplified redistribution logic
-    auto parent = node->parent.lock();
-    if (neighbor_index < get_node_index(node)) { // neighbor is to the left
-        if (!node->is_leaf) {
-            node->keys.insert(node->keys.begin(), parent->keys[neighbor_index]);
-            parent->keys[neighbor_index] = neighbor->keys.back();
-            node->children.insert(node->children.begin(), neighbor->children.back());
-            neighbor->children.back()->parent = node;
-            neighbor->keys.pop_back();
-            neighbor->children.pop_back();
-        } else {
-            node->keys.insert(node->keys.begin(), neighbor->keys.back());
-            node->tids.insert(node->tids.begin(), neighbor->tids.back());
-            parent->keys[neighbor_index] = neighbor->keys.back();
-            neighbor->keys.pop_back();
-            neighbor->tids.pop_back();
+void BPlusTree::log_pages(std::vector<PinnedPage>& pages) {
+    if (!wal_writer) {
+        return;
+    }
+    std::sort(pages.begin(), pages.end(), [](const PinnedPage& a, const PinnedPage& b) { return a.id() < b.id(); });
+    for (size_t i = 0; i < pages.size(); ++i) {
+        if (i > 0 && pages[i].id() == pages[i - 1].id()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(meta_mutex, std::defer_lock);
+        if (pages[i].id() == META_PAGE) {
+            guard.lock();
         }
-    } else { // neighbor is to the right
-        // Similar logic for right neighbor
+        wal_writer("INDEX_PAGE", encode_page_image(index_file, pages[i].id(), *pages[i].page()));
     }
 }
 
-int BPlusTree::get_node_index(std::shared_ptr<Node> node) {
-    auto parent = node->parent.lock();
-    if (!parent) return -1;
-    for (size_t i = 0; i < parent->children.size(); ++i) {
-        if (parent->children[i] == node) {
-            return i;
-        }
+std::string BPlusTree::encode_page_image(const std::string& file, int page_id, const Page& page) {
+    static const char* digits = "0123456789abcdef";
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&page);
+    std::string data = file + " " + std::to_string(page_id) + " ";
+    data.reserve(data.size() + PAGE_SIZE * 2);
+    for (int i = 0; i < PAGE_SIZE; ++i) {
+        data += digits[bytes[i] >> 4];
+        data += digits[bytes[i] & 0xf];
+    }
+    return data;
+}
+
+bool BPlusTree::decode_page_image(const std::string& data, std::string& file, int& page_id, Page& page) {
+    std::stringstream ss(data);
+    std::string hex;
+    if (!(ss >> file >> page_id >> hex) || hex.size() != PAGE_SIZE * 2) {
+        return false;
+    }
+    auto nibble = [](char c) { return c <= '9' ? c - '0' : c - 'a' + 10; };
+    auto* bytes = reinterpret_cast<unsigned char*>(&page);
+    for (int i = 0; i < PAGE_SIZE; ++i) {
+        bytes[i] = static_cast<unsigned char>(nibble(hex[2 * i]) << 4 | nibble(hex[2 * i + 1]));
     }
-    return -1;
+    return true;
 }
@@ -3,51 +3,107 @@
 
 #include <vector>
 #include <string>
+#include <functional>
+#include <optional>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include "../buffer/buffer_cache.h"
+#include "index_key.h"
 
+// Heap address of an indexed tuple; the table is implied by the index
 struct Tid {
-    std::string file;
     int page_id;
     short offset;
 };
 
+// Appends one record to the WAL
+using WalWriter = std::function<void(const std::string& operation, const std::string& data)>;
+
+// B+tree whose nodes are PAGE_SIZE pages of the index file, read and written
+// through the buffer cache. Page 0 holds the meta data (root page, page
+// count, key format); every other page is a node. Entries are ordered by
+// (key, tid), so duplicate keys still have a unique position and a delete
+// finds its exact entry. Page images touched by a split are written to the WAL before any of
+// them can reach disk, so recovery can repair a split torn by a crash.
+//
+// Concurrent use follows optimistic lock coupling: every node has a version
+// latch, readers descend without writing to it and restart when a version
+// they read has changed, and writers latch only the leaf they modify, plus
+// the parent when the leaf splits. Inner nodes that might not take another
+// separator are split on the way down, so a split never propagates upwards.
 class BPlusTree {
+public:
+    // key_format only applies when the file is new; an existing index keeps its own
+    BPlusTree(BufferCache& cache, const std::string& index_file, KeyFormat key_format, WalWriter wal_writer);
+    ~BPlusTree();
+    BPlusTree(const BPlusTree&) = delete;
+    BPlusTree& operator=(const BPlusTree&) = delete;
+
+    void insert(const std::string& key, Tid tid);
+    // Entries must be sorted by (key, tid); runs that fall into one leaf are
+    // inserted after a single descent
+    void insert_sorted(const std::vector<std::pair<std::string, Tid>>& entries);
+    // Fills an empty tree bottom-up from entries sorted by (key, tid), packing
+    // each node to fill_factor percent. Not WAL-logged and not latched; the
+    // caller flushes the file before the tree is shared.
+    void bulk_load(const std::function<bool(std::pair<std::string, Tid>&)>& next, int fill_factor);
+    void remove(const std::string& key, const Tid& tid);
+    std::vector<Tid> search(const std::string& key);
+    // Entries with start_key <= key whose leading columns are <= end_key, so
+    // a key of fewer columns bounds a prefix. Without end_key the scan runs
+    // to the last leaf.
+    std::vector<Tid> search_range(const std::string& start_key, const std::optional<std::string>& end_key);
+    // As above, also returning each entry's key, for answers from the index alone
+    std::vector<Tid> search_range(const std::string& start_key, const std::optional<std::string>& end_key, std::vector<std::string>& keys);
+    const std::string& file() const { return index_file; }
+    KeyFormat key_format() const { return format; }
+
+    // Payload of an INDEX_PAGE WAL record: "<file> <page_id> <hex image>"
+    static std::string encode_page_image(const std::string& file, int page_id, const Page& page);
+    static bool decode_page_image(const std::string& data, std::string& file, int& page_id, Page& page);
+
 private:
-    struct Node {
-        bool is_leaf = false;
-        std::vector<std::string> keys;
-        std::vector<std::shared_ptr<Node>> children; // For internal nodes
-        std::vector<Tid> tids; // For leaf nodes
-        std::shared_ptr<Node> next_leaf; // For leaf nodes to link to the next leaf
-        std::weak_ptr<Node> parent;
+    struct Entry {
+        std::string key;
+        Tid tid;
+        int child; // Internal nodes: subtree holding entries >= (key, tid)
     };
 
-    std::shared_ptr<Node> root;
-    int degree;
-    BufferCache* cache;
-    std::string index_name;
+    // Version latch of a node: WRITE_LOCKED is set while a writer holds the
+    // node, and unlocking moves the version on
+    using Latch = std::atomic<uint64_t>;
 
-    // Insertion helpers
-    std::shared_ptr<Node> find_leaf(const std::string& key);
-    void insert_into_leaf(std::shared_ptr<Node> leaf, const std::string& key, Tid tid);
-    void split_leaf(std::shared_ptr<Node> leaf);
-    void insert_into_parent(std::shared_ptr<Node> left, const std::string& key, std::shared_ptr<Node> right);
-    void split_internal(std::shared_ptr<Node> node);
+    // Where a descent ended: the leaf and its parent (the meta page for the
+    // root) with the versions they were read at, and the lowest separator
+    // above the leaf's range, empty for the rightmost leaf
+    struct Descent {
+        PinnedPage parent;
+        uint64_t parent_version = 0;
+        PinnedPage leaf;
+        uint64_t leaf_version = 0;
+        std::optional<Entry> fence;
+    };
 
-    // Deletion helpers
-    void remove_entry(std::shared_ptr<Node> node, const std::string& key, const Tid& tid);
-    void coalesce_nodes(std::shared_ptr<Node> node, std::shared_ptr<Node> neighbor, int neighbor_index, const std::string& k_prime);
-    void redistribute_nodes(std::shared_ptr<Node> node, std::shared_ptr<Node> neighbor, int neighbor_index);
-    int get_node_index(std::shared_ptr<Node> node);
+    BufferCache& cache;
+    std::string index_file;
+    KeyFormat format;
+    WalWriter wal_writer;
+    std::unique_ptr<std::atomic<Latch*>[]> latch_chunks; // Allocated on first use of a page range
+    std::mutex meta_mutex; // Serializes page allocation and logging of the meta page
 
-public:
-    BPlusTree(int degree = 4);
-    BPlusTree(BufferCache& cache, const std::string& index_name);
-    void insert(const std::string& key, Tid tid);
-    void remove(const std::string& key, const Tid& tid);
-    std::vector<Tid> search(const std::string& key);
-    std::vector<Tid> search_range(const std::string& start_key, const std::string& end_key);
+    Page* get_page(int page_id) { return cache.get_page(index_file, page_id); }
+    PinnedPage pin(int page_id) { return PinnedPage(cache, index_file, page_id); }
+    Latch& latch(int page_id);
+    int allocate_page(std::vector<PinnedPage>& touched);
+    bool descend(const std::string& key, const Tid& tid, Descent& descent, bool for_insert);
+    void insert_run(const std::vector<std::pair<std::string, Tid>>& entries, size_t& i);
+    void split_full_node(Descent& descent);
+    void split_node(int parent_id, int page_id, const std::optional<Entry>& entry, std::vector<PinnedPage>& touched);
+    std::vector<Tid> scan(const std::string& start_key, const std::optional<std::string>& end_key, std::vector<std::string>* keys);
+    // Logs the images of pages the caller still holds pinned, so none of
+    // them can be written back before its image is in the WAL
+    void log_pages(std::vector<PinnedPage>& pages);
 };
 
 #endif
@@ -0,0 +1,405 @@
+#include "hash_index.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+const uint32_t HASH_MAGIC = 0x31485348; // "HSH1"
+const int META_PAGE = 0;
+const int NO_PAGE = -1;
+
+// Followed in the meta page by the ids of the directory pages
+struct HashMeta {
+    uint32_t magic;
+    KeyFormat key_format;
+    uint8_t global_depth;
+    uint16_t reserved;
+    int32_t page_count;
+    int32_t directory_pages;
+};
+
+const int DIRECTORY_FANOUT = PAGE_DATA_SIZE / sizeof(int32_t);
+const int MAX_DIRECTORY_PAGES = (PAGE_DATA_SIZE - sizeof(HashMeta)) / sizeof(int32_t);
+const int MAX_DEPTH = 32; // Slots keep 32 bits of the hash
+
+// Bucket layout inside Page::data, shared by overflow pages: header, slot
+// array growing up, key bytes growing down from the end of the page
+struct BucketHeader {
+    uint8_t local_depth; // Primary page only
+    uint8_t reserved;
+    uint16_t entry_count;
+    uint16_t heap_start;
+    uint16_t reserved2;
+    int32_t overflow; // Next page of the chain, NO_PAGE at the end
+};
+
+struct BucketSlot {
+    uint32_t hash;
+    uint16_t key_offset;
+    uint16_t key_length;
+    int32_t tid_page;
+    int16_t tid_slot;
+    uint16_t reserved;
+};
+
+const size_t BUCKET_CAPACITY = PAGE_DATA_SIZE - sizeof(BucketHeader);
+const size_t MAX_KEY_SIZE = BUCKET_CAPACITY / 4 - sizeof(BucketSlot);
+
+template <typename T>
+T read_at(const char* ptr) {
+    T value;
+    std::memcpy(&value, ptr, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void write_at(char* ptr, const T& value) {
+    std::memcpy(ptr, &value, sizeof(T));
+}
+
+HashMeta hash_meta(const Page* page) { return read_at<HashMeta>(page->data); }
+BucketHeader bucket_header(const Page* page) { return read_at<BucketHeader>(page->data); }
+void set_bucket_header(Page* page, const BucketHeader& header) { write_at(page->data, header); }
+
+BucketSlot bucket_slot(const Page* page, int i) {
+    return read_at<BucketSlot>(page->data + sizeof(BucketHeader) + i * sizeof(BucketSlot));
+}
+
+std::string_view slot_key(const Page* page, const BucketSlot& slot) {
+    return std::string_view(page->data + slot.key_offset, slot.key_length);
+}
+
+void init_bucket(Page* page, int local_depth) {
+    *page = Page();
+    set_bucket_header(page, {static_cast<uint8_t>(local_depth), 0, 0, static_cast<uint16_t>(PAGE_DATA_SIZE), 0, NO_PAGE});
+    page->dirty = true;
+}
+
+// Appends the entry if the page has room; order within a bucket does not matter
+bool add_to_page(Page* page, std::string_view key, const Tid& tid, uint32_t hash) {
+    BucketHeader header = bucket_header(page);
+    size_t slots_end = sizeof(BucketHeader) + (header.entry_count + 1) * sizeof(BucketSlot);
+    if (slots_end + key.size() > header.heap_start) {
+        return false;
+    }
+    header.heap_start -= static_cast<uint16_t>(key.size());
+    std::memcpy(page->data + header.heap_start, key.data(), key.size());
+    BucketSlot slot = {hash, header.heap_start, static_cast<uint16_t>(key.size()), tid.page_id, tid.offset, 0};
+    write_at(page->data + sizeof(BucketHeader) + header.entry_count * sizeof(BucketSlot), slot);
+    header.entry_count++;
+    set_bucket_header(page, header);
+    page->dirty = true;
+    return true;
+}
+
+// FNV-1a followed by a finalizer, since the directory indexes by the low bits
+uint32_t hash_key(std::string_view key) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return static_cast<uint32_t>(h);
+}
+
+uint32_t low_bits(uint32_t hash, int depth) {
+    return depth >= MAX_DEPTH ? hash : hash & ((1u << depth) - 1);
+}
+}
+
+HashIndex::HashIndex(BufferCache& cache, const std::string& index_file, KeyFormat key_format, WalWriter wal_writer)
+    : cache(cache), index_file(index_file), format(key_format), wal_writer(std::move(wal_writer)) {
+    if (!std::filesystem::exists(index_file)) {
+        std::ofstream create(index_file, std::ios::binary);
+        if (!create) {
+            throw std::runtime_error("Could not create index file: " + index_file);
+        }
+    }
+
+    PinnedPage meta = pin(META_PAGE);
+    HashMeta info = hash_meta(meta.page());
+    if (info.magic == HASH_MAGIC) {
+        format = info.key_format;
+        return; // Existing index, usable as is
+    }
+
+    // New index: a one-entry directory on page 1 pointing at an empty bucket on page 2
+    write_at(meta.page()->data, HashMeta{HASH_MAGIC, format, 0, 0, 3, 1});
+    write_at<int32_t>(meta.page()->data + sizeof(HashMeta), 1);
+    meta.page()->dirty = true;
+    PinnedPage directory = pin(1);
+    *directory.page() = Page();
+    write_at<int32_t>(directory.page()->data, 2);
+    directory.page()->dirty = true;
+    PinnedPage bucket = pin(2);
+    init_bucket(bucket.page(), 0);
+    log_pages({META_PAGE, 1, 2});
+}
+
+void HashIndex::insert(const std::string& key, Tid tid) {
+    insert_sorted({{key, tid}});
+}
+
+void HashIndex::insert_sorted(const std::vector<std::pair<std::string, Tid>>& entries) {
+    for (const auto& [key, tid] : entries) {
+        if (key.size() > MAX_KEY_SIZE) {
+            throw std::runtime_error("Index key exceeds " + std::to_string(MAX_KEY_SIZE) + " bytes.");
+        }
+    }
+    std::unique_lock<std::shared_mutex> guard(latch);
+    for (const auto& [key, tid] : entries) {
+        insert_entry(key, tid);
+    }
+}
+
+// Called with the latch held exclusively
+void HashIndex::insert_entry(const std::string& key, const Tid& tid) {
+    uint32_t hash = hash_key(key);
+    while (true) {
+        int bucket_id = bucket_for(hash);
+        int last_id = bucket_id;
+        for (int page_id = bucket_id; page_id != NO_PAGE;) {
+            PinnedPage page = pin(page_id);
+            if (add_to_page(page.page(), key, tid, hash)) {
+                return;
+            }
+            last_id = page_id;
+            page_id = bucket_header(page.page()).overflow;
+        }
+
+        std::vector<int> touched;
+        if (split_bucket(bucket_id, hash, touched)) {
+            log_pages(touched);
+            continue;
+        }
+
+        // Splitting would not make room: no entry differs from hash in the
+        // next bit, or the directory is at its size limit
+        int overflow_id = allocate_page(touched);
+        PinnedPage overflow = pin(overflow_id);
+        init_bucket(overflow.page(), 0);
+        add_to_page(overflow.page(), key, tid, hash);
+        PinnedPage last = pin(last_id);
+        BucketHeader header = bucket_header(last.page());
+        header.overflow = overflow_id;
+        set_bucket_header(last.page(), header);
+        last.page()->dirty = true;
+        touched.push_back(overflow_id);
+        touched.push_back(last_id);
+        log_pages(touched);
+        return;
+    }
+}
+
+void HashIndex::remove(const std::string& key, const Tid& tid) {
+    std::unique_lock<std::shared_mutex> guard(latch);
+    uint32_t hash = hash_key(key);
+    for (int page_id = bucket_for(hash); page_id != NO_PAGE;) {
+        PinnedPage bucket = pin(page_id);
+        Page* page = bucket.page();
+        BucketHeader header = bucket_header(page);
+        for (int i = 0; i < header.entry_count; ++i) {
+            BucketSlot slot = bucket_slot(page, i);
+            if (slot.hash != hash || slot.tid_page != tid.page_id || slot.tid_slot != tid.offset || slot_key(page, slot) != key) {
+                continue;
+            }
+            // Rewrite the page so the key bytes are reclaimed along with the slot
+            std::vector<Entry> kept;
+            for (int j = 0; j < header.entry_count; ++j) {
+                if (j == i) continue;
+                BucketSlot other = bucket_slot(page, j);
+                kept.push_back({std::string(slot_key(page, other)), {other.tid_page, other.tid_slot}, other.hash});
+            }
+            int overflow = header.overflow;
+            init_bucket(page, header.local_depth);
+            header = bucket_header(page);
+            header.overflow = overflow;
+            set_bucket_header(page, header);
+            for (const auto& entry : kept) {
+                add_to_page(page, entry.key, entry.tid, entry.hash);
+            }
+            return;
+        }
+        page_id = header.overflow;
+    }
+}
+
+std::vector<Tid> HashIndex::search(const std::string& key) {
+    std::shared_lock<std::shared_mutex> guard(latch);
+    uint32_t hash = hash_key(key);
+    std::vector<Tid> results;
+    for (int page_id = bucket_for(hash); page_id != NO_PAGE;) {
+        PinnedPage bucket = pin(page_id);
+        const Page* page = bucket.page();
+        BucketHeader header = bucket_header(page);
+        for (int i = 0; i < header.entry_count; ++i) {
+            BucketSlot slot = bucket_slot(page, i);
+            if (slot.hash == hash && slot_key(page, slot) == key) {
+                results.push_back({slot.tid_page, slot.tid_slot});
+            }
+        }
+        page_id = header.overflow;
+    }
+    return results;
+}
+
+int HashIndex::allocate_page(std::vector<int>& touched) {
+    PinnedPage meta = pin(META_PAGE);
+    HashMeta info = hash_meta(meta.page());
+    int page_id = info.page_count++;
+    write_at(meta.page()->data, info);
+    meta.page()->dirty = true;
+    touched.push_back(META_PAGE);
+    return page_id;
+}
+
+int HashIndex::directory_entry(int index) {
+    PinnedPage meta = pin(META_PAGE);
+    int directory_id = read_at<int32_t>(meta.page()->data + sizeof(HashMeta) + index / DIRECTORY_FANOUT * sizeof(int32_t));
+    PinnedPage directory = pin(directory_id);
+    return read_at<int32_t>(directory.page()->data + index % DIRECTORY_FANOUT * sizeof(int32_t));
+}
+
+// Adds directory pages as the directory grows into them
+void HashIndex::set_directory_entry(int index, int bucket_id, std::vector<int>& touched) {
+    PinnedPage meta = pin(META_PAGE);
+    while (index / DIRECTORY_FANOUT >= hash_meta(meta.page()).directory_pages) {
+        int page_id = allocate_page(touched);
+        PinnedPage directory = pin(page_id);
+        *directory.page() = Page();
+        directory.page()->dirty = true;
+        HashMeta info = hash_meta(meta.page());
+        write_at<int32_t>(meta.page()->data + sizeof(HashMeta) + info.directory_pages * sizeof(int32_t), page_id);
+        info.directory_pages++;
+        write_at(meta.page()->data, info);
+        touched.push_back(page_id);
+    }
+    int directory_id = read_at<int32_t>(meta.page()->data + sizeof(HashMeta) + index / DIRECTORY_FANOUT * sizeof(int32_t));
+    PinnedPage directory = pin(directory_id);
+    write_at<int32_t>(directory.page()->data + index % DIRECTORY_FANOUT * sizeof(int32_t), bucket_id);
+    directory.page()->dirty = true;
+    touched.push_back(directory_id);
+}
+
+int HashIndex::bucket_for(uint32_t hash) {
+    PinnedPage meta = pin(META_PAGE);
+    return directory_entry(low_bits(hash, hash_meta(meta.page()).global_depth));
+}
+
+// Splits the bucket that hash maps to on the next bit of the hash. Returns
+// false when that would not make room for hash.
+bool HashIndex::split_bucket(int bucket_id, uint32_t hash, std::vector<int>& touched) {
+    std::vector<Entry> entries;
+    std::vector<int> chain_pages;
+    int local_depth = 0;
+    for (int page_id = bucket_id; page_id != NO_PAGE;) {
+        PinnedPage bucket = pin(page_id);
+        const Page* page = bucket.page();
+        BucketHeader header = bucket_header(page);
+        if (page_id == bucket_id) {
+            local_depth = header.local_depth;
+        } else {
+            chain_pages.push_back(page_id);
+        }
+        for (int i = 0; i < header.entry_count; ++i) {
+            BucketSlot slot = bucket_slot(page, i);
+            entries.push_back({std::string(slot_key(page, slot)), {slot.tid_page, slot.tid_slot}, slot.hash});
+        }
+        page_id = header.overflow;
+    }
+
+    // A split that would leave every entry on hash's side only grows the
+    // directory; a chain is cheaper, and stops equal hashes splitting forever
+    if (local_depth >= MAX_DEPTH) {
+        return false;
+    }
+    uint32_t bit = 1u << local_depth;
+    if (std::none_of(entries.begin(), entries.end(), [&](const Entry& e) { return ((e.hash ^ hash) & bit) != 0; })) {
+        return false;
+    }
+    int global_depth;
+    {
+        PinnedPage meta = pin(META_PAGE);
+        global_depth = hash_meta(meta.page()).global_depth;
+    }
+    if (local_depth == global_depth) {
+        if (global_depth >= MAX_DEPTH || (2LL << global_depth) > static_cast<long long>(MAX_DIRECTORY_PAGES) * DIRECTORY_FANOUT) {
+            return false;
+        }
+        double_directory(touched);
+        global_depth++;
+    }
+
+    // Entries with the new bit set move to the new bucket; the old chain's
+    // overflow pages are reused for either half, and any left over stay unused
+    std::vector<Entry> stay, moved;
+    for (auto& entry : entries) {
+        (entry.hash & bit ? moved : stay).push_back(std::move(entry));
+    }
+    int new_id = allocate_page(touched);
+    std::reverse(chain_pages.begin(), chain_pages.end());
+    write_chain(bucket_id, local_depth + 1, stay, chain_pages, touched);
+    write_chain(new_id, local_depth + 1, moved, chain_pages, touched);
+
+    for (uint64_t i = low_bits(hash, local_depth) | bit; i < (1ull << global_depth); i += 2ull * bit) {
+        set_directory_entry(static_cast<int>(i), new_id, touched);
+    }
+    return true;
+}
+
+// Copies the directory behind itself, so each bucket gains a second entry
+void HashIndex::double_directory(std::vector<int>& touched) {
+    PinnedPage meta = pin(META_PAGE);
+    int size = 1 << hash_meta(meta.page()).global_depth;
+    for (int i = 0; i < size; ++i) {
+        set_directory_entry(size + i, directory_entry(i), touched);
+    }
+    HashMeta info = hash_meta(meta.page());
+    info.global_depth++;
+    write_at(meta.page()->data, info);
+    meta.page()->dirty = true;
+}
+
+void HashIndex::write_chain(int bucket_id, int local_depth, const std::vector<Entry>& entries, std::vector<int>& free_pages, std::vector<int>& touched) {
+    PinnedPage page = pin(bucket_id);
+    init_bucket(page.page(), local_depth);
+    touched.push_back(bucket_id);
+    for (const auto& entry : entries) {
+        if (add_to_page(page.page(), entry.key, entry.tid, entry.hash)) {
+            continue;
+        }
+        int next_id;
+        if (free_pages.empty()) {
+            next_id = allocate_page(touched);
+        } else {
+            next_id = free_pages.back();
+            free_pages.pop_back();
+        }
+        BucketHeader header = bucket_header(page.page());
+        header.overflow = next_id;
+        set_bucket_header(page.page(), header);
+        page = pin(next_id);
+        init_bucket(page.page(), 0);
+        add_to_page(page.page(), entry.key, entry.tid, entry.hash);
+        touched.push_back(next_id);
+    }
+}
+
+void HashIndex::log_pages(std::vector<int> page_ids) {
+    if (!wal_writer) {
+        return;
+    }
+    std::sort(page_ids.begin(), page_ids.end());
+    page_ids.erase(std::unique(page_ids.begin(), page_ids.end()), page_ids.end());
+    for (int page_id : page_ids) {
+        PinnedPage page = pin(page_id);
+        wal_writer("INDEX_PAGE", BPlusTree::encode_page_image(index_file, page_id, *page.page()));
+    }
+}
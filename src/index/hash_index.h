@@ -0,0 +1,54 @@
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include <vector>
+#include <string>
+#include <shared_mutex>
+#include "../buffer/buffer_cache.h"
+#include "bplus_tree.h"
+#include "index_key.h"
+
+// Extendible hash index for equality lookups, stored in buffer-cache pages of
+// the index file. Page 0 holds the meta data and the list of directory
+// pages; the directory maps the low global_depth bits of a key's hash to a
+// bucket page. A full bucket splits on its own, doubling the directory only
+// when its local depth has caught up with the global depth, so no insert
+// ever rehashes the whole index. Entries that share one hash and no longer
+// fit their bucket go to a chain of overflow pages.
+class HashIndex {
+public:
+    // key_format only applies when the file is new; an existing index keeps its own
+    HashIndex(BufferCache& cache, const std::string& index_file, KeyFormat key_format, WalWriter wal_writer);
+    void insert(const std::string& key, Tid tid);
+    void insert_sorted(const std::vector<std::pair<std::string, Tid>>& entries);
+    void remove(const std::string& key, const Tid& tid);
+    std::vector<Tid> search(const std::string& key);
+    const std::string& file() const { return index_file; }
+    KeyFormat key_format() const { return format; }
+
+private:
+    struct Entry {
+        std::string key;
+        Tid tid;
+        uint32_t hash;
+    };
+
+    BufferCache& cache;
+    std::string index_file;
+    KeyFormat format;
+    WalWriter wal_writer;
+    std::shared_mutex latch; // Shared for probes, exclusive for changes
+
+    PinnedPage pin(int page_id) { return PinnedPage(cache, index_file, page_id); }
+    void insert_entry(const std::string& key, const Tid& tid);
+    int allocate_page(std::vector<int>& touched);
+    int directory_entry(int index);
+    void set_directory_entry(int index, int bucket_id, std::vector<int>& touched);
+    int bucket_for(uint32_t hash);
+    bool split_bucket(int bucket_id, uint32_t hash, std::vector<int>& touched);
+    void double_directory(std::vector<int>& touched);
+    void write_chain(int bucket_id, int local_depth, const std::vector<Entry>& entries, std::vector<int>& free_pages, std::vector<int>& touched);
+    void log_pages(std::vector<int> page_ids);
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include "index_key.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+const char TAG_VALUE = 0x01;
+const char TAG_NULL = 0x02;
+const int64_t INT64_NULL = std::numeric_limits<int64_t>::max();
+}
+
+KeyFormat key_format_for(const std::vector<DataType>& column_types) {
+    for (DataType type : column_types) {
+        if (type != DataType::INT) {
+            return KeyFormat::BYTES;
+        }
+    }
+    return KeyFormat::INT64;
+}
+
+std::string encode_index_key(const std::vector<Value>& values, KeyFormat format) {
+    std::string key;
+    if (format == KeyFormat::INT64) {
+        key.resize(values.size() * sizeof(int64_t));
+        for (size_t i = 0; i < values.size(); ++i) {
+            int64_t v = values[i].type == DataType::INT ? values[i].int_value : INT64_NULL;
+            std::memcpy(&key[i * sizeof(int64_t)], &v, sizeof(int64_t));
+        }
+        return key;
+    }
+
+    for (const auto& value : values) {
+        if (value.type == DataType::NULL_TYPE) {
+            key += TAG_NULL;
+            continue;
+        }
+        key += TAG_VALUE;
+        if (value.type == DataType::INT) {
+            uint32_t bits = static_cast<uint32_t>(value.int_value) ^ 0x80000000u;
+            for (int shift = 24; shift >= 0; shift -= 8) {
+                key += static_cast<char>((bits >> shift) & 0xff);
+            }
+        } else {
+            for (char c : value.str_value) {
+                key += c;
+                if (c == '\0') key += '\xff';
+            }
+            key += '\0';
+            key += '\x01';
+        }
+    }
+    return key;
+}
+
+std::vector<Value> decode_index_key(std::string_view key, const std::vector<DataType>& types, KeyFormat format) {
+    std::vector<Value> values;
+    values.reserve(types.size());
+    size_t pos = 0;
+    for (DataType type : types) {
+        if (format == KeyFormat::INT64) {
+            int64_t v = 0;
+            if (pos + sizeof(int64_t) <= key.size()) {
+                std::memcpy(&v, key.data() + pos, sizeof(int64_t));
+            }
+            pos += sizeof(int64_t);
+            values.push_back(v == INT64_NULL ? Value() : Value(static_cast<int>(v)));
+            continue;
+        }
+
+        if (pos >= key.size() || key[pos++] == TAG_NULL) {
+            values.emplace_back();
+            continue;
+        }
+        if (type == DataType::INT) {
+            uint32_t bits = 0;
+            for (int i = 0; i < 4 && pos < key.size(); ++i) {
+                bits = bits << 8 | static_cast<uint8_t>(key[pos++]);
+            }
+            values.push_back(Value(static_cast<int>(bits ^ 0x80000000u)));
+        } else {
+            std::string str;
+            while (pos < key.size()) {
+                char c = key[pos++];
+                if (c == '\0') {
+                    // 0x00 0xFF is an escaped 0x00, 0x00 0x01 the terminator
+                    if (pos < key.size() && key[pos++] == '\xff') {
+                        str += '\0';
+                        continue;
+                    }
+                    break;
+                }
+                str += c;
+            }
+            values.push_back(Value(str));
+        }
+    }
+    return values;
+}
+
+int compare_index_keys(std::string_view a, std::string_view b, KeyFormat format) {
+    if (format == KeyFormat::BYTES) {
+        int cmp = a.compare(b);
+        return cmp < 0 ? -1 : (cmp > 0 ? 1 : 0);
+    }
+    size_t count = std::min(a.size(), b.size()) / sizeof(int64_t);
+    for (size_t i = 0; i < count; ++i) {
+        int64_t x, y;
+        std::memcpy(&x, a.data() + i * sizeof(int64_t), sizeof(int64_t));
+        std::memcpy(&y, b.data() + i * sizeof(int64_t), sizeof(int64_t));
+        if (x != y) return x < y ? -1 : 1;
+    }
+    // A prefix sorts first, so the empty key is the lowest bound
+    if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+    return 0;
+}
@@ -0,0 +1,31 @@
+#ifndef INDEX_KEY_H
+#define INDEX_KEY_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "../common/value.h"
+
+// How an index stores its keys. BYTES keys compare with memcmp; INT64 keys
+// are native 64-bit integers, one per column, compared as integers.
+enum class KeyFormat : uint8_t {
+    BYTES = 0,
+    INT64 = 1
+};
+
+// INT64 when every key column is INT, BYTES otherwise
+KeyFormat key_format_for(const std::vector<DataType>& column_types);
+
+// BYTES: per column a tag byte (NULL sorts last), then INT as big-endian
+// with the sign bit flipped, or STRING with 0x00 escaped as 0x00 0xFF and
+// terminated by 0x00 0x01, so concatenated columns still compare bytewise.
+// INT64: per column the native value, with NULL as INT64_MAX.
+std::string encode_index_key(const std::vector<Value>& values, KeyFormat format);
+
+int compare_index_keys(std::string_view a, std::string_view b, KeyFormat format);
+
+// Inverse of encode_index_key for the leading types.size() columns of key
+std::vector<Value> decode_index_key(std::string_view key, const std::vector<DataType>& types, KeyFormat format);
+
+#endif
@@ -0,0 +1,133 @@
+#include "index_sorter.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+
+IndexSorter::IndexSorter(KeyFormat format, size_t memory_budget, const std::string& run_prefix, int workers)
+    : format(format), memory_budget(memory_budget), run_prefix(run_prefix), workers(std::max(1, workers)) {}
+
+IndexSorter::~IndexSorter() {
+    runs.clear();
+    for (const auto& file : run_files) {
+        std::remove(file.c_str());
+    }
+}
+
+void IndexSorter::add(std::string key, Tid tid) {
+    buffer_bytes += sizeof(IndexEntry) + key.size();
+    buffer.emplace_back(std::move(key), tid);
+    if (buffer_bytes >= memory_budget) {
+        spill();
+    }
+}
+
+void IndexSorter::finish() {
+    if (run_files.empty()) {
+        sort_buffer();
+        return;
+    }
+    if (!buffer.empty()) {
+        spill();
+    }
+    for (size_t i = 0; i < run_files.size(); ++i) {
+        runs.push_back(std::make_unique<std::ifstream>(run_files[i], std::ios::binary));
+        IndexEntry entry;
+        if (read_entry(*runs[i], entry)) {
+            heads.push_back({std::move(entry), i});
+        }
+    }
+    auto greater = [this](const RunHead& a, const RunHead& b) { return less(b.entry, a.entry); };
+    std::make_heap(heads.begin(), heads.end(), greater);
+}
+
+bool IndexSorter::next(IndexEntry& entry) {
+    if (runs.empty()) {
+        if (buffer_pos == buffer.size()) return false;
+        entry = std::move(buffer[buffer_pos++]);
+        return true;
+    }
+
+    if (heads.empty()) return false;
+    auto greater = [this](const RunHead& a, const RunHead& b) { return less(b.entry, a.entry); };
+    std::pop_heap(heads.begin(), heads.end(), greater);
+    RunHead& head = heads.back();
+    entry = std::move(head.entry);
+    if (read_entry(*runs[head.run], head.entry)) {
+        std::push_heap(heads.begin(), heads.end(), greater);
+    } else {
+        heads.pop_back();
+    }
+    return true;
+}
+
+bool IndexSorter::less(const IndexEntry& a, const IndexEntry& b) const {
+    int cmp = compare_index_keys(a.first, b.first, format);
+    if (cmp != 0) return cmp < 0;
+    if (a.second.page_id != b.second.page_id) return a.second.page_id < b.second.page_id;
+    return a.second.offset < b.second.offset;
+}
+
+// Each worker sorts one slice, then neighbouring slices are merged pairwise,
+// again one pair per thread, until a single sorted range is left
+void IndexSorter::sort_buffer() {
+    auto cmp = [this](const IndexEntry& a, const IndexEntry& b) { return less(a, b); };
+    size_t slices = std::min<size_t>(workers, buffer.size() / 1024 + 1);
+    std::vector<size_t> bounds;
+    for (size_t i = 0; i <= slices; ++i) {
+        bounds.push_back(buffer.size() * i / slices);
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+        threads.emplace_back([&, i] { std::sort(buffer.begin() + bounds[i], buffer.begin() + bounds[i + 1], cmp); });
+    }
+    for (auto& t : threads) t.join();
+
+    while (bounds.size() > 2) {
+        threads.clear();
+        std::vector<size_t> merged;
+        for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+            merged.push_back(bounds[i]);
+            if (i + 2 < bounds.size()) {
+                threads.emplace_back([&, i] {
+                    std::inplace_merge(buffer.begin() + bounds[i], buffer.begin() + bounds[i + 1], buffer.begin() + bounds[i + 2], cmp);
+                });
+            }
+        }
+        for (auto& t : threads) t.join();
+        merged.push_back(bounds.back());
+        bounds = merged;
+    }
+}
+
+void IndexSorter::spill() {
+    sort_buffer();
+    std::string file = run_prefix + std::to_string(run_files.size());
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Could not create sort run file: " + file);
+    }
+    run_files.push_back(file);
+    for (const auto& [key, tid] : buffer) {
+        uint32_t length = static_cast<uint32_t>(key.size());
+        out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        out.write(key.data(), length);
+        out.write(reinterpret_cast<const char*>(&tid.page_id), sizeof(tid.page_id));
+        out.write(reinterpret_cast<const char*>(&tid.offset), sizeof(tid.offset));
+    }
+    buffer.clear();
+    buffer_bytes = 0;
+}
+
+bool IndexSorter::read_entry(std::ifstream& in, IndexEntry& entry) {
+    uint32_t length;
+    if (!in.read(reinterpret_cast<char*>(&length), sizeof(length))) {
+        return false;
+    }
+    entry.first.resize(length);
+    in.read(&entry.first[0], length);
+    in.read(reinterpret_cast<char*>(&entry.second.page_id), sizeof(entry.second.page_id));
+    in.read(reinterpret_cast<char*>(&entry.second.offset), sizeof(entry.second.offset));
+    return static_cast<bool>(in);
+}
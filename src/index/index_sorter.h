@@ -0,0 +1,48 @@
+#ifndef INDEX_SORTER_H
+#define INDEX_SORTER_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <memory>
+#include "bplus_tree.h"
+
+// Sorts (key, tid) entries for a bulk index build. Entries are buffered
+// until memory_budget is used up, then the buffer is sorted by worker
+// threads and spilled to a run file; next() merges the runs back in order.
+class IndexSorter {
+public:
+    using IndexEntry = std::pair<std::string, Tid>;
+
+    IndexSorter(KeyFormat format, size_t memory_budget, const std::string& run_prefix, int workers);
+    ~IndexSorter(); // Removes the run files
+
+    void add(std::string key, Tid tid);
+    void finish(); // Call once after the last add
+    bool next(IndexEntry& entry);
+
+private:
+    struct RunHead {
+        IndexEntry entry;
+        size_t run;
+    };
+
+    KeyFormat format;
+    size_t memory_budget;
+    std::string run_prefix;
+    int workers;
+
+    std::vector<IndexEntry> buffer;
+    size_t buffer_bytes = 0;
+    size_t buffer_pos = 0;
+    std::vector<std::string> run_files;
+    std::vector<std::unique_ptr<std::ifstream>> runs;
+    std::vector<RunHead> heads; // Min-heap over the next entry of each run
+
+    bool less(const IndexEntry& a, const IndexEntry& b) const;
+    void sort_buffer();
+    void spill();
+    static bool read_entry(std::ifstream& in, IndexEntry& entry);
+};
+
+#endif
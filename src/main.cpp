@@ -1,6 +1,7 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <optional>
 #include "storage/storage_engine.h"
 #include "parser/sql_parser.h"
 #include "executor/query_executor.h"
@@ -12,29 +13,22 @@
 // #define DEBUG_AST
 // #define DEBUG_PLAN
 
-void print_result_set(const ResultSet& rs) {
-    for (const auto& col : rs.columns) {
-        std::cout << col << "\t";
-    }
-    std::cout << std::endl;
-    for (const auto& row : rs.rows) {
-        for (const auto& val : row) {
-            std::cout << to_string(val) << "\t";
-        }
-        std::cout << std::endl;
-    }
-}
-
 int main() {
     BufferCache cache(100);
     StorageEngine storage(cache);
     cache.set_storage_engine(&storage);
     TransactionManager tx_manager(&storage);
     Optimizer optimizer(storage);
+    Settings settings;
+    // Results go through one large buffer; std::cout is flushed by reading
+    // std::cin or writing std::cerr, both tied to it
+    OutputBuffer output(std::cout);
 
     std::cout << "wesql DB. Enter SQL or 'exit' to quit." << std::endl;
 
     bool in_transaction = false;
+    bool read_only_transaction = false; // No xid is allocated for these
+    Snapshot read_only_snapshot; // Taken at BEGIN READ ONLY and used by all its statements
     int current_tx_id = 0;
 
     std::string sql_query;
@@ -50,7 +44,7 @@ int main() {
         // Allow canceling a multi-line query
         if (sql_line == "exit") {
             sql_query.clear();
-            std::cout << "Query canceled." << std::endl;
+            std::cout << "Query canceled.\n";
             continue;
         }
         
@@ -65,6 +59,8 @@ int main() {
             continue; // Not a complete statement, get more input
         }
 
+        int autocommit_tx_id = 0;
+        std::optional<Snapshot> statement_snapshot; // Registered for an auto-commit SELECT
         try {
             auto ast = parse_sql(sql_query);
 
@@ -72,37 +68,66 @@ int main() {
             print_ast(ast);
 #endif
 
-            if (ast.type == "BEGIN" || ast.type == "COMMIT" || ast.type == "ROLLBACK") {
+            if (ast.type == "SET") {
+                for (const auto& [name, value] : ast.set_clause) {
+                    settings.set(name, value);
+                }
+                tx_manager.set_lock_timeout(std::chrono::milliseconds(settings.lock_timeout));
+                std::cout << "SET\n";
+            } else if (ast.type == "BEGIN" || ast.type == "COMMIT" || ast.type == "ROLLBACK") {
                  // Handle transaction commands directly
                 if (ast.type == "BEGIN") {
                     if (in_transaction) {
                         throw std::runtime_error("Already in a transaction block.");
                     }
-                    current_tx_id = tx_manager.start_transaction();
+                    read_only_transaction = ast.read_only;
+                    current_tx_id = read_only_transaction ? 0 : tx_manager.start_transaction();
+                    if (read_only_transaction) {
+                        read_only_snapshot = tx_manager.register_snapshot();
+                    }
                     in_transaction = true;
                 } else if (ast.type == "COMMIT") {
                     if (!in_transaction) {
                         throw std::runtime_error("Not in a transaction block.");
                     }
-                    tx_manager.commit(current_tx_id);
+                    if (read_only_transaction) {
+                        tx_manager.release_snapshot(read_only_snapshot);
+                    } else {
+                        tx_manager.commit(current_tx_id);
+                    }
                     in_transaction = false;
+                    read_only_transaction = false;
                     current_tx_id = 0;
                 } else { // ROLLBACK
                     if (!in_transaction) {
                         throw std::runtime_error("Not in a transaction block.");
                     }
-                    tx_manager.rollback(current_tx_id);
+                    if (read_only_transaction) {
+                        tx_manager.release_snapshot(read_only_snapshot);
+                    } else {
+                        tx_manager.rollback(current_tx_id);
+                    }
                     in_transaction = false;
+                    read_only_transaction = false;
                     current_tx_id = 0;
                 }
                 // We can create a dummy plan for execution or handle in executor
                 auto plan = std::make_shared<LogicalPlanNode>(LogicalOperatorType::CREATE_TABLE); // Dummy
                 plan->table_name = ast.type; // Pass command type
-                execute_plan(plan, storage, tx_manager, 0, {});
+                execute_plan(plan, storage, tx_manager, 0, {}, settings, *make_result_sink(settings.output_format, output));
 
             } else {
-                // Auto-commit mode or inside a transaction
-                int tx_id_for_query = in_transaction ? current_tx_id : tx_manager.start_transaction();
+                // Auto-commit mode or inside a transaction. A SELECT on its
+                // own needs no xid: it only takes a snapshot, and has no WAL
+                // record or dirty pages to flush at the end.
+                bool read_only_statement = ast.type == "SELECT";
+                if (read_only_transaction && !read_only_statement) {
+                    throw std::runtime_error("Cannot execute " + ast.type + " in a read-only transaction.");
+                }
+                if (!in_transaction && !read_only_statement) {
+                    autocommit_tx_id = tx_manager.start_transaction();
+                }
+                int tx_id_for_query = in_transaction ? current_tx_id : autocommit_tx_id;
                 
                 auto logical_plan = optimizer.optimize(ast);
 
@@ -110,20 +135,45 @@ int main() {
                 print_logical_plan(logical_plan);
 #endif
 
-                auto snapshot = tx_manager.get_snapshot(tx_id_for_query);
-                ResultSet rs = execute_plan(logical_plan, storage, tx_manager, tx_id_for_query, snapshot);
-                print_result_set(rs);
+                Snapshot snapshot;
+                if (read_only_transaction) {
+                    snapshot = read_only_snapshot;
+                } else if (tx_id_for_query == 0) {
+                    statement_snapshot = tx_manager.register_snapshot();
+                    snapshot = *statement_snapshot;
+                } else {
+                    snapshot = tx_manager.get_snapshot(tx_id_for_query);
+                }
+                execute_plan(logical_plan, storage, tx_manager, tx_id_for_query, snapshot, settings, *make_result_sink(settings.output_format, output));
 
-                if (!in_transaction) {
-                    tx_manager.commit(tx_id_for_query);
+                if (statement_snapshot) {
+                    tx_manager.release_snapshot(*statement_snapshot);
+                    statement_snapshot.reset();
+                }
+                if (autocommit_tx_id != 0) {
+                    tx_manager.commit(autocommit_tx_id);
+                    autocommit_tx_id = 0;
                 }
             }
         } catch (const std::exception& e) {
+            output.flush(); // Rows of a failed query that are already out stay ahead of the error
             std::cerr << "Error: " << e.what() << std::endl;
+            if (autocommit_tx_id != 0) {
+                // A failed auto-commit statement must not keep its locks
+                tx_manager.rollback(autocommit_tx_id);
+            }
+            if (statement_snapshot) {
+                tx_manager.release_snapshot(*statement_snapshot);
+            }
             if (in_transaction) {
                 std::cerr << "Rolling back current transaction." << std::endl;
-                tx_manager.rollback(current_tx_id);
+                if (read_only_transaction) {
+                    tx_manager.release_snapshot(read_only_snapshot);
+                } else {
+                    tx_manager.rollback(current_tx_id);
+                }
                 in_transaction = false;
+                read_only_transaction = false;
                 current_tx_id = 0;
             }
         }
@@ -132,5 +182,6 @@ int main() {
     }
     cache.flush_all();
     cache.print_stats();
+    tx_manager.print_lock_stats();
     return 0;
 }
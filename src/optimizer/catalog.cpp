@@ -49,3 +49,17 @@ TableSchema Catalog::get_table_schema(const std::string& table_name) {
         throw std::runtime_error("Table '" + table_name + "' not found.");
     }
 }
+
+std::string Catalog::find_index(const std::string& table_name, const std::vector<WhereCondition>& conditions, size_t& matched) {
+    if (!storage_engine_) {
+        return "";
+    }
+    return storage_engine_->find_index(table_name, conditions, matched);
+}
+
+std::vector<std::string> Catalog::index_columns(const std::string& index_name) {
+    if (!storage_engine_) {
+        return {};
+    }
+    return storage_engine_->index_columns(index_name);
+}
@@ -23,6 +23,10 @@ public:
     bool table_exists(const std::string& table_name);
     void create_table(const TableSchema& schema);
     TableSchema get_table_schema(const std::string& table_name);
+    // Index best bounded by conditions, with the number of its leading key
+    // columns the lookup uses; empty when none
+    std::string find_index(const std::string& table_name, const std::vector<WhereCondition>& conditions, size_t& matched);
+    std::vector<std::string> index_columns(const std::string& index_name); // Columns an index scan can return without the heap
 
 private:
     StorageEngine* storage_engine_;
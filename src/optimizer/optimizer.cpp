@@ -1,4 +1,6 @@
 #include "optimizer.h"
+#include <algorithm>
+#include <iterator>
 
 std::shared_ptr<LogicalPlanNode> Optimizer::optimize(ASTNode& ast) {
     // First, run semantic analysis
@@ -7,7 +9,272 @@ std::shared_ptr<LogicalPlanNode> Optimizer::optimize(ASTNode& ast) {
     // Second, create a logical plan
     auto logical_plan = plan_generator_.create_plan(ast);
 
-    // Third, optimize the logical plan (placeholder)
-
+    // Third, optimize the logical plan
+    logical_plan = choose_access_path(logical_plan);
+    prune_join_inputs(logical_plan, {}, true);
     return logical_plan;
-}
\ No newline at end of file
+}
+
+// A scan in a join outputs qualified column names but reads its table by
+// the bare ones
+static std::vector<WhereCondition> table_conditions(const std::vector<WhereCondition>& conditions, const std::string& alias) {
+    std::vector<WhereCondition> result = conditions;
+    if (!alias.empty()) {
+        for (auto& cond : result) {
+            cond.column = cond.column.substr(alias.size() + 1);
+        }
+    }
+    return result;
+}
+
+static std::string qualifier_of(const std::string& column) {
+    return column.substr(0, column.find('.'));
+}
+
+// Replaces SEQ_SCAN + FILTER with INDEX_SCAN when an index's leading key
+// columns are bound by the filter: equalities on a prefix of them, possibly
+// followed by a range on the next one. Conditions on those columns go to the
+// scan; the rest stay behind in the FILTER. Without a usable index the whole
+// FILTER moves into the SEQ_SCAN, which tests it before decoding rows.
+std::shared_ptr<LogicalPlanNode> Optimizer::choose_access_path(std::shared_ptr<LogicalPlanNode> node) {
+    for (auto& child : node->children) {
+        child = choose_access_path(child);
+    }
+    if (node->type == LogicalOperatorType::PROJECTION || node->type == LogicalOperatorType::AGGREGATE) {
+        std::vector<std::string> columns;
+        if (columns_read(node, columns)) {
+            // A sort passes its input through, reading its keys as well
+            std::shared_ptr<LogicalPlanNode> reader = node;
+            while (reader->children.size() == 1 && reader->children[0]->type == LogicalOperatorType::SORT) {
+                reader = reader->children[0];
+                for (const auto& key : reader->sort_keys) {
+                    columns.push_back(key.column);
+                }
+            }
+            choose_index_only(reader, columns);
+            prune_scan_columns(reader, columns);
+        }
+        return node;
+    }
+    if (node->type == LogicalOperatorType::JOIN) {
+        choose_join_method(node);
+        return node;
+    }
+    if (node->type != LogicalOperatorType::FILTER || node->children.size() != 1 ||
+        node->children[0]->type != LogicalOperatorType::SEQ_SCAN) {
+        return node;
+    }
+
+    const std::string& table_name = node->children[0]->table_name;
+    const std::string& alias = node->children[0]->alias;
+    std::vector<WhereCondition> conditions = table_conditions(node->conditions, alias);
+    std::vector<WhereCondition> candidates;
+    std::copy_if(conditions.begin(), conditions.end(), std::back_inserter(candidates), is_index_condition);
+    size_t matched = 0;
+    std::string index_name = catalog_.find_index(table_name, candidates, matched);
+    if (index_name.empty()) {
+        node->children[0]->conditions = conditions;
+        return node->children[0];
+    }
+    std::vector<std::string> key_columns = catalog_.index_columns(index_name);
+    key_columns.resize(matched);
+
+    auto scan_node = std::make_shared<LogicalPlanNode>(LogicalOperatorType::INDEX_SCAN);
+    scan_node->table_name = table_name;
+    scan_node->alias = alias;
+    scan_node->index_name = index_name;
+    std::vector<WhereCondition> residual;
+    for (size_t i = 0; i < conditions.size(); ++i) {
+        const auto& cond = conditions[i];
+        bool on_key = std::find(key_columns.begin(), key_columns.end(), cond.column) != key_columns.end();
+        if (on_key && is_index_condition(cond)) {
+            scan_node->conditions.push_back(cond);
+        } else {
+            residual.push_back(node->conditions[i]);
+        }
+    }
+    if (residual.empty()) {
+        return scan_node;
+    }
+    node->conditions = residual;
+    node->children[0] = scan_node;
+    return node;
+}
+
+// Columns a projection or aggregate reads from its input; false when it
+// reads all of them
+bool Optimizer::columns_read(const std::shared_ptr<LogicalPlanNode>& node, std::vector<std::string>& columns) {
+    if (node->type == LogicalOperatorType::PROJECTION) {
+        columns = node->projection_columns;
+        return !columns.empty() && columns[0] != "*";
+    }
+    columns = node->group_by;
+    for (const auto& call : node->aggregates) {
+        if (call.column != "*") {
+            columns.push_back(call.column);
+        }
+    }
+    return true;
+}
+
+// Lets an index scan under a projection, aggregate or sort skip the heap
+// when it, and any filter left above the scan, read only the index's columns
+void Optimizer::choose_index_only(const std::shared_ptr<LogicalPlanNode>& parent, const std::vector<std::string>& columns) {
+    if (parent->children.size() != 1) {
+        return;
+    }
+    std::shared_ptr<LogicalPlanNode> filter;
+    std::shared_ptr<LogicalPlanNode> scan = parent->children[0];
+    if (scan->type == LogicalOperatorType::FILTER && scan->children.size() == 1) {
+        filter = scan;
+        scan = filter->children[0];
+    }
+    if (scan->type != LogicalOperatorType::INDEX_SCAN) {
+        return;
+    }
+    std::vector<std::string> covered = catalog_.index_columns(scan->index_name);
+    auto is_covered = [&covered](const std::string& column) {
+        return std::find(covered.begin(), covered.end(), column) != covered.end();
+    };
+    if (!std::all_of(columns.begin(), columns.end(), is_covered)) {
+        return;
+    }
+    if (filter && !std::all_of(filter->conditions.begin(), filter->conditions.end(),
+                               [&](const WhereCondition& cond) { return is_covered(cond.column); })) {
+        return;
+    }
+    scan->index_only = true;
+}
+
+// Lets a sequential scan under a projection, aggregate or sort decode only
+// the columns it reads; COUNT(*) alone still decodes the first one
+void Optimizer::prune_scan_columns(const std::shared_ptr<LogicalPlanNode>& parent, const std::vector<std::string>& columns) {
+    if (parent->children.size() != 1) {
+        return;
+    }
+    auto& scan = parent->children[0];
+    if (scan->type != LogicalOperatorType::SEQ_SCAN) {
+        return;
+    }
+    if (columns.empty()) {
+        scan->scan_columns.push_back(catalog_.get_table_schema(scan->table_name).columns.at(0).name);
+        return;
+    }
+    for (const auto& column : columns) {
+        if (std::find(scan->scan_columns.begin(), scan->scan_columns.end(), column) == scan->scan_columns.end()) {
+            scan->scan_columns.push_back(column);
+        }
+    }
+}
+
+// A hash join when a condition equates a column of each side. Otherwise,
+// when the right side is a plain table scan and the conditions bound an
+// indexed column of it, an index lookup per left row; else a nested loop.
+void Optimizer::choose_join_method(const std::shared_ptr<LogicalPlanNode>& join) {
+    const auto& right = join->children[1];
+    std::vector<std::string> right_tables;
+    collect_aliases(right, right_tables);
+    auto on_right = [&](const std::string& column) {
+        return std::find(right_tables.begin(), right_tables.end(), qualifier_of(column)) != right_tables.end();
+    };
+    for (const auto& cond : join->join_conditions) {
+        if (cond.op == "=" && on_right(cond.left_column) != on_right(cond.right_column)) {
+            join->join_method = JoinMethod::HASH;
+            return;
+        }
+    }
+    join->join_method = JoinMethod::NESTED_LOOP;
+    if (right->type != LogicalOperatorType::SEQ_SCAN) {
+        return;
+    }
+    std::vector<WhereCondition> lookups;
+    for (const auto& cond : join->join_conditions) {
+        if (on_right(cond.left_column) == on_right(cond.right_column)) continue;
+        bool right_first = on_right(cond.left_column);
+        const std::string& column = right_first ? cond.left_column : cond.right_column;
+        WhereCondition lookup{column.substr(right->alias.size() + 1), right_first ? cond.op : flip_comparison(cond.op), Value()};
+        if (is_index_condition(lookup)) {
+            lookups.push_back(lookup);
+        }
+    }
+    size_t matched = 0;
+    std::string index_name = lookups.empty() ? "" : catalog_.find_index(right->table_name, lookups, matched);
+    if (!index_name.empty()) {
+        join->join_method = JoinMethod::INDEX_NESTED_LOOP;
+        join->index_name = index_name;
+    }
+}
+
+void Optimizer::collect_aliases(const std::shared_ptr<LogicalPlanNode>& node, std::vector<std::string>& aliases) {
+    if (!node->alias.empty()) {
+        aliases.push_back(node->alias);
+    }
+    for (const auto& child : node->children) {
+        collect_aliases(child, aliases);
+    }
+}
+
+// Narrows the scans under a join to the columns the operators above read:
+// sequential scans decode only those, and index scans that cover them skip
+// the heap. all is set while an operator above reads every column.
+void Optimizer::prune_join_inputs(const std::shared_ptr<LogicalPlanNode>& node, std::vector<std::string> needed, bool all) {
+    switch (node->type) {
+        case LogicalOperatorType::PROJECTION:
+            all = !columns_read(node, needed);
+            break;
+        case LogicalOperatorType::AGGREGATE:
+            columns_read(node, needed);
+            all = false;
+            break;
+        case LogicalOperatorType::FILTER:
+            for (const auto& cond : node->conditions) {
+                needed.push_back(cond.column);
+            }
+            break;
+        case LogicalOperatorType::SORT:
+            for (const auto& key : node->sort_keys) {
+                needed.push_back(key.column);
+            }
+            break;
+        case LogicalOperatorType::JOIN:
+            for (const auto& cond : node->join_conditions) {
+                needed.push_back(cond.left_column);
+                needed.push_back(cond.right_column);
+            }
+            break;
+        case LogicalOperatorType::SEQ_SCAN:
+        case LogicalOperatorType::INDEX_SCAN: {
+            if (node->alias.empty() || all) {
+                return;
+            }
+            std::vector<std::string> columns;
+            for (const auto& column : needed) {
+                if (qualifier_of(column) != node->alias) continue;
+                std::string bare = column.substr(node->alias.size() + 1);
+                if (std::find(columns.begin(), columns.end(), bare) == columns.end()) {
+                    columns.push_back(bare);
+                }
+            }
+            if (node->type == LogicalOperatorType::INDEX_SCAN) {
+                std::vector<std::string> covered = catalog_.index_columns(node->index_name);
+                node->index_only = std::all_of(columns.begin(), columns.end(), [&](const std::string& column) {
+                    return std::find(covered.begin(), covered.end(), column) != covered.end();
+                });
+            } else if (columns.empty()) {
+                node->scan_columns = {catalog_.get_table_schema(node->table_name).columns.at(0).name};
+            } else {
+                node->scan_columns = columns;
+            }
+            return;
+        }
+        default:
+            break;
+    }
+    for (const auto& child : node->children) {
+        prune_join_inputs(child, needed, all);
+    }
+}
+
+bool Optimizer::is_index_condition(const WhereCondition& cond) {
+    return cond.op == "=" || cond.op == "<" || cond.op == "<=" || cond.op == ">" || cond.op == ">=";
+}
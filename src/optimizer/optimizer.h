@@ -12,6 +12,15 @@ public:
     explicit Optimizer(StorageEngine& storage) : catalog_(&storage) {}
     std::shared_ptr<LogicalPlanNode> optimize(ASTNode& ast);
 private:
+    std::shared_ptr<LogicalPlanNode> choose_access_path(std::shared_ptr<LogicalPlanNode> node);
+    static bool columns_read(const std::shared_ptr<LogicalPlanNode>& node, std::vector<std::string>& columns);
+    void choose_index_only(const std::shared_ptr<LogicalPlanNode>& parent, const std::vector<std::string>& columns);
+    void prune_scan_columns(const std::shared_ptr<LogicalPlanNode>& parent, const std::vector<std::string>& columns);
+    void choose_join_method(const std::shared_ptr<LogicalPlanNode>& join);
+    static void collect_aliases(const std::shared_ptr<LogicalPlanNode>& node, std::vector<std::string>& aliases);
+    void prune_join_inputs(const std::shared_ptr<LogicalPlanNode>& node, std::vector<std::string> needed, bool all);
+    static bool is_index_condition(const WhereCondition& cond);
+
     SemanticAnalyzer semantic_analyzer_;
     PlanGenerator plan_generator_;
     Catalog catalog_;
@@ -1,20 +1,42 @@
 #include "plan_generator.h"
 #include <iostream>
+#include <algorithm>
 
 std::shared_ptr<LogicalPlanNode> PlanGenerator::create_plan(const ASTNode& ast) {
     if (ast.type == "SELECT") {
-        auto scan_node = std::make_shared<LogicalPlanNode>(LogicalOperatorType::SEQ_SCAN);
-        scan_node->table_name = ast.table_name;
-
-        std::shared_ptr<LogicalPlanNode> current_node = scan_node;
+        std::shared_ptr<LogicalPlanNode> current_node;
+        if (ast.tables.size() > 1) {
+            current_node = create_join(ast);
+        } else {
+            current_node = std::make_shared<LogicalPlanNode>(LogicalOperatorType::SEQ_SCAN);
+            current_node->table_name = ast.table_name;
+        }
 
-        if (!ast.where_conditions.empty()) {
+        if (ast.tables.size() <= 1 && !ast.where_conditions.empty()) {
             auto filter_node = std::make_shared<LogicalPlanNode>(LogicalOperatorType::FILTER);
             filter_node->conditions = ast.where_conditions;
             filter_node->children.push_back(current_node);
             current_node = filter_node;
         }
 
+        if (!ast.aggregates.empty() || !ast.group_by.empty()) {
+            auto aggregate_node = std::make_shared<LogicalPlanNode>(LogicalOperatorType::AGGREGATE);
+            aggregate_node->group_by = ast.group_by;
+            aggregate_node->aggregates = ast.aggregates;
+            aggregate_node->children.push_back(current_node);
+            current_node = aggregate_node;
+        }
+
+        // The sort runs ahead of the projection, so it can order by columns
+        // not selected; with a LIMIT it keeps only the rows taken
+        if (!ast.order_by.empty()) {
+            auto sort_node = std::make_shared<LogicalPlanNode>(LogicalOperatorType::SORT);
+            sort_node->sort_keys = ast.order_by;
+            sort_node->limit = ast.limit;
+            sort_node->children.push_back(current_node);
+            current_node = sort_node;
+        }
+
         auto projection_node = std::make_shared<LogicalPlanNode>(LogicalOperatorType::PROJECTION);
         for (const auto& col : ast.columns) {
             projection_node->projection_columns.push_back(col.name);
@@ -22,6 +44,13 @@ std::shared_ptr<LogicalPlanNode> PlanGenerator::create_plan(const ASTNode& ast)
         projection_node->children.push_back(current_node);
         current_node = projection_node;
 
+        if (ast.limit >= 0) {
+            auto limit_node = std::make_shared<LogicalPlanNode>(LogicalOperatorType::LIMIT);
+            limit_node->limit = ast.limit;
+            limit_node->children.push_back(current_node);
+            current_node = limit_node;
+        }
+
         return current_node;
     } else if (ast.type == "INSERT") {
         auto insert_node = std::make_shared<LogicalPlanNode>(LogicalOperatorType::INSERT);
@@ -49,7 +78,10 @@ std::shared_ptr<LogicalPlanNode> PlanGenerator::create_plan(const ASTNode& ast)
         auto create_index_node = std::make_shared<LogicalPlanNode>(LogicalOperatorType::CREATE_INDEX);
         create_index_node->index_name = ast.index_name;
         create_index_node->table_name = ast.table_name;
-        create_index_node->index_column = ast.index_column;
+        create_index_node->index_columns = ast.index_columns;
+        create_index_node->index_method = ast.index_method;
+        create_index_node->include_columns = ast.include_columns;
+        create_index_node->fill_factor = ast.fill_factor;
         return create_index_node;
     } else if (ast.type == "DROP_TABLE") {
         auto drop_table_node = std::make_shared<LogicalPlanNode>(LogicalOperatorType::DROP_TABLE);
@@ -59,16 +91,79 @@ std::shared_ptr<LogicalPlanNode> PlanGenerator::create_plan(const ASTNode& ast)
         auto drop_index_node = std::make_shared<LogicalPlanNode>(LogicalOperatorType::DROP_INDEX);
         drop_index_node->index_name = ast.index_name;
         return drop_index_node;
+    } else if (ast.type == "VACUUM") {
+        auto vacuum_node = std::make_shared<LogicalPlanNode>(LogicalOperatorType::VACUUM);
+        vacuum_node->table_name = ast.table_name;
+        return vacuum_node;
     }
     throw std::runtime_error("Unsupported statement type for plan generation: " + ast.type);
 }
 
+// Joins the FROM tables left to right. Each table's scan is filtered by the
+// conditions on it alone, and every column comparison goes to the first
+// join that has both its columns.
+std::shared_ptr<LogicalPlanNode> PlanGenerator::create_join(const ASTNode& ast) {
+    auto qualifier_of = [](const std::string& column) { return column.substr(0, column.find('.')); };
+    std::shared_ptr<LogicalPlanNode> tree;
+    std::vector<std::string> joined;
+    std::vector<bool> placed(ast.join_conditions.size(), false);
+    for (const auto& table : ast.tables) {
+        std::shared_ptr<LogicalPlanNode> input = std::make_shared<LogicalPlanNode>(LogicalOperatorType::SEQ_SCAN);
+        input->table_name = table.name;
+        input->alias = table.qualifier();
+        std::vector<WhereCondition> conditions;
+        for (const auto& cond : ast.where_conditions) {
+            if (qualifier_of(cond.column) == table.qualifier()) {
+                conditions.push_back(cond);
+            }
+        }
+        if (!conditions.empty()) {
+            auto filter_node = std::make_shared<LogicalPlanNode>(LogicalOperatorType::FILTER);
+            filter_node->conditions = conditions;
+            filter_node->children.push_back(input);
+            input = filter_node;
+        }
+        joined.push_back(table.qualifier());
+        if (!tree) {
+            tree = input;
+            continue;
+        }
+        auto join_node = std::make_shared<LogicalPlanNode>(LogicalOperatorType::JOIN);
+        join_node->children = {tree, input};
+        for (size_t i = 0; i < ast.join_conditions.size(); ++i) {
+            const auto& cond = ast.join_conditions[i];
+            bool covered = std::find(joined.begin(), joined.end(), qualifier_of(cond.left_column)) != joined.end() &&
+                           std::find(joined.begin(), joined.end(), qualifier_of(cond.right_column)) != joined.end();
+            if (!placed[i] && covered) {
+                join_node->join_conditions.push_back(cond);
+                placed[i] = true;
+            }
+        }
+        tree = join_node;
+    }
+    return tree;
+}
+
 void print_logical_plan(const std::shared_ptr<LogicalPlanNode>& node, int indent) {
     if (!node) return;
     std::string indentation(indent * 2, ' ');
     switch (node->type) {
         case LogicalOperatorType::SEQ_SCAN:
-            std::cout << indentation << "SeqScan: " << node->table_name << std::endl;
+            std::cout << indentation << "SeqScan: " << node->table_name << (node->alias.empty() || node->alias == node->table_name ? "" : " " + node->alias);
+            for (size_t i = 0; i < node->scan_columns.size(); ++i) {
+                std::cout << (i == 0 ? " (" : ", ") << node->scan_columns[i];
+            }
+            std::cout << (node->scan_columns.empty() ? "" : ")") << std::endl;
+            for (const auto& cond : node->conditions) {
+                std::cout << indentation << "  " << cond.column << " " << cond.op << " " << to_string(cond.value) << std::endl;
+            }
+            break;
+        case LogicalOperatorType::INDEX_SCAN:
+            std::cout << indentation << (node->index_only ? "IndexOnlyScan: " : "IndexScan: ") << node->table_name
+                      << (node->alias.empty() || node->alias == node->table_name ? "" : " " + node->alias) << " USING " << node->index_name << std::endl;
+            for (const auto& cond : node->conditions) {
+                std::cout << indentation << "  " << cond.column << " " << cond.op << " " << to_string(cond.value) << std::endl;
+            }
             break;
         case LogicalOperatorType::FILTER:
             std::cout << indentation << "Filter: " << std::endl;
@@ -76,6 +171,32 @@ void print_logical_plan(const std::shared_ptr<LogicalPlanNode>& node, int indent
                 std::cout << indentation << "  " << cond.column << " " << cond.op << " " << to_string(cond.value) << std::endl;
             }
             break;
+        case LogicalOperatorType::JOIN:
+            std::cout << indentation << (node->join_method == JoinMethod::HASH ? "HashJoin" :
+                                         node->join_method == JoinMethod::INDEX_NESTED_LOOP ? "IndexNestedLoopJoin" : "NestedLoopJoin");
+            std::cout << (node->join_method == JoinMethod::INDEX_NESTED_LOOP ? " USING " + node->index_name : "") << std::endl;
+            for (const auto& cond : node->join_conditions) {
+                std::cout << indentation << "  " << cond.left_column << " " << cond.op << " " << cond.right_column << std::endl;
+            }
+            break;
+        case LogicalOperatorType::AGGREGATE:
+            std::cout << indentation << "HashAggregate: " << std::endl;
+            for (const auto& col : node->group_by) {
+                std::cout << indentation << "  GROUP BY " << col << std::endl;
+            }
+            for (const auto& call : node->aggregates) {
+                std::cout << indentation << "  " << call.name() << std::endl;
+            }
+            break;
+        case LogicalOperatorType::SORT:
+            std::cout << indentation << (node->limit >= 0 ? "TopNSort: " + std::to_string(node->limit) : "Sort: ") << std::endl;
+            for (const auto& key : node->sort_keys) {
+                std::cout << indentation << "  " << key.column << (key.descending ? " DESC" : "") << std::endl;
+            }
+            break;
+        case LogicalOperatorType::LIMIT:
+            std::cout << indentation << "Limit: " << node->limit << std::endl;
+            break;
         case LogicalOperatorType::PROJECTION:
             std::cout << indentation << "Projection: " << std::endl;
             for (const auto& col : node->projection_columns) {
@@ -104,7 +225,15 @@ void print_logical_plan(const std::shared_ptr<LogicalPlanNode>& node, int indent
             std::cout << indentation << "CreateTable: " << node->table_name << std::endl;
             break;
         case LogicalOperatorType::CREATE_INDEX:
-            std::cout << indentation << "CreateIndex: " << node->index_name << " ON " << node->table_name << "(" << node->index_column << ")" << std::endl;
+            std::cout << indentation << "CreateIndex: " << node->index_name << " ON " << node->table_name << "(";
+            for (size_t i = 0; i < node->index_columns.size(); ++i) {
+                std::cout << (i == 0 ? "" : ", ") << node->index_columns[i];
+            }
+            std::cout << ")" << (node->index_method.empty() ? "" : " USING " + node->index_method);
+            for (size_t i = 0; i < node->include_columns.size(); ++i) {
+                std::cout << (i == 0 ? " INCLUDE (" : ", ") << node->include_columns[i];
+            }
+            std::cout << (node->include_columns.empty() ? "" : ")") << std::endl;
             break;
         case LogicalOperatorType::DROP_TABLE:
             std::cout << indentation << "DropTable: " << node->table_name << std::endl;
@@ -112,6 +241,9 @@ void print_logical_plan(const std::shared_ptr<LogicalPlanNode>& node, int indent
         case LogicalOperatorType::DROP_INDEX:
             std::cout << indentation << "DropIndex: " << node->index_name << std::endl;
             break;
+        case LogicalOperatorType::VACUUM:
+            std::cout << indentation << "Vacuum: " << (node->table_name.empty() ? "all tables" : node->table_name) << std::endl;
+            break;
         default:
             std::cout << indentation << "Unknown operator" << std::endl;
     }
@@ -6,15 +6,27 @@
 
 enum class LogicalOperatorType {
     SEQ_SCAN,
+    INDEX_SCAN,
     FILTER,
+    JOIN,
+    AGGREGATE,
+    SORT,
     PROJECTION,
+    LIMIT,
     INSERT,
     UPDATE,
     DELETE,
     CREATE_TABLE,
     CREATE_INDEX,
     DROP_TABLE,
-    DROP_INDEX
+    DROP_INDEX,
+    VACUUM
+};
+
+enum class JoinMethod {
+    HASH, // Needs an equality between the two sides; builds on the right one
+    NESTED_LOOP,
+    INDEX_NESTED_LOOP // Looks the right table up through index_name for each left row
 };
 
 class LogicalPlanNode {
@@ -23,13 +35,27 @@ public:
     std::vector<std::shared_ptr<LogicalPlanNode>> children;
     // Specific operator fields
     std::string table_name;
-    std::string index_name; // For CREATE/DROP INDEX
-    std::string index_column; // For CREATE INDEX
+    std::string alias; // Scans in a join: qualifier of their output column names
+    std::string index_name; // For CREATE/DROP INDEX and INDEX_SCAN
+    std::vector<std::string> index_columns; // CREATE INDEX key columns
+    std::string index_method; // CREATE INDEX: BTREE, HASH or empty for BTREE
+    std::vector<std::string> include_columns; // CREATE INDEX
+    bool index_only = false; // INDEX_SCAN: outputs only the index's columns and skips all-visible heap pages
+    int fill_factor = 0; // CREATE INDEX; 0 means the default
+    // INDEX_SCAN: the conditions that bound the key range; SEQ_SCAN: the
+    // conditions it tests on the page bytes
     std::vector<WhereCondition> conditions;
+    std::vector<std::string> scan_columns; // SEQ_SCAN: columns read above the scan, empty for all
     std::vector<ColumnDefinition> columns;
     std::vector<Value> values; // Single-row INSERT
     std::vector<std::vector<Value>> multi_values; // Multi-row INSERT
     std::vector<std::string> projection_columns;
+    std::vector<std::string> group_by; // AGGREGATE: grouping columns, output ahead of the aggregates
+    std::vector<AggregateCall> aggregates; // AGGREGATE
+    std::vector<OrderItem> sort_keys; // SORT, most significant first
+    int limit = -1; // LIMIT; SORT: the rows a LIMIT above it takes, -1 for all
+    std::vector<JoinCondition> join_conditions; // JOIN: every comparison between its two sides
+    JoinMethod join_method = JoinMethod::NESTED_LOOP; // JOIN, chosen by the optimizer
     std::map<std::string, Value> set_clause; // For UPDATE statements
 
     LogicalPlanNode(LogicalOperatorType type) : type(type) {}
@@ -38,6 +64,8 @@ public:
 class PlanGenerator {
 public:
     std::shared_ptr<LogicalPlanNode> create_plan(const ASTNode& ast);
+private:
+    std::shared_ptr<LogicalPlanNode> create_join(const ASTNode& ast);
 };
 
 void print_logical_plan(const std::shared_ptr<LogicalPlanNode>& node, int indent = 0);
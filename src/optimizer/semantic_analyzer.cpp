@@ -1,5 +1,128 @@
 #include "semantic_analyzer.h"
 #include <stdexcept>
+#include <algorithm>
+#include <map>
+#include "../common/predicate.h"
+
+// Every selected or ordering column must be grouped, and SUM and AVG need
+// INT input; types holds the resolved columns
+void SemanticAnalyzer::validate_aggregation(const ASTNode& ast, const std::map<std::string, DataType>& types) {
+    for (const auto& call : ast.aggregates) {
+        if (call.column == "*") {
+            if (call.function != "COUNT") {
+                throw std::runtime_error(call.function + "(*) is not supported.");
+            }
+        } else if (types.at(call.column) != DataType::INT && (call.function == "SUM" || call.function == "AVG")) {
+            throw std::runtime_error(call.function + " requires an INT column: '" + call.column + "'.");
+        }
+    }
+    for (const auto& col : ast.columns) {
+        bool aggregate = std::any_of(ast.aggregates.begin(), ast.aggregates.end(),
+                                     [&](const AggregateCall& call) { return call.name() == col.name; });
+        if (!aggregate && std::find(ast.group_by.begin(), ast.group_by.end(), col.name) == ast.group_by.end()) {
+            throw std::runtime_error("Column '" + col.name + "' must appear in GROUP BY or be used in an aggregate.");
+        }
+    }
+    for (const auto& item : ast.order_by) {
+        bool aggregate = std::any_of(ast.aggregates.begin(), ast.aggregates.end(),
+                                     [&](const AggregateCall& call) { return call.name() == item.column; });
+        if (!aggregate && std::find(ast.group_by.begin(), ast.group_by.end(), item.column) == ast.group_by.end()) {
+            throw std::runtime_error("ORDER BY column '" + item.column + "' must appear in GROUP BY or be used in an aggregate.");
+        }
+    }
+}
+
+// Resolves every column a SELECT names against its FROM list: to the bare
+// name for a single table, and to qualifier.column in a join, where an
+// unqualified name must belong to exactly one of the tables
+void SemanticAnalyzer::analyze_select(ASTNode& ast, Catalog& catalog) {
+    std::vector<std::pair<std::string, TableSchema>> scope; // Qualifier and schema of each table
+    for (const auto& table : ast.tables) {
+        if (!catalog.table_exists(table.name)) {
+            throw std::runtime_error("Table '" + table.name + "' does not exist.");
+        }
+        for (const auto& entry : scope) {
+            if (entry.first == table.qualifier()) {
+                throw std::runtime_error("Table name '" + table.qualifier() + "' specified more than once.");
+            }
+        }
+        scope.emplace_back(table.qualifier(), catalog.get_table_schema(table.name));
+    }
+    bool join = scope.size() > 1;
+
+    std::map<std::string, DataType> types;
+    auto resolve = [&](std::string& name) {
+        size_t dot = name.find('.');
+        std::string qualifier = dot == std::string::npos ? "" : name.substr(0, dot);
+        std::string column = dot == std::string::npos ? name : name.substr(dot + 1);
+        const ColumnDefinition* found = nullptr;
+        std::string found_in;
+        for (const auto& [table_qualifier, schema] : scope) {
+            if (!qualifier.empty() && qualifier != table_qualifier) continue;
+            for (const auto& col : schema.columns) {
+                if (col.name != column) continue;
+                if (found) {
+                    throw std::runtime_error("Column reference '" + name + "' is ambiguous.");
+                }
+                found = &col;
+                found_in = table_qualifier;
+            }
+        }
+        if (!found) {
+            throw std::runtime_error("Column '" + name + "' not found" + (join ? "." : " in table '" + ast.table_name + "'."));
+        }
+        name = join ? found_in + "." + column : column;
+        types[name] = found->type;
+        return found->type;
+    };
+
+    std::map<std::string, std::string> aggregate_names; // As written -> resolved
+    for (auto& call : ast.aggregates) {
+        std::string written = call.name();
+        if (call.column != "*") {
+            resolve(call.column);
+        }
+        aggregate_names[written] = call.name();
+    }
+    for (auto& col : ast.columns) {
+        auto aggregate = aggregate_names.find(col.name);
+        if (aggregate != aggregate_names.end()) {
+            col.name = aggregate->second;
+        } else if (col.name != "*") {
+            resolve(col.name);
+        }
+    }
+    for (auto& col : ast.group_by) {
+        resolve(col);
+    }
+    for (auto& item : ast.order_by) {
+        auto aggregate = aggregate_names.find(item.column);
+        if (aggregate != aggregate_names.end()) {
+            item.column = aggregate->second;
+        } else if (item.column.find('(') != std::string::npos) {
+            throw std::runtime_error("ORDER BY aggregate '" + item.column + "' must appear in the SELECT list.");
+        } else {
+            resolve(item.column);
+        }
+    }
+    for (auto& cond : ast.where_conditions) {
+        if (resolve(cond.column) != cond.value.type) {
+            throw std::runtime_error("Type mismatch for column '" + cond.column + "'.");
+        }
+    }
+    if (!join && !ast.join_conditions.empty()) {
+        throw std::runtime_error("Columns can only be compared with columns of another table.");
+    }
+    for (auto& cond : ast.join_conditions) {
+        compare_op_from(cond.op); // Throws for an unsupported operator
+        if (resolve(cond.left_column) != resolve(cond.right_column)) {
+            throw std::runtime_error("Type mismatch between '" + cond.left_column + "' and '" + cond.right_column + "'.");
+        }
+    }
+    if (!ast.aggregates.empty() || !ast.group_by.empty()) {
+        validate_aggregation(ast, types);
+    }
+}
 
 void SemanticAnalyzer::analyze(ASTNode& ast, Catalog& catalog) {
     if (ast.type == "CREATE_TABLE") {
@@ -7,7 +130,12 @@ void SemanticAnalyzer::analyze(ASTNode& ast, Catalog& catalog) {
         schema.name = ast.table_name;
         schema.columns = ast.columns;
         catalog.create_table(schema);
-    } else if (ast.type == "SELECT" || ast.type == "UPDATE" || ast.type == "DELETE") {
+    } else if (ast.type == "SELECT") {
+        analyze_select(ast, catalog);
+    } else if (ast.type == "UPDATE" || ast.type == "DELETE") {
+        if (!ast.join_conditions.empty()) {
+            throw std::runtime_error("Columns can only be compared with columns of another table.");
+        }
         if (!catalog.table_exists(ast.table_name)) {
             throw std::runtime_error("Table '" + ast.table_name + "' does not exist.");
         }
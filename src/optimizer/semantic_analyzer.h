@@ -3,10 +3,14 @@
 
 #include "parser/sql_parser.h"
 #include "catalog.h"
+#include <map>
 
 class SemanticAnalyzer {
 public:
     void analyze(ASTNode& ast, Catalog& catalog);
+private:
+    void analyze_select(ASTNode& ast, Catalog& catalog);
+    void validate_aggregation(const ASTNode& ast, const std::map<std::string, DataType>& types);
 };
 
 #endif
\ No newline at end of file
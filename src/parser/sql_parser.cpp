@@ -9,9 +9,12 @@
 const std::set<std::string> KEYWORDS = {
     "SELECT", "FROM", "WHERE", "INSERT", "INTO", "VALUES", "UPDATE", "SET", "DELETE",
     "CREATE", "TABLE", "INDEX", "ON", "DROP", "BEGIN", "START", "COMMIT", "ROLLBACK", "VACUUM",
-    "INT", "INTEGER", "TEXT", "VARCHAR", "AND", "LIKE"
+    "INT", "INTEGER", "TEXT", "VARCHAR", "AND", "LIKE", "GROUP", "BY",
+    "JOIN", "INNER", "AS", "ORDER", "ASC", "DESC", "LIMIT"
 };
 
+const std::set<std::string> AGGREGATE_FUNCTIONS = {"COUNT", "SUM", "MIN", "MAX", "AVG"};
+
 std::vector<Token> tokenize(const std::string& sql) {
     std::vector<Token> tokens;
     int line = 1;
@@ -56,7 +59,9 @@ std::vector<Token> tokenize(const std::string& sql) {
         if (std::isalpha(c)) {
             std::string text;
             int start_col = col;
-            while (i < sql.length() && (std::isalnum(sql[i]) || sql[i] == '_')) {
+            // A dot joins a qualifier to a column name: a.x is one identifier
+            while (i < sql.length() && (std::isalnum(sql[i]) || sql[i] == '_' ||
+                                        (sql[i] == '.' && i + 1 < sql.length() && std::isalpha(sql[i + 1])))) {
                 text += sql[i];
                 i++;
                 col++;
@@ -96,7 +101,7 @@ std::vector<Token> tokenize(const std::string& sql) {
             i++;
             col++;
             if (i < sql.length() && c != '*') { // * is always single character
-                if ((c == '!' || c == '<') && sql[i] == '=') {
+                if ((c == '!' || c == '<' || c == '>') && sql[i] == '=') {
                     op += '=';
                     i++;
                     col++;
@@ -136,6 +141,7 @@ public:
         if (type == "COMMIT") return parse_commit();
         if (type == "ROLLBACK") return parse_rollback();
         if (type == "VACUUM") return parse_vacuum();
+        if (type == "SET") return parse_set();
 
         throw std::runtime_error("Unsupported SQL statement: " + peek().text + " at line " + std::to_string(peek().line) + " col " + std::to_string(peek().column));
     }
@@ -207,34 +213,126 @@ private:
             node.columns.push_back({ consume().text, DataType::STRING }); // Represent wildcard
         } else {
             while (peek_upper() != "FROM") {
-                node.columns.push_back({ consume().text, DataType::STRING }); // Type is unknown at this stage
+                if (at_aggregate_call()) {
+                    AggregateCall call = parse_aggregate_call();
+                    node.aggregates.push_back(call);
+                    node.columns.push_back({ call.name(), DataType::STRING });
+                } else {
+                    node.columns.push_back({ consume().text, DataType::STRING }); // Type is unknown at this stage
+                }
                 if (peek().text == ",") consume();
                 if (is_end()) throw std::runtime_error("Incomplete SELECT statement.");
             }
         }
 
         expect("FROM");
-        node.table_name = consume().text;
+        node.tables.push_back(parse_table_ref());
+        while (true) {
+            if (peek().text == ",") {
+                consume();
+                node.tables.push_back(parse_table_ref());
+            } else if (peek_upper() == "JOIN" || (peek_upper() == "INNER" && peek_upper(1) == "JOIN")) {
+                if (peek_upper() == "INNER") consume();
+                consume(); // consume JOIN
+                node.tables.push_back(parse_table_ref());
+                expect("ON");
+                parse_conditions(node);
+            } else {
+                break;
+            }
+        }
+        node.table_name = node.tables[0].name;
 
         if (peek_upper() == "WHERE") {
             parse_where_clause(node);
         }
 
+        if (peek_upper() == "GROUP") {
+            consume(); // consume GROUP
+            expect("BY");
+            do {
+                if (peek().text == ",") consume();
+                node.group_by.push_back(consume().text);
+            } while (peek().text == ",");
+        }
+
+        if (peek_upper() == "ORDER") {
+            consume(); // consume ORDER
+            expect("BY");
+            do {
+                if (peek().text == ",") consume();
+                OrderItem item;
+                item.column = at_aggregate_call() ? parse_aggregate_call().name() : consume().text;
+                if (peek_upper() == "ASC" || peek_upper() == "DESC") {
+                    item.descending = peek_upper() == "DESC";
+                    consume();
+                }
+                node.order_by.push_back(item);
+            } while (peek().text == ",");
+        }
+
+        if (peek_upper() == "LIMIT") {
+            consume(); // consume LIMIT
+            Token count = peek();
+            Value value = parse_value();
+            if (value.type != DataType::INT || value.int_value < 0) {
+                throw std::runtime_error("LIMIT needs a non-negative integer at line " + std::to_string(count.line) + " col " + std::to_string(count.column));
+            }
+            node.limit = value.int_value;
+        }
+
         return node;
     }
 
+    bool at_aggregate_call() const {
+        return AGGREGATE_FUNCTIONS.count(peek_upper()) && peek(1).text == "(";
+    }
+
+    // FUNCTION(column)
+    AggregateCall parse_aggregate_call() {
+        AggregateCall call;
+        call.function = peek_upper();
+        consume();
+        expect("(");
+        call.column = consume().text;
+        expect(")");
+        return call;
+    }
+
+    // name [[AS] alias]
+    TableRef parse_table_ref() {
+        TableRef ref;
+        ref.name = consume().text;
+        if (peek_upper() == "AS") {
+            consume();
+            ref.alias = consume().text;
+        } else if (peek().type == TokenType::IDENTIFIER) {
+            ref.alias = consume().text;
+        }
+        return ref;
+    }
+
     void parse_where_clause(ASTNode& node) {
         expect("WHERE");
+        parse_conditions(node);
+    }
+
+    // Conditions joined by AND, each comparing a column with a literal or,
+    // for a join, with another column
+    void parse_conditions(ASTNode& node) {
         while (!is_end() && peek_upper() != "LIMIT" && peek_upper() != "ORDER" && peek_upper() != "GROUP") {
             std::string column = consume().text;
             std::string op = consume().text;
-            Value value = parse_value();
             
             if (op != "=" && op != "<" && op != ">" && op != "!=" && op != "<>" && op != "<=" && op != ">=" && op != "LIKE") {
                  throw std::runtime_error("Unsupported operator in WHERE clause: " + op);
             }
 
-            node.where_conditions.push_back({column, op, value});
+            if (peek().type == TokenType::IDENTIFIER) {
+                node.join_conditions.push_back({column, op, consume().text});
+            } else {
+                node.where_conditions.push_back({column, op, parse_value()});
+            }
 
             if (peek_upper() == "AND") {
                 consume(); // consume AND
@@ -361,15 +459,59 @@ private:
             node.index_name = consume().text;
             expect("ON");
             node.table_name = consume().text;
+            // The access method goes either before or after the column list
+            if (peek_upper() == "USING") {
+                parse_index_method(node);
+            }
             expect("(");
-            node.index_column = consume().text;
+            while (peek().text != ")") {
+                node.index_columns.push_back(consume().text);
+                if (peek().text == ",") consume();
+            }
             expect(")");
+            if (node.index_columns.empty()) {
+                throw std::runtime_error("CREATE INDEX needs at least one column.");
+            }
+            if (peek_upper() == "USING" && node.index_method.empty()) {
+                parse_index_method(node);
+            }
+            if (peek_upper() == "INCLUDE") {
+                consume(); // consume INCLUDE
+                expect("(");
+                while (peek().text != ")") {
+                    node.include_columns.push_back(consume().text);
+                    if (peek().text == ",") consume();
+                }
+                expect(")");
+            }
+            if (peek_upper() == "WITH") {
+                consume(); // consume WITH
+                expect("(");
+                expect("FILLFACTOR");
+                expect("=");
+                Value fill_factor = parse_value();
+                if (fill_factor.type != DataType::INT || fill_factor.int_value < 10 || fill_factor.int_value > 100) {
+                    throw std::runtime_error("FILLFACTOR must be an integer between 10 and 100.");
+                }
+                node.fill_factor = fill_factor.int_value;
+                expect(")");
+            }
         } else {
             throw std::runtime_error("Unsupported CREATE statement. Must be CREATE TABLE or CREATE INDEX.");
         }
         return node;
     }
 
+    void parse_index_method(ASTNode& node) {
+        consume(); // consume USING
+        std::string method = peek_upper();
+        if (method != "BTREE" && method != "HASH") {
+            throw std::runtime_error("Unsupported index method: " + peek().text + ". Must be BTREE or HASH.");
+        }
+        consume();
+        node.index_method = method;
+    }
+
     ASTNode parse_drop() {
         consume(); // consume DROP
         std::string next = peek_upper();
@@ -392,6 +534,34 @@ private:
         consume(); // consume BEGIN/START
         ASTNode node; 
         node.type = "BEGIN";
+        if (peek_upper() == "TRANSACTION") {
+            consume();
+        }
+        if (peek_upper() == "READ") {
+            consume(); // consume READ
+            std::string access_mode = peek_upper();
+            if (access_mode != "ONLY" && access_mode != "WRITE") {
+                throw std::runtime_error("Expected ONLY or WRITE after READ at line " + std::to_string(peek().line) + " col " + std::to_string(peek().column));
+            }
+            consume();
+            node.read_only = access_mode == "ONLY";
+        }
+        return node;
+    }
+
+    // SET name = value | SET name TO value
+    ASTNode parse_set() {
+        consume(); // consume SET
+        ASTNode node;
+        node.type = "SET";
+        std::string name = consume().text;
+        if (peek_upper() == "TO") {
+            consume();
+        } else {
+            expect("=");
+        }
+        // A bare word is taken as a string, as in SET output_format = csv
+        node.set_clause[name] = peek().type == TokenType::IDENTIFIER ? Value(consume().text) : parse_value();
         return node;
     }
 
@@ -413,7 +583,9 @@ private:
         consume(); // consume VACUUM
         ASTNode node;
         node.type = "VACUUM";
-        node.table_name = consume().text;
+        if (!is_end() && peek().text != ";") {
+            node.table_name = consume().text; // Every table when omitted
+        }
         return node;
     }
 };
@@ -433,8 +605,28 @@ void print_ast(const ASTNode& node, int indent) {
     if (!node.index_name.empty()) {
         std::cout << indentation << "index_name: " << node.index_name << std::endl;
     }
-    if (!node.index_column.empty()) {
-        std::cout << indentation << "index_column: " << node.index_column << std::endl;
+    if (!node.index_columns.empty()) {
+        std::cout << indentation << "index_columns: ";
+        for (size_t i = 0; i < node.index_columns.size(); ++i) {
+            std::cout << (i == 0 ? "" : ", ") << node.index_columns[i];
+        }
+        std::cout << std::endl;
+    }
+    if (!node.index_method.empty()) {
+        std::cout << indentation << "index_method: " << node.index_method << std::endl;
+    }
+    if (!node.include_columns.empty()) {
+        std::cout << indentation << "include_columns:";
+        for (const auto& col : node.include_columns) {
+            std::cout << " " << col;
+        }
+        std::cout << std::endl;
+    }
+    if (node.fill_factor) {
+        std::cout << indentation << "fill_factor: " << node.fill_factor << std::endl;
+    }
+    if (node.read_only) {
+        std::cout << indentation << "read_only: true" << std::endl;
     }
     if (!node.columns.empty()) {
         std::cout << indentation << "columns:" << std::endl;
@@ -463,6 +655,43 @@ void print_ast(const ASTNode& node, int indent) {
             std::cout << indentation << "  - " << pair.first << " = " << (pair.second.type == DataType::INT ? std::to_string(pair.second.int_value) : pair.second.str_value) << std::endl;
         }
     }
+    if (!node.aggregates.empty()) {
+        std::cout << indentation << "aggregates:";
+        for (const auto& call : node.aggregates) {
+            std::cout << " " << call.name();
+        }
+        std::cout << std::endl;
+    }
+    if (!node.group_by.empty()) {
+        std::cout << indentation << "group_by:";
+        for (const auto& col : node.group_by) {
+            std::cout << " " << col;
+        }
+        std::cout << std::endl;
+    }
+    if (!node.order_by.empty()) {
+        std::cout << indentation << "order_by:";
+        for (const auto& item : node.order_by) {
+            std::cout << " " << item.column << (item.descending ? " DESC" : "");
+        }
+        std::cout << std::endl;
+    }
+    if (node.limit >= 0) {
+        std::cout << indentation << "limit: " << node.limit << std::endl;
+    }
+    if (node.tables.size() > 1) {
+        std::cout << indentation << "tables:";
+        for (const auto& table : node.tables) {
+            std::cout << " " << table.name << (table.alias.empty() ? "" : " " + table.alias);
+        }
+        std::cout << std::endl;
+    }
+    if (!node.join_conditions.empty()) {
+        std::cout << indentation << "join_conditions:" << std::endl;
+        for (const auto& cond : node.join_conditions) {
+            std::cout << indentation << "  - " << cond.left_column << " " << cond.op << " " << cond.right_column << std::endl;
+        }
+    }
     if (!node.where_conditions.empty()) {
         std::cout << indentation << "where_conditions:" << std::endl;
         for (const auto& cond : node.where_conditions) {
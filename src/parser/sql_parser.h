@@ -29,6 +29,35 @@ struct WhereCondition {
     Value value;
 };
 
+// Comparison of two columns, as joins are written: a.x = b.y
+struct JoinCondition {
+    std::string left_column;
+    std::string op;
+    std::string right_column;
+};
+
+// A table in a FROM list
+struct TableRef {
+    std::string name;
+    std::string alias; // Empty when the table goes by its name
+
+    const std::string& qualifier() const { return alias.empty() ? name : alias; }
+};
+
+// COUNT, SUM, MIN, MAX or AVG of a column in a SELECT list
+struct AggregateCall {
+    std::string function; // Upper case
+    std::string column; // "*" for COUNT(*)
+
+    std::string name() const { return function + "(" + column + ")"; } // Its result column
+};
+
+// A column, or an aggregate of the SELECT list, in ORDER BY
+struct OrderItem {
+    std::string column;
+    bool descending = false;
+};
+
 struct ColumnDefinition {
     std::string name;
     DataType type;
@@ -39,13 +68,23 @@ struct ASTNode {
     std::string type;
     std::string table_name;
     std::string index_name;
-    std::string index_column;
+    std::vector<std::string> index_columns; // CREATE INDEX key columns, most significant first
+    std::string index_method; // CREATE INDEX ... USING BTREE | HASH; empty means BTREE
+    std::vector<std::string> include_columns; // CREATE INDEX ... INCLUDE (cols)
+    int fill_factor = 0; // CREATE INDEX ... WITH (FILLFACTOR = n); 0 means the default
     std::vector<ColumnDefinition> columns;
     std::vector<Value> values; // For single-row INSERT (backward compatibility)
     std::vector<std::vector<Value>> multi_values; // For multi-row INSERT
-    std::map<std::string, Value> set_clause;
+    std::map<std::string, Value> set_clause; // UPDATE assignments; SET's single parameter
+    std::vector<TableRef> tables; // SELECT's FROM list, a join when longer than one; table_name is the first
     std::vector<WhereCondition> where_conditions;
+    std::vector<JoinCondition> join_conditions; // ON and WHERE comparisons between columns
+    std::vector<AggregateCall> aggregates; // SELECT list aggregates; columns holds their names in place
+    std::vector<std::string> group_by;
+    std::vector<OrderItem> order_by;
+    int limit = -1; // LIMIT n; -1 when there is none
     std::map<std::string, std::string> hints;
+    bool read_only = false; // BEGIN READ ONLY
 };
 
 ASTNode parse_sql(const std::string& sql);
@@ -1,6 +1,7 @@
 #include "storage_engine.h"
 #include "../buffer/buffer_cache.h"
 #include "../transaction/transaction_manager.h"
+#include "../index/index_sorter.h"
 #include <stdexcept>
 #include <cstring>
 #include <filesystem>
@@ -9,6 +10,9 @@
 #include <set>
 #include <iomanip>
 #include <sstream>
+#include <optional>
+#include <thread>
+#include <iterator>
 
 // Helper function to write a value to a buffer
 char* serialize_value(char* buffer, const Value& value) {
@@ -44,12 +48,70 @@ const char* deserialize_value(const char* buffer, Value& value) {
     return buffer;
 }
 
+// Like deserialize_value, leaving STRING bytes in the buffer
+const char* view_value(const char* buffer, ValueView& value) {
+    value.type = *reinterpret_cast<const DataType*>(buffer);
+    buffer += sizeof(DataType);
+    if (value.type == DataType::INT) {
+        value.int_value = *reinterpret_cast<const int*>(buffer);
+        buffer += sizeof(int);
+    } else if (value.type == DataType::STRING) {
+        size_t len = *reinterpret_cast<const size_t*>(buffer);
+        buffer += sizeof(size_t);
+        value.str_value = std::string_view(buffer, len);
+        buffer += len;
+    }
+    return buffer;
+}
 
-StorageEngine::StorageEngine(BufferCache& cache) : cache(cache) {
+// Column lists are stored in sys_indexes comma-separated
+std::string join_names(const std::vector<std::string>& names) {
+    std::string list;
+    for (const auto& name : names) {
+        list += (list.empty() ? "" : ",") + name;
+    }
+    return list;
+}
+
+std::vector<std::string> split_names(const std::string& list) {
+    std::vector<std::string> names;
+    std::stringstream stream(list);
+    for (std::string name; std::getline(stream, name, ',');) {
+        names.push_back(name);
+    }
+    return names;
+}
+
+std::vector<std::string> column_names(const std::vector<Column>& cols) {
+    std::vector<std::string> names;
+    for (const auto& col : cols) {
+        names.push_back(col.name);
+    }
+    return names;
+}
+
+// Key of rec in an index: its key columns, then any INCLUDE columns. Records
+// too short to have the first key column are not indexed.
+std::optional<std::string> index_key_of(const IndexInfo& info, const Record& rec) {
+    if (info.positions[0] >= rec.columns.size()) {
+        return std::nullopt;
+    }
+    std::vector<Value> values;
+    values.reserve(info.positions.size());
+    for (size_t pos : info.positions) {
+        values.push_back(pos < rec.columns.size() ? rec.columns[pos] : Value());
+    }
+    return encode_index_key(values, info.key_format());
+}
+
+StorageEngine::StorageEngine(BufferCache& cache) : cache(cache), clog("clog.dat") {
+    // Catalog loading below already reads pages through the cache
+    cache.set_storage_engine(this);
     wal_log.open("wal.log", std::ios::in | std::ios::out | std::ios::app);
     recover_from_wal();
     bootstrap_catalog();
     load_catalog();
+    load_indexes();
 }
 
 void StorageEngine::recover_from_wal() {
@@ -57,25 +119,67 @@ void StorageEngine::recover_from_wal() {
     std::string line;
     std::map<int, std::vector<std::string>> tx_logs;
     std::set<int> committed_txs;
+    std::vector<std::string> index_pages; // INDEX_PAGE payloads since the last checkpoint
 
     while (std::getline(wal_log, line)) {
         std::stringstream ss(line);
         int tx_id;
         std::string op;
         ss >> tx_id >> op;
+        if (op == "CHECKPOINT") {
+            index_pages.clear();
+            continue;
+        }
+        if (op == "INDEX_PAGE") {
+            std::string data;
+            std::getline(ss >> std::ws, data);
+            index_pages.push_back(data);
+            continue;
+        }
         tx_logs[tx_id].push_back(line);
         if (op == "COMMIT") {
             committed_txs.insert(tx_id);
         }
     }
 
+    bool rolled_back = false;
     for (auto const& [tx_id, logs] : tx_logs) {
+        if (tx_id == BOOTSTRAP_XID) {
+            continue; // Catalog writes never commit but always count as committed
+        }
         if (committed_txs.find(tx_id) == committed_txs.end()) {
             // Undo uncommitted transactions (simplified)
             std::cout << "Rolling back tx " << tx_id << std::endl;
+            clog.set_status(tx_id, TxStatus::ABORTED);
+            rolled_back = true;
         } else {
             // Redo committed transactions (simplified)
              std::cout << "Redoing tx " << tx_id << std::endl;
+            clog.set_status(tx_id, TxStatus::COMMITTED);
+        }
+    }
+    // The commit log must be durable before the WAL that justified it is dropped
+    clog.flush();
+
+    // Index splits since the last checkpoint may have reached disk only in
+    // part; replaying their page images in log order restores each tree
+    for (const auto& data : index_pages) {
+        std::string file;
+        int page_id;
+        Page page;
+        if (BPlusTree::decode_page_image(data, file, page_id, page) && std::filesystem::exists(file)) {
+            page.dirty = false;
+            write_page_to_file(file, page, page_id);
+        }
+    }
+
+    // A heap page an interrupted transaction wrote may have reached disk
+    // without the map page that cleared its bit; VACUUM rebuilds the maps
+    if (rolled_back && std::filesystem::exists("data")) {
+        for (const auto& entry : std::filesystem::directory_iterator("data")) {
+            if (entry.is_regular_file() && entry.path().extension() == ".vm") {
+                std::filesystem::remove(entry.path());
+            }
         }
     }
 
@@ -115,6 +219,16 @@ void StorageEngine::bootstrap_catalog() {
         Record r5; r5.columns = {Value("sys_columns"), Value("column_name"), Value((int)DataType::STRING), Value(1)}; insert_record("sys_columns", r5, 0, 0);
         Record r6; r6.columns = {Value("sys_columns"), Value("column_type"), Value((int)DataType::INT), Value(1)}; insert_record("sys_columns", r6, 0, 0);
         Record r7; r7.columns = {Value("sys_columns"), Value("not_null"), Value((int)DataType::INT), Value(1)}; insert_record("sys_columns", r7, 0, 0);
+    } else {
+        // The catalog tables describe themselves, so their schemas must be
+        // known before load_catalog can scan them
+        metadata["sys_tables"] = {{"table_name", DataType::STRING, true}};
+        metadata["sys_columns"] = {
+            {"table_name", DataType::STRING, true},
+            {"column_name", DataType::STRING, true},
+            {"column_type", DataType::INT, true},
+            {"not_null", DataType::INT, true}
+        };
     }
 }
 
@@ -154,6 +268,56 @@ void StorageEngine::load_catalog() {
         }
         metadata[table_name] = cols;
     }
+    for (const auto& [table_name, file] : table_files) {
+        open_visibility_map(table_name);
+    }
+}
+
+void StorageEngine::open_visibility_map(const std::string& table_name) {
+    if (!visibility_maps.count(table_name)) {
+        visibility_maps[table_name] = std::make_unique<VisibilityMap>(cache, "data/" + table_name + ".vm");
+    }
+}
+
+void StorageEngine::load_indexes() {
+    std::vector<ColumnDefinition> sys_indexes_cols = {
+        {"index_name", DataType::STRING},
+        {"table_name", DataType::STRING},
+        {"column_name", DataType::STRING}, // Key columns, comma-separated
+        {"index_type", DataType::INT},
+        {"include_columns", DataType::STRING} // Comma-separated
+    };
+    // Data directories created before indexes were persisted lack sys_indexes
+    if (!metadata.count("sys_indexes")) {
+        create_table("sys_indexes", sys_indexes_cols, 0, 0);
+        return;
+    }
+    // Older sys_indexes lack the later columns; their rows read as B+trees without INCLUDE columns
+    for (size_t i = metadata["sys_indexes"].size(); i < sys_indexes_cols.size(); ++i) {
+        const auto& col = sys_indexes_cols[i];
+        Record col_rec{0, 0, 0, {Value("sys_indexes"), Value(col.name), Value((int)col.type), Value(0)}};
+        insert_record("sys_columns", col_rec, 0, 0);
+        metadata["sys_indexes"].push_back({col.name, col.type, false});
+    }
+
+    // A name reused after its table was dropped has several rows; the last one is current
+    TransactionManager tx_manager(this); // Dummy tx_manager for loading
+    std::map<std::string, Record> definitions;
+    for (const auto& index_rec : scan_table("sys_indexes", 0, 0, {}, tx_manager)) {
+        definitions[index_rec.columns[0].str_value] = index_rec;
+    }
+    for (const auto& [index_name, index_rec] : definitions) {
+        const std::string& table_name = index_rec.columns[1].str_value;
+        // Indexes of dropped tables lose their file along with the table
+        if (metadata.count(table_name) && std::filesystem::exists("data/" + index_name + ".idx")) {
+            IndexType type = index_rec.columns.size() > 3 ? static_cast<IndexType>(index_rec.columns[3].int_value) : IndexType::BTREE;
+            std::vector<std::string> include_columns;
+            if (index_rec.columns.size() > 4) {
+                include_columns = split_names(index_rec.columns[4].str_value);
+            }
+            open_index(index_name, table_name, split_names(index_rec.columns[2].str_value), include_columns, type);
+        }
+    }
 }
 
 void StorageEngine::create_table(const std::string& table_name, const std::vector<ColumnDefinition>& columns, int tx_id, int cid) {
@@ -179,14 +343,20 @@ void StorageEngine::create_table(const std::string& table_name, const std::vecto
         throw std::runtime_error("Could not create table file: " + file_path);
     }
     table_file.close();
+    // A map left behind by a dropped table of the same name is stale
+    std::string map_path = "data/" + table_name + ".vm";
+    cache.drop_file(map_path);
+    std::filesystem::remove(map_path);
+    visibility_maps.erase(table_name);
+    open_visibility_map(table_name);
     add_new_page_to_table(table_name);
 
     // Insert into catalog tables
     if (table_name != "sys_tables" && table_name != "sys_columns") {
-        Record table_rec; table_rec.columns = {Value(table_name)};
+        Record table_rec{tx_id, 0, cid, {Value(table_name)}};
         insert_record("sys_tables", table_rec, tx_id, cid);
         for (const auto& col : cols) {
-            Record col_rec; col_rec.columns = {Value(table_name), Value(col.name), Value((int)col.type), Value((int)col.not_null)};
+            Record col_rec{tx_id, 0, cid, {Value(table_name), Value(col.name), Value((int)col.type), Value((int)col.not_null)}};
             insert_record("sys_columns", col_rec, tx_id, cid);
         }
     }
@@ -195,104 +365,181 @@ void StorageEngine::create_table(const std::string& table_name, const std::vecto
     write_wal(tx_id, "CREATE_TABLE", table_name);
 }
 
-void StorageEngine::create_index(const std::string& table_name, const std::string& column_name) {
+void StorageEngine::create_index(const std::string& index_name, const std::string& table_name, const std::vector<std::string>& columns, const std::vector<std::string>& include_columns, IndexType type, int fill_factor, int tx_id, int cid) {
     if (!metadata.count(table_name)) {
         throw std::runtime_error("Table not found: " + table_name);
     }
-    if (metadata.find(table_name) == metadata.end()) {
-        throw std::runtime_error("Table not found in metadata: " + table_name);
+    if (indexes.count(index_name)) {
+        throw std::runtime_error("Index already exists: " + index_name);
     }
     const auto& cols = metadata[table_name];
-    auto it = std::find_if(cols.begin(), cols.end(), [&](const Column& col){ return col.name == column_name; });
-    if (it == cols.end()) {
-        throw std::runtime_error("Column not found: " + column_name);
+    std::vector<std::string> names = columns;
+    names.insert(names.end(), include_columns.begin(), include_columns.end());
+    for (auto name = names.begin(); name != names.end(); ++name) {
+        if (std::none_of(cols.begin(), cols.end(), [&](const Column& col){ return col.name == *name; })) {
+            throw std::runtime_error("Column not found: " + *name);
+        }
+        if (std::find(names.begin(), name, *name) != name) {
+            throw std::runtime_error("Column listed twice in index: " + *name);
+        }
+    }
+    if (type == IndexType::HASH && !include_columns.empty()) {
+        throw std::runtime_error("INCLUDE columns need a B+tree index.");
     }
 
-    std::string index_name = table_name + "_" + column_name + "_idx";
-    indexes[index_name] = std::make_unique<BPlusTree>(cache, table_name + "_" + column_name + ".idx");
-    
-    // Populate the index
-    TransactionManager tx_manager(this);
-    auto records = scan_table(table_name, 0, 0, {}, tx_manager); // Simplified call
-    int col_idx = static_cast<int>(std::distance(cols.begin(), it));
-
-    for(size_t i = 0; i < records.size(); ++i) {
-        const auto& rec = records[i];
-        if(col_idx < rec.columns.size()) {
-            std::string key; 
-			const auto& col_val = rec.columns[col_idx];
-            if (col_val.type == DataType::INT) {
-                key = std::to_string(col_val.int_value);
-            } else if (col_val.type == DataType::STRING) {
-                key = col_val.str_value;
+    // A file left behind by an index whose creation never committed is stale
+    std::string file_path = "data/" + index_name + ".idx";
+    cache.drop_file(file_path);
+    std::filesystem::remove(file_path);
+    open_index(index_name, table_name, columns, include_columns, type);
+    IndexInfo& info = indexes[index_name];
+    KeyFormat format = info.key_format();
+
+    // Index every tuple version on the heap; index scans apply visibility
+    if (type == IndexType::HASH) {
+        // Bucket order is unrelated to key order, so entries go in as the scan finds them
+        for (int page_id = 0; page_id < table_page_counts[table_name]; ++page_id) {
+            PinnedPage page(cache, table_files[table_name], page_id);
+            for (int slot = 0; slot < page.page()->header.item_count; ++slot) {
+                auto key = index_key_of(info, read_record(page.page(), slot, cols.size()));
+                if (key) {
+                    info.hash->insert(*key, {page_id, static_cast<short>(slot)});
+                }
             }
-            Tid tid = {table_name, static_cast<int>(i / 100), static_cast<short>(i % 100)}; // Example Tid
-            indexes[index_name]->insert(key, tid);
         }
+    } else {
+        // The entries are sorted, spilling to run files past INDEX_BUILD_MEMORY,
+        // and the tree is then built bottom-up from the sorted stream
+        int workers = std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, INDEX_BUILD_WORKERS);
+        IndexSorter sorter(format, INDEX_BUILD_MEMORY, file_path + ".sort", workers);
+        for (int page_id = 0; page_id < table_page_counts[table_name]; ++page_id) {
+            PinnedPage page(cache, table_files[table_name], page_id);
+            for (int slot = 0; slot < page.page()->header.item_count; ++slot) {
+                auto key = index_key_of(info, read_record(page.page(), slot, cols.size()));
+                if (key) {
+                    sorter.add(std::move(*key), {page_id, static_cast<short>(slot)});
+                }
+            }
+        }
+        sorter.finish();
+        info.tree->bulk_load([&sorter](std::pair<std::string, Tid>& entry) { return sorter.next(entry); },
+                             fill_factor ? fill_factor : DEFAULT_INDEX_FILL_FACTOR);
     }
-    write_wal(0, "CREATE_INDEX", index_name);
+    // Entries added without a split are not WAL-logged, so the index is written out before it is cataloged
+    cache.flush_file(file_path);
+
+    Record index_rec{tx_id, 0, cid, {Value(index_name), Value(table_name), Value(join_names(columns)), Value((int)type), Value(join_names(include_columns))}};
+    insert_record("sys_indexes", index_rec, tx_id, cid);
+    write_wal(tx_id, "CREATE_INDEX", index_name);
 }
 
-void StorageEngine::create_index(const std::string& index_name, const std::string& table_name, const std::string& column_name) {
-    if (!metadata.count(table_name)) {
-        throw std::runtime_error("Table not found: " + table_name);
+void StorageEngine::open_index(const std::string& index_name, const std::string& table_name, const std::vector<std::string>& columns, const std::vector<std::string>& include_columns, IndexType type) {
+    const auto& cols = metadata[table_name];
+    IndexInfo info{table_name, columns, include_columns, type, {}, nullptr, nullptr};
+    std::vector<DataType> types;
+    std::vector<std::string> names = columns;
+    names.insert(names.end(), include_columns.begin(), include_columns.end());
+    for (const auto& name : names) {
+        auto col = std::find_if(cols.begin(), cols.end(), [&](const Column& c){ return c.name == name; });
+        info.positions.push_back(static_cast<size_t>(std::distance(cols.begin(), col)));
+        types.push_back(col != cols.end() ? col->type : DataType::STRING);
     }
-    if (metadata.find(table_name) == metadata.end()) {
-        throw std::runtime_error("Table not found in metadata: " + table_name);
+    KeyFormat format = key_format_for(types);
+    std::string file_path = "data/" + index_name + ".idx";
+    WalWriter wal_writer = [this](const std::string& operation, const std::string& data) { write_wal(0, operation, data); };
+    if (type == IndexType::HASH) {
+        info.hash = std::make_unique<HashIndex>(cache, file_path, format, wal_writer);
+    } else {
+        info.tree = std::make_unique<BPlusTree>(cache, file_path, format, wal_writer);
     }
-    const auto& cols = metadata[table_name];
-    auto it = std::find_if(cols.begin(), cols.end(), [&](const Column& col){ return col.name == column_name; });
-    if (it == cols.end()) {
-        throw std::runtime_error("Column not found: " + column_name);
+    indexes[index_name] = std::move(info);
+    table_indexes[table_name].push_back(index_name);
+}
+
+void StorageEngine::close_index(const std::string& index_name) {
+    auto it = indexes.find(index_name);
+    auto& names = table_indexes[it->second.table_name];
+    names.erase(std::remove(names.begin(), names.end(), index_name), names.end());
+    if (names.empty()) {
+        table_indexes.erase(it->second.table_name);
     }
+    std::string file_path = "data/" + index_name + ".idx";
+    indexes.erase(it);
+    cache.drop_file(file_path);
+    std::filesystem::remove(file_path);
+}
 
-    // Use the user-provided index name
-    indexes[index_name] = std::make_unique<BPlusTree>(cache, index_name + ".idx");
-    
-    // Populate the index
-    TransactionManager tx_manager(this);
-    auto records = scan_table(table_name, 0, 0, {}, tx_manager); // Simplified call
-    int col_idx = static_cast<int>(std::distance(cols.begin(), it));
-
-    for(size_t i = 0; i < records.size(); ++i) {
-        const auto& rec = records[i];
-        if(col_idx < rec.columns.size()) {
-            std::string key; 
-			const auto& col_val = rec.columns[col_idx];
-            if (col_val.type == DataType::INT) {
-                key = std::to_string(col_val.int_value);
-            } else if (col_val.type == DataType::STRING) {
-                key = col_val.str_value;
+void StorageEngine::insert_record(const std::string& table_name, const Record& record, int tx_id, int cid) {
+    insert_records(table_name, {record}, tx_id, cid);
+}
+
+void StorageEngine::insert_records(const std::string& table_name, const std::vector<Record>& records, int tx_id, int cid) {
+    std::vector<Tid> tids;
+    tids.reserve(records.size());
+    for (const auto& record : records) {
+        tids.push_back(insert_tuple(table_name, record, tx_id, cid));
+    }
+    insert_index_entries(table_name, records, tids);
+}
+
+// Adds the new tuple versions to every index on the table. Each B+tree gets
+// its entries sorted, so consecutive keys landing in the same leaf share
+// one descent from the root.
+void StorageEngine::insert_index_entries(const std::string& table_name, const std::vector<Record>& records, const std::vector<Tid>& tids) {
+    auto names = table_indexes.find(table_name);
+    if (names == table_indexes.end()) {
+        return;
+    }
+    for (const auto& index_name : names->second) {
+        const IndexInfo& info = indexes.at(index_name);
+        KeyFormat format = info.key_format();
+
+        std::vector<std::pair<std::string, Tid>> entries;
+        entries.reserve(records.size());
+        for (size_t i = 0; i < records.size(); ++i) {
+            auto key = index_key_of(info, records[i]);
+            if (key) {
+                entries.emplace_back(std::move(*key), tids[i]);
             }
-            Tid tid = {table_name, static_cast<int>(i / 100), static_cast<short>(i % 100)}; // Create proper Tid
-            indexes[index_name]->insert(key, tid);
         }
+        if (info.hash) {
+            info.hash->insert_sorted(entries);
+            continue;
+        }
+        std::sort(entries.begin(), entries.end(), [format](const auto& a, const auto& b) {
+            int cmp = compare_index_keys(a.first, b.first, format);
+            if (cmp != 0) return cmp < 0;
+            return a.second.page_id != b.second.page_id ? a.second.page_id < b.second.page_id : a.second.offset < b.second.offset;
+        });
+        info.tree->insert_sorted(entries);
     }
-    write_wal(0, "CREATE_INDEX", index_name);
 }
 
-void StorageEngine::insert_record(const std::string& table_name, const Record& record, int tx_id, int cid) {
+Tid StorageEngine::insert_tuple(const std::string& table_name, const Record& record, int tx_id, int cid) {
     char buffer[PAGE_SIZE];
     char* ptr = buffer;
 
-    ptr += sizeof(uint16_t);
-    
-    *reinterpret_cast<int*>(ptr) = record.xmin; ptr += sizeof(int);
-    *reinterpret_cast<int*>(ptr) = record.xmax; ptr += sizeof(int);
-    *reinterpret_cast<int*>(ptr) = record.cid; ptr += sizeof(int);
-    
+    TupleHeader* header = reinterpret_cast<TupleHeader*>(buffer);
+    header->infomask = 0;
+    header->xmin = record.xmin;
+    header->xmax = record.xmax;
+    header->cid = record.cid;
+    ptr += sizeof(TupleHeader);
+
     for (const auto& val : record.columns) {
         ptr = serialize_value(ptr, val);
     }
     uint16_t record_size = static_cast<uint16_t>(ptr - buffer);
 
-    *reinterpret_cast<uint16_t*>(buffer) = record_size;
+    header->length = record_size;
 
-    int page_id = find_page_with_space(table_name, record_size + sizeof(ItemPointer));
     if (table_files.find(table_name) == table_files.end()) {
         throw std::runtime_error("Table not found in file mappings: " + table_name);
     }
-    Page* page = cache.get_page(table_files[table_name], page_id);
+    std::lock_guard<std::mutex> latch(page_latch);
+    int page_id = find_page_with_space(table_name, record_size + sizeof(ItemPointer));
+    PinnedPage pinned(cache, table_files[table_name], page_id);
+    Page* page = pinned.page();
 
     page->header.pd_upper -= record_size;
     std::memcpy(page->data + page->header.pd_upper, buffer, record_size);
@@ -304,51 +551,111 @@ void StorageEngine::insert_record(const std::string& table_name, const Record& r
         page->header.pd_lower += sizeof(ItemPointer);
     }
     page->dirty = true;
+    auto map = visibility_maps.find(table_name);
+    if (map != visibility_maps.end()) {
+        map->second->clear(page_id);
+    }
 
-    update_page_free_space(table_name, page_id, page->header.pd_upper - page->header.pd_lower);
+    // A page whose item pointer array is exhausted cannot take more records
+    uint16_t free_space = page->header.item_count < MAX_ITEM_POINTERS ? page->header.pd_upper - page->header.pd_lower : 0;
+    update_page_free_space(table_name, page_id, free_space);
     // Simplified WAL record
     write_wal(tx_id, "INSERT", table_name);
+    return {page_id, static_cast<short>(page->header.item_count - 1)};
 }
 
-std::vector<Record> StorageEngine::scan_table(const std::string& table_name, int tx_id, int cid, const std::map<int, int>& snapshot, TransactionManager& tx_manager) {
+std::vector<Record> StorageEngine::scan_table(const std::string& table_name, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager) {
+    ScanFilter filter;
+    if (metadata.count(table_name)) {
+        for (size_t i = 0; i < metadata[table_name].size(); ++i) {
+            filter.columns.push_back(i);
+        }
+    }
     std::vector<Record> result;
-    if (table_page_counts.find(table_name) == table_page_counts.end()) {
-        return result;
+    ScanPosition position;
+    auto add_record = [&](const TupleHeader* tuple, const std::vector<ValueView>& views) {
+        Record rec{tuple->xmin, tuple->xmax, tuple->cid, {}};
+        for (size_t pos : filter.columns) {
+            if (pos >= views.size()) break; // Short records end early
+            const ValueView& view = views[pos];
+            if (view.type == DataType::INT) {
+                rec.columns.emplace_back(view.int_value);
+            } else if (view.type == DataType::STRING) {
+                rec.columns.emplace_back(std::string(view.str_value));
+            } else {
+                rec.columns.emplace_back();
+            }
+        }
+        result.push_back(std::move(rec));
+        return true;
+    };
+    while (visit_page(table_name, tx_id, cid, snapshot, tx_manager, filter, position, add_record)) {
     }
-    if (table_page_counts.find(table_name) == table_page_counts.end()) {
-        throw std::runtime_error("Table not found in page counts: " + table_name);
+    return result;
+}
+
+// Tuple bytes never change once written, only their header does, so the
+// predicate can be tested before visibility. Rows it rejects then cost
+// neither a commit-status lookup nor the decoding of any value.
+template <typename Emit>
+bool StorageEngine::visit_page(const std::string& table_name, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager, const ScanFilter& filter, ScanPosition& position, const Emit& emit) {
+    auto page_count = table_page_counts.find(table_name);
+    if (page_count == table_page_counts.end() || position.page_id >= page_count->second) {
+        return false;
     }
-    int page_count = table_page_counts[table_name];
-    for (int i = 0; i < page_count; ++i) {
-        if (table_files.find(table_name) == table_files.end()) {
-            throw std::runtime_error("Table not found in file mappings: " + table_name);
+    auto file = table_files.find(table_name);
+    if (file == table_files.end()) {
+        throw std::runtime_error("Table not found in file mappings: " + table_name);
+    }
+    size_t span = filter.predicate.column_span();
+    if (!filter.columns.empty()) {
+        span = std::max(span, filter.columns.back() + 1);
+    }
+    std::vector<ValueView> views;
+    views.reserve(span);
+    // Pinned, as parallel scans fetch other pages while this one is read
+    PinnedPage pinned(cache, file->second, position.page_id);
+    Page* page = pinned.page();
+    while (position.slot < page->header.item_count) {
+        const auto& item_ptr = page->item_pointers[position.slot++];
+        const char* ptr = page->data + item_ptr.offset + sizeof(TupleHeader);
+        const char* record_end = page->data + item_ptr.offset + item_ptr.length;
+        views.clear();
+        while (views.size() < span && ptr < record_end) {
+            views.emplace_back();
+            ptr = view_value(ptr, views.back());
+        }
+        if (!filter.predicate.matches(views)) {
+            continue;
         }
-        Page* page = cache.get_page(table_files[table_name], i);
-        for (int j = 0; j < page->header.item_count; ++j) {
-            const auto& item_ptr = page->item_pointers[j];
-            const char* ptr = page->data + item_ptr.offset;
-            const char* record_end = ptr + item_ptr.length;
-            Record rec;
-
-            ptr += sizeof(uint16_t);
-            
-            rec.xmin = *reinterpret_cast<const int*>(ptr); ptr += sizeof(int);
-            rec.xmax = *reinterpret_cast<const int*>(ptr); ptr += sizeof(int);
-            rec.cid = *reinterpret_cast<const int*>(ptr); ptr += sizeof(int);
-
-            const auto& cols = get_table_metadata(table_name);
-            for (size_t k = 0; k < cols.size() && ptr < record_end; ++k) {
-                Value val;
-                ptr = deserialize_value(ptr, val);
-                rec.columns.push_back(val);
-            }
 
-            if (is_visible(rec, tx_id, cid, snapshot, tx_manager)) {
-                result.push_back(rec);
-            }
+        TupleHeader* tuple = reinterpret_cast<TupleHeader*>(page->data + item_ptr.offset);
+        uint16_t infomask = tuple->infomask;
+        bool visible = is_visible(tuple, tx_id, cid, snapshot, tx_manager);
+        if (tuple->infomask != infomask) {
+            page->dirty = true; // New hint bits are worth writing back
+        }
+        if (visible && !emit(tuple, views)) {
+            break;
         }
     }
-    return result;
+    if (position.slot >= page->header.item_count) {
+        ++position.page_id;
+        position.slot = 0;
+    }
+    return true;
+}
+
+bool StorageEngine::scan_page(const std::string& table_name, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager, const ScanFilter& filter, ScanPosition& position, RowBatch& batch) {
+    std::vector<ValueView> row(filter.columns.size());
+    return visit_page(table_name, tx_id, cid, snapshot, tx_manager, filter, position, [&](const TupleHeader*, const std::vector<ValueView>& views) {
+        for (size_t i = 0; i < filter.columns.size(); ++i) {
+            // Short records read NULL for columns added later
+            row[i] = filter.columns[i] < views.size() ? views[filter.columns[i]] : ValueView();
+        }
+        batch.append(row.data());
+        return !batch.full();
+    });
 }
 
 void StorageEngine::drop_table(const std::string& table_name) {
@@ -358,7 +665,17 @@ void StorageEngine::drop_table(const std::string& table_name) {
     if (table_files.find(table_name) == table_files.end()) {
         throw std::runtime_error("Table not found in file mappings: " + table_name);
     }
+    auto names = table_indexes.find(table_name);
+    if (names != table_indexes.end()) {
+        for (const auto& index_name : std::vector<std::string>(names->second)) {
+            close_index(index_name);
+        }
+    }
     std::filesystem::remove(table_files[table_name]);
+    std::string map_path = "data/" + table_name + ".vm";
+    cache.drop_file(map_path);
+    std::filesystem::remove(map_path);
+    visibility_maps.erase(table_name);
     metadata.erase(table_name);
     table_files.erase(table_name);
     table_page_counts.erase(table_name);
@@ -366,12 +683,14 @@ void StorageEngine::drop_table(const std::string& table_name) {
     write_wal(0, "DROP_TABLE", table_name);
 }
 
-void StorageEngine::drop_index(const std::string& index_name) {
-    if (indexes.find(index_name) == indexes.end()) {
+void StorageEngine::drop_index(const std::string& index_name, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager) {
+    auto it = indexes.find(index_name);
+    if (it == indexes.end()) {
         throw std::runtime_error("Index not found: " + index_name);
     }
-    indexes.erase(index_name);
-    write_wal(0, "DROP_INDEX", index_name);
+    delete_records("sys_indexes", {{"index_name", "=", Value(index_name)}}, tx_id, cid, snapshot, tx_manager);
+    close_index(index_name);
+    write_wal(tx_id, "DROP_INDEX", index_name);
 }
 
 int StorageEngine::add_new_page_to_table(const std::string& table_name) {
@@ -384,8 +703,6 @@ int StorageEngine::add_new_page_to_table(const std::string& table_name) {
     
     int new_page_id = table_page_counts[table_name]++;
     Page new_page;
-    new_page.header.pd_lower = sizeof(PageHeader);
-    new_page.header.pd_upper = PAGE_SIZE;
     new_page.dirty = true;
     write_page_to_file(table_files[table_name], new_page, new_page_id);
     update_page_free_space(table_name, new_page_id, new_page.header.pd_upper - new_page.header.pd_lower);
@@ -411,20 +728,100 @@ void StorageEngine::update_page_free_space(const std::string& table_name, int pa
     free_space_maps[table_name][page_id] = new_free_space;
 }
 
-bool StorageEngine::is_visible(const Record& rec, int tx_id, int cid, const std::map<int, int>& snapshot, TransactionManager& tx_manager) {
-    if (tx_manager.is_aborted(rec.xmin)) {
+// Row lock: a tuple is locked by the transaction stamped in its xmax. A live
+// locker makes us wait for it to finish; a committed one means the row was
+// changed after our snapshot was taken. A locker still in progress in the
+// commit log but unknown to the transaction manager died in a crash before
+// it logged anything, so it is marked aborted; it is checked for activity
+// before its status is read again, as a live one is marked finished before
+// it leaves the active set.
+void StorageEngine::lock_tuple(const std::string& table_name, int page_id, int slot, int tx_id, TransactionManager& tx_manager) {
+    while (true) {
+        int locker;
+        {
+            std::lock_guard<std::mutex> latch(page_latch);
+            PinnedPage pinned(cache, table_files[table_name], page_id);
+            Page* page = pinned.page();
+            TupleHeader* tuple = reinterpret_cast<TupleHeader*>(page->data + page->item_pointers[slot].offset);
+            locker = tuple->xmax;
+            TxStatus status = locker == 0 ? TxStatus::ABORTED : tx_manager.get_status(locker);
+            if (status == TxStatus::IN_PROGRESS && locker != tx_id && !tx_manager.is_active(locker) &&
+                tx_manager.get_status(locker) == TxStatus::IN_PROGRESS) {
+                clog.set_status(locker, TxStatus::ABORTED);
+                status = TxStatus::ABORTED;
+            }
+            if (locker == tx_id || status == TxStatus::ABORTED) {
+                tuple->xmax = tx_id;
+                tuple->infomask &= ~(HEAP_XMAX_COMMITTED | HEAP_XMAX_ABORTED);
+                page->dirty = true;
+                visibility_maps.at(table_name)->clear(page_id);
+                return;
+            }
+            if (status == TxStatus::COMMITTED) {
+                throw std::runtime_error("Could not serialize access due to concurrent update on table " + table_name);
+            }
+        }
+        tx_manager.wait_for_transaction(tx_id, locker);
+    }
+}
+
+Record StorageEngine::read_record(const Page* page, int slot, size_t column_count) {
+    const auto& item_ptr = page->item_pointers[slot];
+    const TupleHeader* tuple = reinterpret_cast<const TupleHeader*>(page->data + item_ptr.offset);
+    const char* ptr = page->data + item_ptr.offset + sizeof(TupleHeader);
+    const char* record_end = page->data + item_ptr.offset + item_ptr.length;
+
+    Record rec;
+    rec.xmin = tuple->xmin;
+    rec.xmax = tuple->xmax;
+    rec.cid = tuple->cid;
+    for (size_t k = 0; k < column_count && ptr < record_end; ++k) {
+        Value val;
+        ptr = deserialize_value(ptr, val);
+        rec.columns.push_back(val);
+    }
+    return rec;
+}
+
+// Hint bits are only ever set once a transaction has finished, so a set bit
+// answers the commit-status question without consulting the commit log.
+bool StorageEngine::is_visible(TupleHeader* tuple, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager) {
+    if (tuple->infomask & HEAP_XMIN_ABORTED) {
         return false;
     }
-    if (rec.xmin == tx_id) {
-        return rec.xmax == 0;
+    if (tuple->xmin == tx_id) {
+        return tuple->xmax == 0;
+    }
+    if (!snapshot.is_finished(tuple->xmin)) {
+        return false;
+    }
+    if (!(tuple->infomask & HEAP_XMIN_COMMITTED)) {
+        TxStatus status = tx_manager.get_status(tuple->xmin);
+        if (status == TxStatus::COMMITTED) {
+            tuple->infomask |= HEAP_XMIN_COMMITTED;
+        } else {
+            if (status == TxStatus::ABORTED) {
+                tuple->infomask |= HEAP_XMIN_ABORTED;
+            }
+            return false;
+        }
+    }
+
+    if (tuple->xmax == 0) return true;
+    if (tuple->xmax == tx_id) return false; // Deleted by ourselves
+    if (tuple->infomask & HEAP_XMAX_ABORTED) return true;
+    if (!snapshot.is_finished(tuple->xmax)) return true;
+    if (tuple->infomask & HEAP_XMAX_COMMITTED) return false;
+
+    TxStatus status = tx_manager.get_status(tuple->xmax);
+    if (status == TxStatus::COMMITTED) {
+        tuple->infomask |= HEAP_XMAX_COMMITTED;
+        return false;
     }
-    if (tx_manager.is_committed(rec.xmin) && snapshot.count(rec.xmin)) {
-        if (rec.xmax == 0) return true;
-        if (rec.xmax == tx_id) return true;
-        if (tx_manager.is_aborted(rec.xmax)) return true;
-        if (!tx_manager.is_committed(rec.xmax) || !snapshot.count(rec.xmax)) return true;
+    if (status == TxStatus::ABORTED) {
+        tuple->infomask |= HEAP_XMAX_ABORTED;
     }
-    return false;
+    return true;
 }
 
 void StorageEngine::write_page_to_file(const std::string& file, const Page& page, int page_id) {
@@ -450,6 +847,7 @@ const std::vector<Column>& StorageEngine::get_table_metadata(const std::string&
 }
 
 void StorageEngine::write_wal(int tx_id, const std::string& operation, const std::string& data) {
+    std::lock_guard<std::mutex> guard(wal_mutex);
     if (wal_log.is_open()) {
         wal_log << tx_id << " " << operation << " " << data << std::endl;
     }
@@ -457,81 +855,12 @@ void StorageEngine::write_wal(int tx_id, const std::string& operation, const std
 
 void StorageEngine::flush_buffer_pool() {
     cache.flush_all();
+    // Every page image logged so far is now on disk; recovery starts after this
+    write_wal(0, "CHECKPOINT", "");
 }
 
 // Helper function to evaluate WHERE conditions against a record
-bool StorageEngine::evaluate_conditions(const Record& record, const std::vector<WhereCondition>& conditions, const std::vector<Column>& table_metadata) {
-    if (conditions.empty()) {
-        return true; // No conditions means all records match
-    }
-    
-    for (const auto& condition : conditions) {
-        bool condition_met = false;
-        
-        // Find the column index
-        int col_index = -1;
-        for (size_t i = 0; i < table_metadata.size(); ++i) {
-            if (table_metadata[i].name == condition.column) {
-                col_index = i;
-                break;
-            }
-        }
-        
-        if (col_index == -1 || col_index >= (int)record.columns.size()) {
-            return false; // Column not found, record doesn't match
-        }
-        
-        const Value& col_value = record.columns[col_index];
-        const Value& filter_value = condition.value;
-        
-        // Apply the condition
-        if (condition.op == "=") {
-            condition_met = (col_value.type == filter_value.type) &&
-                           ((col_value.type == DataType::INT && col_value.int_value == filter_value.int_value) ||
-                            (col_value.type == DataType::STRING && col_value.str_value == filter_value.str_value));
-        } else if (condition.op == "!=") {
-            condition_met = (col_value.type != filter_value.type) ||
-                           ((col_value.type == DataType::INT && col_value.int_value != filter_value.int_value) ||
-                            (col_value.type == DataType::STRING && col_value.str_value != filter_value.str_value));
-        } else if (condition.op == "<") {
-            if (col_value.type == DataType::INT && filter_value.type == DataType::INT) {
-                condition_met = col_value.int_value < filter_value.int_value;
-            } else if (col_value.type == DataType::STRING && filter_value.type == DataType::STRING) {
-                condition_met = col_value.str_value < filter_value.str_value;
-            }
-        } else if (condition.op == ">") {
-            if (col_value.type == DataType::INT && filter_value.type == DataType::INT) {
-                condition_met = col_value.int_value > filter_value.int_value;
-            } else if (col_value.type == DataType::STRING && filter_value.type == DataType::STRING) {
-                condition_met = col_value.str_value > filter_value.str_value;
-            }
-        } else if (condition.op == "<=") {
-            if (col_value.type == DataType::INT && filter_value.type == DataType::INT) {
-                condition_met = col_value.int_value <= filter_value.int_value;
-            } else if (col_value.type == DataType::STRING && filter_value.type == DataType::STRING) {
-                condition_met = col_value.str_value <= filter_value.str_value;
-            }
-        } else if (condition.op == ">=") {
-            if (col_value.type == DataType::INT && filter_value.type == DataType::INT) {
-                condition_met = col_value.int_value >= filter_value.int_value;
-            } else if (col_value.type == DataType::STRING && filter_value.type == DataType::STRING) {
-                condition_met = col_value.str_value >= filter_value.str_value;
-            }
-        } else if (condition.op == "LIKE") {
-            if (col_value.type == DataType::STRING && filter_value.type == DataType::STRING) {
-                condition_met = col_value.str_value.find(filter_value.str_value) != std::string::npos;
-            }
-        }
-        
-        if (!condition_met) {
-            return false; // AND logic: if any condition fails, the record doesn't match
-        }
-    }
-    
-    return true; // All conditions passed
-}
-
-int StorageEngine::delete_records(const std::string& table_name, const std::vector<WhereCondition>& conditions, int tx_id, int cid, const std::map<int, int>& snapshot, TransactionManager& tx_manager) {
+int StorageEngine::delete_records(const std::string& table_name, const std::vector<WhereCondition>& conditions, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager) {
     int deleted_count = 0;
     
     if (table_page_counts.find(table_name) == table_page_counts.end()) {
@@ -539,34 +868,34 @@ int StorageEngine::delete_records(const std::string& table_name, const std::vect
     }
     
     const auto& table_cols = get_table_metadata(table_name);
+    Predicate predicate(conditions, column_names(table_cols));
     int page_count = table_page_counts[table_name];
     
     for (int i = 0; i < page_count; ++i) {
-        Page* page = cache.get_page(table_files[table_name], i);
+        PinnedPage pinned(cache, table_files[table_name], i);
+        Page* page = pinned.page();
         bool page_modified = false;
         
         for (int j = 0; j < page->header.item_count; ++j) {
-            const auto& item_ptr = page->item_pointers[j];
-            const char* ptr = page->data + item_ptr.offset;
-            const char* record_end = ptr + item_ptr.length;
-            Record rec;
-            
-            ptr += sizeof(uint16_t);
-            rec.xmin = *reinterpret_cast<const int*>(ptr); ptr += sizeof(int);
-            rec.xmax = *reinterpret_cast<const int*>(ptr); ptr += sizeof(int);
-            rec.cid = *reinterpret_cast<const int*>(ptr); ptr += sizeof(int);
-            
-            for (size_t k = 0; k < table_cols.size() && ptr < record_end; ++k) {
-                Value val;
-                ptr = deserialize_value(ptr, val);
-                rec.columns.push_back(val);
+            TupleHeader* tuple = reinterpret_cast<TupleHeader*>(page->data + page->item_pointers[j].offset);
+            uint16_t infomask = tuple->infomask;
+            bool visible = is_visible(tuple, tx_id, cid, snapshot, tx_manager);
+            if (tuple->infomask != infomask) {
+                page_modified = true;
             }
-            
-            if (is_visible(rec, tx_id, cid, snapshot, tx_manager) && evaluate_conditions(rec, conditions, table_cols)) {
+            if (!visible) {
+                continue;
+            }
+            Record rec = read_record(page, j, table_cols.size());
+
+            if (predicate.matches(rec.columns)) {
+                // Logged before the first xmax stamp can reach disk, so
+                // recovery knows to abort this xid after a crash
+                if (deleted_count == 0) {
+                    write_wal(tx_id, "DELETE", table_name);
+                }
                 // Mark record as deleted by setting xmax
-                char* xmax_ptr = page->data + item_ptr.offset + sizeof(uint16_t) + sizeof(int);
-                *reinterpret_cast<int*>(xmax_ptr) = tx_id;
-                page_modified = true;
+                lock_tuple(table_name, i, j, tx_id, tx_manager);
                 deleted_count++;
             }
         }
@@ -575,11 +904,11 @@ int StorageEngine::delete_records(const std::string& table_name, const std::vect
             page->dirty = true;
         }
     }
-    
+
     return deleted_count;
 }
 
-int StorageEngine::update_records(const std::string& table_name, const std::vector<WhereCondition>& conditions, const std::map<std::string, Value>& set_clause, int tx_id, int cid, const std::map<int, int>& snapshot, TransactionManager& tx_manager) {
+int StorageEngine::update_records(const std::string& table_name, const std::vector<WhereCondition>& conditions, const std::map<std::string, Value>& set_clause, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager) {
     int updated_count = 0;
     
     if (table_page_counts.find(table_name) == table_page_counts.end()) {
@@ -587,37 +916,36 @@ int StorageEngine::update_records(const std::string& table_name, const std::vect
     }
     
     const auto& table_cols = get_table_metadata(table_name);
+    Predicate predicate(conditions, column_names(table_cols));
     int page_count = table_page_counts[table_name]; // Capture original page count to avoid infinite loop
     
     // First pass: collect records to update and mark them as deleted
     std::vector<Record> records_to_update;
     
     for (int i = 0; i < page_count; ++i) {
-        Page* page = cache.get_page(table_files[table_name], i);
+        PinnedPage pinned(cache, table_files[table_name], i);
+        Page* page = pinned.page();
         bool page_modified = false;
         
         for (int j = 0; j < page->header.item_count; ++j) {
-            const auto& item_ptr = page->item_pointers[j];
-            const char* ptr = page->data + item_ptr.offset;
-            const char* record_end = ptr + item_ptr.length;
-            Record rec;
-            
-            ptr += sizeof(uint16_t);
-            rec.xmin = *reinterpret_cast<const int*>(ptr); ptr += sizeof(int);
-            rec.xmax = *reinterpret_cast<const int*>(ptr); ptr += sizeof(int);
-            rec.cid = *reinterpret_cast<const int*>(ptr); ptr += sizeof(int);
-            
-            for (size_t k = 0; k < table_cols.size() && ptr < record_end; ++k) {
-                Value val;
-                ptr = deserialize_value(ptr, val);
-                rec.columns.push_back(val);
+            TupleHeader* tuple = reinterpret_cast<TupleHeader*>(page->data + page->item_pointers[j].offset);
+            uint16_t infomask = tuple->infomask;
+            bool visible = is_visible(tuple, tx_id, cid, snapshot, tx_manager);
+            if (tuple->infomask != infomask) {
+                page_modified = true;
             }
-            
-            if (is_visible(rec, tx_id, cid, snapshot, tx_manager) && evaluate_conditions(rec, conditions, table_cols)) {
+            if (!visible) {
+                continue;
+            }
+            Record rec = read_record(page, j, table_cols.size());
+
+            if (predicate.matches(rec.columns)) {
+                // Logged before the first xmax stamp, as in delete_records
+                if (records_to_update.empty()) {
+                    write_wal(tx_id, "UPDATE", table_name);
+                }
                 // Mark old record as deleted
-                char* xmax_ptr = page->data + item_ptr.offset + sizeof(uint16_t) + sizeof(int);
-                *reinterpret_cast<int*>(xmax_ptr) = tx_id;
-                page_modified = true;
+                lock_tuple(table_name, i, j, tx_id, tx_manager);
                 
                 // Store record for updating
                 records_to_update.push_back(rec);
@@ -630,6 +958,7 @@ int StorageEngine::update_records(const std::string& table_name, const std::vect
     }
     
     // Second pass: insert updated records
+    std::vector<Record> new_versions;
     for (const auto& old_rec : records_to_update) {
         Record updated_rec = old_rec;
         
@@ -652,12 +981,254 @@ int StorageEngine::update_records(const std::string& table_name, const std::vect
         updated_rec.xmax = 0;
         updated_rec.cid = cid;
         
-        insert_record(table_name, updated_rec, tx_id, cid);
+        new_versions.push_back(updated_rec);
         updated_count++;
     }
+    insert_records(table_name, new_versions, tx_id, cid);
     
     return updated_count;
 }
-std::vector<Record> StorageEngine::index_scan(const std::string& table_name, const std::string& column, const Value& value, int tx_id, int cid, const std::map<int, int>& snapshot, TransactionManager& tx_manager) { return {}; }
-void StorageEngine::vacuum_table(const std::string& table_name, TransactionManager& tx_manager) {}
-bool StorageEngine::has_index(const std::string& table_name, const std::string& column) const { return false; }
\ No newline at end of file
+
+// Turns the conditions on the index column into one key range, or for a hash
+// index into one probe key, and returns the matching entries. With keys, it
+// also returns each entry's key.
+// Equalities on a leading run of the key columns fix a key prefix, and a
+// range on the next key column narrows the entries under that prefix.
+// Conditions on later columns are left to the caller's recheck.
+std::vector<Tid> StorageEngine::index_lookup(const IndexInfo& info, const std::vector<WhereCondition>& conditions, std::vector<std::string>* keys) {
+    KeyFormat format = info.key_format();
+    std::vector<Value> prefix;
+    for (const auto& column : info.columns) {
+        auto eq = std::find_if(conditions.begin(), conditions.end(),
+                               [&](const WhereCondition& c){ return c.column == column && c.op == "="; });
+        if (eq == conditions.end()) break;
+        prefix.push_back(eq->value);
+    }
+    if (info.hash) {
+        if (prefix.size() < info.columns.size()) {
+            throw std::runtime_error("Hash index on " + join_names(info.columns) + " needs equality on every column");
+        }
+        std::string key = encode_index_key(prefix, format);
+        std::vector<Tid> tids = info.hash->search(key);
+        if (keys) keys->assign(tids.size(), key); // Every match has the probe key
+        return tids;
+    }
+
+    std::string low = encode_index_key(prefix, format); // The empty key sorts before every other key
+    std::optional<std::string> high;
+    if (prefix.size() < info.columns.size()) {
+        const std::string& next = info.columns[prefix.size()];
+        std::vector<Value> bound = prefix;
+        bound.emplace_back();
+        for (const auto& cond : conditions) {
+            if (cond.column != next) continue;
+            bound.back() = cond.value;
+            std::string key = encode_index_key(bound, format);
+            if (cond.op == ">" || cond.op == ">=") {
+                if (compare_index_keys(key, low, format) > 0) low = key;
+            }
+            if (cond.op == "<" || cond.op == "<=") {
+                if (!high || compare_index_keys(key, *high, format) < 0) high = key;
+            }
+        }
+    }
+    // Without an upper bound on the next column the prefix alone ends the scan
+    if (!high && !prefix.empty()) {
+        high = encode_index_key(prefix, format);
+    }
+    if (high && compare_index_keys(std::string_view(low).substr(0, high->size()), *high, format) > 0) {
+        return {};
+    }
+    return keys ? info.tree->search_range(low, high, *keys) : info.tree->search_range(low, high);
+}
+
+// Visits the heap tuples of the matching index entries in page order. Every
+// tuple is rechecked against the conditions, which also takes care of strict
+// bounds and of the conditions a hash probe cannot use.
+std::vector<Record> StorageEngine::index_scan(const std::string& table_name, const std::string& index_name, const std::vector<WhereCondition>& conditions, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager) {
+    auto index = indexes.find(index_name);
+    if (index == indexes.end()) {
+        throw std::runtime_error("Index not found: " + index_name);
+    }
+    const auto& cols = get_table_metadata(table_name);
+    Predicate predicate(conditions, column_names(cols));
+
+    std::vector<Tid> tids = index_lookup(index->second, conditions, nullptr);
+    std::sort(tids.begin(), tids.end(), [](const Tid& a, const Tid& b) {
+        return a.page_id != b.page_id ? a.page_id < b.page_id : a.offset < b.offset;
+    });
+
+    std::vector<Record> result;
+    const std::string& file = table_files[table_name];
+    int page_count = table_page_counts[table_name];
+    PinnedPage pinned;
+    for (const Tid& tid : tids) {
+        if (tid.page_id >= page_count) continue;
+        if (tid.page_id != pinned.id()) {
+            pinned = PinnedPage(cache, file, tid.page_id);
+        }
+        Page* page = pinned.page();
+        if (tid.offset >= page->header.item_count) continue;
+
+        TupleHeader* tuple = reinterpret_cast<TupleHeader*>(page->data + page->item_pointers[tid.offset].offset);
+        uint16_t infomask = tuple->infomask;
+        bool visible = is_visible(tuple, tx_id, cid, snapshot, tx_manager);
+        if (tuple->infomask != infomask) {
+            page->dirty = true; // New hint bits are worth writing back
+        }
+        if (!visible) continue;
+        Record rec = read_record(page, tid.offset, cols.size());
+        if (predicate.matches(rec.columns)) {
+            result.push_back(rec);
+        }
+    }
+    return result;
+}
+
+// Entries are returned in index order with their columns decoded from the
+// key. The heap is read only to check the visibility of entries on pages
+// the visibility map does not mark all-visible.
+std::vector<Record> StorageEngine::index_only_scan(const std::string& table_name, const std::string& index_name, const std::vector<WhereCondition>& conditions, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager) {
+    auto index = indexes.find(index_name);
+    if (index == indexes.end()) {
+        throw std::runtime_error("Index not found: " + index_name);
+    }
+    const IndexInfo& info = index->second;
+    const auto& table_cols = get_table_metadata(table_name);
+    std::vector<Column> cols; // The index's columns, as the records below hold them
+    std::vector<DataType> types;
+    for (size_t pos : info.positions) {
+        cols.push_back(table_cols.at(pos));
+        types.push_back(table_cols.at(pos).type);
+    }
+    Predicate predicate(conditions, column_names(cols));
+
+    std::vector<std::string> keys;
+    std::vector<Tid> tids = index_lookup(info, conditions, &keys);
+    VisibilityMap& map = *visibility_maps.at(table_name);
+    const std::string& file = table_files[table_name];
+    int page_count = table_page_counts[table_name];
+    std::vector<Record> result;
+    for (size_t i = 0; i < tids.size(); ++i) {
+        const Tid& tid = tids[i];
+        if (tid.page_id >= page_count) continue;
+        if (!map.all_visible(tid.page_id)) {
+            PinnedPage pinned(cache, file, tid.page_id);
+            Page* page = pinned.page();
+            if (tid.offset >= page->header.item_count) continue;
+            TupleHeader* tuple = reinterpret_cast<TupleHeader*>(page->data + page->item_pointers[tid.offset].offset);
+            uint16_t infomask = tuple->infomask;
+            bool visible = is_visible(tuple, tx_id, cid, snapshot, tx_manager);
+            if (tuple->infomask != infomask) {
+                page->dirty = true; // New hint bits are worth writing back
+            }
+            if (!visible) continue;
+        }
+        Record rec;
+        rec.columns = decode_index_key(keys[i], types, info.key_format());
+        if (predicate.matches(rec.columns)) {
+            result.push_back(std::move(rec));
+        }
+    }
+    return result;
+}
+
+// Marks the pages whose every tuple is visible to all transactions, present
+// and future, in the visibility map, setting hint bits along the way. Dead
+// tuples and those of aborted transactions keep their page out of the map.
+void StorageEngine::vacuum_table(const std::string& table_name, TransactionManager& tx_manager) {
+    if (table_files.find(table_name) == table_files.end()) {
+        throw std::runtime_error("Table not found: " + table_name);
+    }
+    int horizon = tx_manager.oldest_xmin();
+    VisibilityMap& map = *visibility_maps.at(table_name);
+    for (int page_id = 0; page_id < table_page_counts[table_name]; ++page_id) {
+        // Held across the check and the map update, so no insert or row lock slips in between
+        std::lock_guard<std::mutex> latch(page_latch);
+        PinnedPage pinned(cache, table_files[table_name], page_id);
+        Page* page = pinned.page();
+        bool all_visible = true;
+        for (int slot = 0; slot < page->header.item_count && all_visible; ++slot) {
+            TupleHeader* tuple = reinterpret_cast<TupleHeader*>(page->data + page->item_pointers[slot].offset);
+            uint16_t infomask = tuple->infomask;
+            if (!(tuple->infomask & HEAP_XMIN_COMMITTED) && tuple->xmin < horizon &&
+                tx_manager.get_status(tuple->xmin) == TxStatus::COMMITTED) {
+                tuple->infomask |= HEAP_XMIN_COMMITTED;
+            }
+            if (tuple->xmax != 0 && !(tuple->infomask & HEAP_XMAX_ABORTED) &&
+                tx_manager.get_status(tuple->xmax) == TxStatus::ABORTED) {
+                tuple->infomask |= HEAP_XMAX_ABORTED;
+            }
+            if (tuple->infomask != infomask) {
+                page->dirty = true;
+            }
+            all_visible = (tuple->infomask & HEAP_XMIN_COMMITTED) && tuple->xmin < horizon &&
+                          (tuple->xmax == 0 || (tuple->infomask & HEAP_XMAX_ABORTED));
+        }
+        if (all_visible) {
+            map.set_all_visible(page_id);
+        }
+    }
+}
+
+bool StorageEngine::has_index(const std::string& table_name, const std::string& column) const {
+    size_t matched = 0;
+    return !find_index(table_name, {{column, "=", Value()}}, matched).empty();
+}
+
+std::string StorageEngine::find_index(const std::string& table_name, const std::vector<WhereCondition>& conditions, size_t& matched) const {
+    auto has_condition = [&conditions](const std::string& column, bool equality) {
+        return std::any_of(conditions.begin(), conditions.end(), [&](const WhereCondition& c) {
+            bool range = c.op == "<" || c.op == "<=" || c.op == ">" || c.op == ">=";
+            return c.column == column && (equality ? c.op == "=" : range);
+        });
+    };
+    std::string found;
+    int best = 0;
+    matched = 0;
+    for (const auto& [index_name, info] : indexes) {
+        if (info.table_name != table_name) continue;
+        size_t equalities = 0;
+        while (equalities < info.columns.size() && has_condition(info.columns[equalities], true)) {
+            ++equalities;
+        }
+        bool range = equalities < info.columns.size() && has_condition(info.columns[equalities], false);
+        // Each equality narrows more than a range; a bucket lookup beats a descent
+        int score;
+        if (info.type == IndexType::HASH) {
+            if (equalities < info.columns.size()) continue;
+            score = 2 * static_cast<int>(equalities) + 1;
+        } else {
+            score = 2 * static_cast<int>(equalities) + (range ? 1 : 0);
+        }
+        if (score > best) {
+            best = score;
+            found = index_name;
+            matched = equalities + (range ? 1 : 0);
+        }
+    }
+    return found;
+}
+
+std::vector<std::string> StorageEngine::index_columns(const std::string& index_name) const {
+    auto it = indexes.find(index_name);
+    if (it == indexes.end()) {
+        return {};
+    }
+    std::vector<std::string> columns = it->second.columns;
+    columns.insert(columns.end(), it->second.include_columns.begin(), it->second.include_columns.end());
+    return columns;
+}
+
+int StorageEngine::page_count(const std::string& table_name) const {
+    auto it = table_page_counts.find(table_name);
+    return it == table_page_counts.end() ? 0 : it->second;
+}
+
+std::vector<std::string> StorageEngine::table_names() const {
+    std::vector<std::string> names;
+    for (const auto& [table_name, cols] : metadata) {
+        names.push_back(table_name);
+    }
+    return names;
+}
\ No newline at end of file
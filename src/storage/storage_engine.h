@@ -6,19 +6,26 @@
 #include <fstream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include "../index/bplus_tree.h"
+#include "../index/hash_index.h"
+#include "visibility_map.h"
 #include "../parser/sql_parser.h"
 #include "../common/value.h"
 #include "../common/page.h"
+#include "../common/predicate.h"
+#include "../transaction/snapshot.h"
+#include "../transaction/commit_log.h"
+#include "../executor/row_batch.h"
 
 // Forward declarations to avoid circular dependency
 class TransactionManager;
 class BufferCache;
 
 struct Record {
-    int xmin;
-    int xmax;
-    int cid;
+    int xmin = 0;
+    int xmax = 0;
+    int cid = 0;
     std::vector<Value> columns;
 };
 
@@ -28,28 +35,84 @@ struct Column {
     bool not_null;
 };
 
+enum class IndexType {
+    BTREE = 0,
+    HASH = 1 // Equality lookups only
+};
+
+struct IndexInfo {
+    std::string table_name;
+    std::vector<std::string> columns; // Key columns, most significant first
+    // B+tree only: stored as trailing key columns, so a scan needing no
+    // other column can answer from the index
+    std::vector<std::string> include_columns;
+    IndexType type = IndexType::BTREE;
+    std::vector<size_t> positions; // Table column of each key column, then of each INCLUDE column
+    std::unique_ptr<BPlusTree> tree; // BTREE
+    std::unique_ptr<HashIndex> hash; // HASH
+
+    KeyFormat key_format() const { return tree ? tree->key_format() : hash->key_format(); }
+};
+
+
+// What a sequential scan leaves to the storage layer: the predicate is
+// tested on the tuple bytes in the page, and only the listed columns of the
+// tuples that pass are decoded into the records
+struct ScanFilter {
+    Predicate predicate; // Over the table's columns
+    std::vector<size_t> columns; // Ascending table column positions
+};
+
+// Where a scan resumes: the next tuple slot of a heap page
+struct ScanPosition {
+    int page_id = 0;
+    int slot = 0;
+};
+
+const int DEFAULT_INDEX_FILL_FACTOR = 90;
+const size_t INDEX_BUILD_MEMORY = 16 * 1024 * 1024; // Sort buffer of CREATE INDEX before it spills runs
+const int INDEX_BUILD_WORKERS = 4; // Upper bound on threads sorting a run
 
 class StorageEngine {
 public:
     StorageEngine(BufferCache& cache);
     void create_table(const std::string& table_name, const std::vector<ColumnDefinition>& columns, int tx_id, int cid);
-    void create_index(const std::string& table_name, const std::string& column);
-    void create_index(const std::string& index_name, const std::string& table_name, const std::string& column);
+    // fill_factor is the percentage of each B+tree node filled by the build, 0 for the default
+    void create_index(const std::string& index_name, const std::string& table_name, const std::vector<std::string>& columns, const std::vector<std::string>& include_columns, IndexType type, int fill_factor, int tx_id, int cid);
     void insert_record(const std::string& table_name, const Record& record, int tx_id, int cid);
-    std::vector<Record> scan_table(const std::string& table_name, int tx_id, int cid, const std::map<int, int>& snapshot, TransactionManager& tx_manager);
-    std::vector<Record> index_scan(const std::string& table_name, const std::string& column, const Value& value, int tx_id, int cid, const std::map<int, int>& snapshot, TransactionManager& tx_manager);
-    int delete_records(const std::string& table_name, const std::vector<WhereCondition>& conditions, int tx_id, int cid, const std::map<int, int>& snapshot, TransactionManager& tx_manager);
-    int update_records(const std::string& table_name, const std::vector<WhereCondition>& conditions, const std::map<std::string, Value>& set_clause, int tx_id, int cid, const std::map<int, int>& snapshot, TransactionManager& tx_manager);
+    void insert_records(const std::string& table_name, const std::vector<Record>& records, int tx_id, int cid);
+    std::vector<Record> scan_table(const std::string& table_name, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager);
+    // Appends the visible tuples of position's page that satisfy filter to
+    // batch, their filter columns viewed in the page and copied once into the
+    // batch, until the page ends or the batch is full. position moves past
+    // them, onto the next page at the page's end; false once it is past the
+    // last page. Scans of different pages may run on several threads.
+    bool scan_page(const std::string& table_name, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager, const ScanFilter& filter, ScanPosition& position, RowBatch& batch);
+    std::vector<Record> index_scan(const std::string& table_name, const std::string& index_name, const std::vector<WhereCondition>& conditions, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager);
+    // Like index_scan, but records hold only index_columns(index_name), and
+    // heap pages are read only where the visibility map cannot vouch for them
+    std::vector<Record> index_only_scan(const std::string& table_name, const std::string& index_name, const std::vector<WhereCondition>& conditions, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager);
+    int delete_records(const std::string& table_name, const std::vector<WhereCondition>& conditions, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager);
+    int update_records(const std::string& table_name, const std::vector<WhereCondition>& conditions, const std::map<std::string, Value>& set_clause, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager);
     bool has_index(const std::string& table_name, const std::string& column) const;
+    // Index whose key columns best match conditions: equalities on a leading
+    // run of them, then optionally a range on the next one. A hash index needs
+    // equality on every key column and wins a tie. matched is set to the
+    // number of key columns the lookup uses; empty when no index applies.
+    std::string find_index(const std::string& table_name, const std::vector<WhereCondition>& conditions, size_t& matched) const;
+    std::vector<std::string> index_columns(const std::string& index_name) const; // Key columns, then INCLUDE columns
+    std::vector<std::string> table_names() const;
+    int page_count(const std::string& table_name) const;
     void write_page_to_file(const std::string& file, const Page& page, int page_id);
     void read_page_from_file(const std::string& file, int page_id, Page& page);
     void drop_table(const std::string& table_name);
-    void drop_index(const std::string& index_name);
+    void drop_index(const std::string& index_name, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager);
     void vacuum_table(const std::string& table_name, TransactionManager& tx_manager);
     const std::vector<Column>& get_table_metadata(const std::string& table_name);
     void recover_from_wal();
     void write_wal(int tx_id, const std::string& operation, const std::string& data);
     void flush_buffer_pool();
+    CommitLog& commit_log() { return clog; }
 
 private:
     BufferCache& cache;
@@ -57,18 +120,38 @@ private:
     std::map<std::string, std::string> table_files; // table_name -> file_path
     std::map<std::string, int> table_page_counts;
     std::map<std::string, std::map<int, uint16_t>> free_space_maps; // table_name -> {page_id -> free_space}
-    std::map<std::string, std::unique_ptr<BPlusTree>> indexes;
+    std::map<std::string, IndexInfo> indexes; // index_name -> definition and tree
+    std::map<std::string, std::vector<std::string>> table_indexes; // table_name -> index names
+    std::map<std::string, std::unique_ptr<VisibilityMap>> visibility_maps; // table_name -> all-visible page bits
     std::fstream wal_log;
+    std::mutex wal_mutex; // Index splits log page images from any thread
+    std::mutex page_latch; // Short-term latch for heap page placement and xmax stamping
+    CommitLog clog;
 
     void bootstrap_catalog();
     void load_catalog();
+    void load_indexes();
+    void open_index(const std::string& index_name, const std::string& table_name, const std::vector<std::string>& columns, const std::vector<std::string>& include_columns, IndexType type);
+    void close_index(const std::string& index_name); // Also removes the index file
 
     int add_new_page_to_table(const std::string& table_name);
     int find_page_with_space(const std::string& table_name, uint16_t required_space);
     void update_page_free_space(const std::string& table_name, int page_id, uint16_t new_free_space);
 
-    bool is_visible(const Record& rec, int tx_id, int cid, const std::map<int, int>& snapshot, TransactionManager& tx_manager);
-    bool evaluate_conditions(const Record& record, const std::vector<WhereCondition>& conditions, const std::vector<Column>& table_metadata);
+    Tid insert_tuple(const std::string& table_name, const Record& record, int tx_id, int cid);
+    void insert_index_entries(const std::string& table_name, const std::vector<Record>& records, const std::vector<Tid>& tids);
+    std::vector<Tid> index_lookup(const IndexInfo& info, const std::vector<WhereCondition>& conditions, std::vector<std::string>* keys);
+    void open_visibility_map(const std::string& table_name);
+
+    // Calls emit(tuple, views) for each visible tuple of position's page
+    // that satisfies filter, from position on, until emit returns false;
+    // views hold the tuple's leading values, through the last one filter
+    // needs. Moves position as scan_page does.
+    template <typename Emit>
+    bool visit_page(const std::string& table_name, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager, const ScanFilter& filter, ScanPosition& position, const Emit& emit);
+    bool is_visible(TupleHeader* tuple, int tx_id, int cid, const Snapshot& snapshot, TransactionManager& tx_manager);
+    void lock_tuple(const std::string& table_name, int page_id, int slot, int tx_id, TransactionManager& tx_manager);
+    Record read_record(const Page* page, int slot, size_t column_count);
 };
 
 #endif
@@ -0,0 +1,63 @@
+#include "visibility_map.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+VisibilityMap::VisibilityMap(BufferCache& cache, const std::string& map_file)
+    : cache(cache), map_file(map_file), page_count(0) {
+    if (!std::filesystem::exists(map_file)) {
+        std::ofstream create(map_file, std::ios::binary);
+        if (!create) {
+            throw std::runtime_error("Could not create visibility map file: " + map_file);
+        }
+    }
+    page_count = static_cast<int>(std::filesystem::file_size(map_file) / PAGE_SIZE);
+}
+
+bool VisibilityMap::all_visible(int heap_page) {
+    std::lock_guard<std::mutex> guard(mutex);
+    int map_page = heap_page / BITS_PER_PAGE;
+    if (map_page >= page_count) {
+        return false;
+    }
+    int bit = heap_page % BITS_PER_PAGE;
+    PinnedPage page(cache, map_file, map_page);
+    return (page.page()->data[bit / 8] >> (bit % 8)) & 1;
+}
+
+void VisibilityMap::set_all_visible(int heap_page) {
+    std::lock_guard<std::mutex> guard(mutex);
+    int map_page = heap_page / BITS_PER_PAGE;
+    // New map pages start with every bit clear
+    for (; page_count <= map_page; ++page_count) {
+        PinnedPage page(cache, map_file, page_count);
+        *page.page() = Page();
+        std::memset(page.page()->data, 0, sizeof(page.page()->data));
+        page.page()->dirty = true;
+    }
+    int bit = heap_page % BITS_PER_PAGE;
+    PinnedPage pinned(cache, map_file, map_page);
+    Page* page = pinned.page();
+    char mask = static_cast<char>(1 << (bit % 8));
+    if (!(page->data[bit / 8] & mask)) {
+        page->data[bit / 8] |= mask;
+        page->dirty = true;
+    }
+}
+
+void VisibilityMap::clear(int heap_page) {
+    std::lock_guard<std::mutex> guard(mutex);
+    int map_page = heap_page / BITS_PER_PAGE;
+    if (map_page >= page_count) {
+        return;
+    }
+    int bit = heap_page % BITS_PER_PAGE;
+    PinnedPage pinned(cache, map_file, map_page);
+    Page* page = pinned.page();
+    char mask = static_cast<char>(1 << (bit % 8));
+    if (page->data[bit / 8] & mask) {
+        page->data[bit / 8] &= ~mask;
+        page->dirty = true;
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef VISIBILITY_MAP_H
+#define VISIBILITY_MAP_H
+
+#include <string>
+#include <mutex>
+#include "../buffer/buffer_cache.h"
+
+// One bit per heap page of a table, set while every tuple on the page is
+// visible to every transaction. VACUUM sets bits and any change to a page
+// clears its bit, so an index-only scan can trust an index entry on a set
+// page without reading the heap. The bits live in buffer-cache pages of
+// their own file; pages past the end of the file read as all clear.
+class VisibilityMap {
+public:
+    // Creates the file if it does not exist yet
+    VisibilityMap(BufferCache& cache, const std::string& map_file);
+    bool all_visible(int heap_page);
+    void set_all_visible(int heap_page);
+    void clear(int heap_page);
+    const std::string& file() const { return map_file; }
+
+private:
+    static const int BITS_PER_PAGE = PAGE_DATA_SIZE * 8;
+
+    BufferCache& cache;
+    std::string map_file;
+    int page_count; // Map pages that exist, in the file or only in the cache
+    std::mutex mutex;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include "commit_log.h"
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+
+CommitLog::CommitLog(const std::string& file) : file_(file), chunks_(new std::atomic<PageSlot*>[MAX_CHUNKS]()) {
+    // Recover the xid counter from the highest xid that has a recorded status
+    if (!std::filesystem::exists(file_)) {
+        return;
+    }
+    int page_count = static_cast<int>(std::filesystem::file_size(file_) / PAGE_SIZE);
+    for (int page_no = page_count - 1; page_no >= 0; --page_no) {
+        ClogPage* page = get_page(page_no);
+        for (int i = PAGE_SIZE - 1; i >= 0; --i) {
+            uint8_t byte = page->bytes[i].load(std::memory_order_relaxed);
+            if (byte == 0) continue;
+            int slot = XIDS_PER_BYTE - 1;
+            while (((byte >> (slot * 2)) & 0x3) == 0) slot--;
+            next_xid_ = page_no * XIDS_PER_PAGE + i * XIDS_PER_BYTE + slot + 1;
+            return;
+        }
+    }
+}
+
+CommitLog::~CommitLog() {
+    flush();
+    for (int chunk = 0; chunk < MAX_CHUNKS; ++chunk) {
+        PageSlot* slots = chunks_[chunk].load();
+        if (!slots) continue;
+        for (int i = 0; i < CHUNK_PAGES; ++i) {
+            delete slots[i].load();
+        }
+        delete[] slots;
+    }
+}
+
+TxStatus CommitLog::get_status(int xid) {
+    if (xid == BOOTSTRAP_XID) {
+        return TxStatus::COMMITTED;
+    }
+    ClogPage* page = get_page(xid / XIDS_PER_PAGE);
+    int index = xid % XIDS_PER_PAGE;
+    uint8_t byte = page->bytes[index / XIDS_PER_BYTE].load(std::memory_order_acquire);
+    return static_cast<TxStatus>((byte >> ((index % XIDS_PER_BYTE) * 2)) & 0x3);
+}
+
+void CommitLog::set_status(int xid, TxStatus status) {
+    if (xid == BOOTSTRAP_XID) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ClogPage* page = get_page(xid / XIDS_PER_PAGE);
+    int index = xid % XIDS_PER_PAGE;
+    int shift = (index % XIDS_PER_BYTE) * 2;
+    auto& byte = page->bytes[index / XIDS_PER_BYTE];
+    uint8_t old_byte = byte.load(std::memory_order_relaxed);
+    uint8_t new_byte = static_cast<uint8_t>((old_byte & ~(0x3 << shift)) | (static_cast<uint8_t>(status) << shift));
+    byte.store(new_byte, std::memory_order_release);
+    page->dirty = true;
+    if (xid >= next_xid_) {
+        next_xid_ = xid + 1;
+    }
+}
+
+void CommitLog::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!std::filesystem::exists(file_)) {
+        std::ofstream create(file_, std::ios::binary);
+    }
+    std::fstream fs(file_, std::ios::in | std::ios::out | std::ios::binary);
+    if (!fs) {
+        throw std::runtime_error("Could not open commit log: " + file_);
+    }
+    char buffer[PAGE_SIZE];
+    for (int chunk = 0; chunk < MAX_CHUNKS; ++chunk) {
+        PageSlot* slots = chunks_[chunk].load(std::memory_order_acquire);
+        if (!slots) continue;
+        for (int i = 0; i < CHUNK_PAGES; ++i) {
+            ClogPage* page = slots[i].load(std::memory_order_acquire);
+            if (!page || !page->dirty) continue;
+            for (int j = 0; j < PAGE_SIZE; ++j) {
+                buffer[j] = static_cast<char>(page->bytes[j].load(std::memory_order_relaxed));
+            }
+            fs.seekp(static_cast<std::streamoff>(chunk * CHUNK_PAGES + i) * PAGE_SIZE);
+            fs.write(buffer, PAGE_SIZE);
+            page->dirty = false;
+        }
+    }
+    fs.flush();
+}
+
+CommitLog::PageSlot& CommitLog::page_slot(int page_no) {
+    auto& chunk = chunks_[page_no / CHUNK_PAGES];
+    PageSlot* slots = chunk.load(std::memory_order_acquire);
+    if (!slots) {
+        PageSlot* fresh = new PageSlot[CHUNK_PAGES]();
+        if (chunk.compare_exchange_strong(slots, fresh, std::memory_order_acq_rel)) {
+            slots = fresh;
+        } else {
+            delete[] fresh;
+        }
+    }
+    return slots[page_no % CHUNK_PAGES];
+}
+
+CommitLog::ClogPage* CommitLog::get_page(int page_no) {
+    if (page_no < 0) {
+        throw std::runtime_error("Transaction id out of commit log range.");
+    }
+    PageSlot& slot = page_slot(page_no);
+    ClogPage* page = slot.load(std::memory_order_acquire);
+    if (page) {
+        return page;
+    }
+    return load_page(page_no, slot);
+}
+
+CommitLog::ClogPage* CommitLog::load_page(int page_no, PageSlot& slot) {
+    // Published with a CAS so concurrent readers missing on the same page
+    // agree on a single copy without taking the mutex
+    auto page = new ClogPage();
+    char buffer[PAGE_SIZE] = {};
+    std::ifstream fs(file_, std::ios::binary);
+    if (fs) {
+        fs.seekg(static_cast<std::streamoff>(page_no) * PAGE_SIZE);
+        fs.read(buffer, PAGE_SIZE);
+    }
+    for (int i = 0; i < PAGE_SIZE; ++i) {
+        page->bytes[i].store(static_cast<uint8_t>(buffer[i]), std::memory_order_relaxed);
+    }
+
+    ClogPage* expected = nullptr;
+    if (!slot.compare_exchange_strong(expected, page, std::memory_order_acq_rel)) {
+        delete page; // Lost the race; use the page another thread published
+        return expected;
+    }
+    return page;
+}
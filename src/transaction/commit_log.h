@@ -0,0 +1,57 @@
+#ifndef COMMIT_LOG_H
+#define COMMIT_LOG_H
+
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include "../common/page.h"
+
+enum class TxStatus : uint8_t {
+    IN_PROGRESS = 0,
+    COMMITTED = 1,
+    ABORTED = 2
+};
+
+// Xid used for bootstrap/catalog writes; always treated as committed
+const int BOOTSTRAP_XID = 0;
+
+// Commit-status log: two status bits per xid, stored in PAGE_SIZE pages of a
+// file. Pages are loaded on first use and stay resident, so get_status never
+// takes a lock once a page is cached. The page directory grows in chunks as
+// xids are used, up to the whole int xid range.
+class CommitLog {
+public:
+    explicit CommitLog(const std::string& file);
+    ~CommitLog();
+
+    TxStatus get_status(int xid);
+    void set_status(int xid, TxStatus status);
+    void flush();
+    int next_xid() const { return next_xid_; } // One past the highest xid with a recorded status
+
+private:
+    static const int XIDS_PER_BYTE = 4;
+    static const int XIDS_PER_PAGE = PAGE_SIZE * XIDS_PER_BYTE;
+    static const int CHUNK_PAGES = 1024; // Directory entries allocated at a time
+    static const int MAX_CHUNKS = std::numeric_limits<int>::max() / XIDS_PER_PAGE / CHUNK_PAGES + 1;
+
+    struct ClogPage {
+        std::atomic<uint8_t> bytes[PAGE_SIZE];
+        std::atomic<bool> dirty{false};
+    };
+    using PageSlot = std::atomic<ClogPage*>;
+
+    std::string file_;
+    std::unique_ptr<std::atomic<PageSlot*>[]> chunks_; // Allocated on first use of a page range
+    std::mutex mutex_; // Serialises page loads, status writes and flushes
+    std::atomic<int> next_xid_{1};
+
+    PageSlot& page_slot(int page_no);
+    ClogPage* get_page(int page_no);
+    ClogPage* load_page(int page_no, PageSlot& slot);
+};
+
+#endif
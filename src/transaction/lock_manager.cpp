@@ -1,65 +1,296 @@
 #include "lock_manager.h"
-#include <vector>
-
-bool LockManager::lock_table(int tx_id, const std::string& table_name, LockMode mode) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    // Check if this table has any existing locks
-    if (locks_.find(table_name) == locks_.end()) {
-        // No existing lock, create new one
-        locks_[table_name] = {mode, {tx_id}};
-        return true;
-    }
-    
-    auto& lock_info = locks_[table_name];
-
-    if (lock_info.first == LockMode::EXCLUSIVE) {
-        // Exclusive lock exists
-        if (lock_info.second.size() == 1 && lock_info.second[0] == tx_id) {
-            // Same transaction already holds exclusive lock
-            return true;
+#include <iostream>
+#include <algorithm>
+
+namespace {
+// Rows/columns ordered as the LockMode enum: S, X, IS, IX, SIX
+const bool COMPATIBILITY[5][5] = {
+    /* S   */ {true,  false, true,  false, false},
+    /* X   */ {false, false, false, false, false},
+    /* IS  */ {true,  false, true,  true,  true },
+    /* IX  */ {false, false, true,  true,  false},
+    /* SIX */ {false, false, true,  false, false},
+};
+}
+
+bool LockManager::is_compatible(LockMode held, LockMode requested) {
+    return COMPATIBILITY[static_cast<int>(held)][static_cast<int>(requested)];
+}
+
+LockMode LockManager::combine(LockMode held, LockMode requested) {
+    if (held == requested) return held;
+    if (held == LockMode::EXCLUSIVE || requested == LockMode::EXCLUSIVE) return LockMode::EXCLUSIVE;
+    if (held == LockMode::INTENTION_SHARED) return requested;
+    if (requested == LockMode::INTENTION_SHARED) return held;
+    // Any remaining pair mixes S, IX and SIX, whose least upper bound is SIX
+    return LockMode::SHARED_INTENTION_EXCLUSIVE;
+}
+
+LockResult LockManager::lock_table(int tx_id, const std::string& table_name, LockMode mode) {
+    return acquire(tx_id, table_name, mode, false);
+}
+
+void LockManager::unlock_table(int tx_id, const std::string& table_name) {
+    release(tx_id, table_name);
+}
+
+LockResult LockManager::lock_transaction(int tx_id) {
+    return acquire(tx_id, transaction_resource(tx_id), LockMode::EXCLUSIVE, true);
+}
+
+void LockManager::unlock_transaction(int tx_id) {
+    release(tx_id, transaction_resource(tx_id));
+}
+
+LockResult LockManager::wait_for_transaction(int tx_id, int other_tx_id) {
+    std::string resource = transaction_resource(other_tx_id);
+    LockResult result = acquire(tx_id, resource, LockMode::SHARED, true);
+    if (result == LockResult::GRANTED) {
+        release(tx_id, resource);
+    }
+    return result;
+}
+
+void LockManager::print_stats() {
+    std::cout << "Lock Stats: FastPath=" << fast_path_grants_ << ", Waits=" << lock_waits_
+              << ", WaitTimeMs=" << wait_time_us_ / 1000 << ", Deadlocks=" << deadlocks_
+              << ", Timeouts=" << timeouts_ << std::endl;
+}
+
+LockResult LockManager::acquire(int tx_id, const std::string& resource, LockMode mode, bool transient) {
+    if (mode == LockMode::INTENTION_SHARED && try_fast_path(tx_id, resource)) {
+        fast_path_grants_++;
+        return LockResult::GRANTED;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto& slot = queues_[resource];
+    if (!slot) {
+        slot = std::make_unique<LockQueue>();
+        slot->transient = transient;
+    }
+    LockQueue& queue = *slot;
+
+    // An exclusive request must see every holder, including fast-path ones
+    if (mode == LockMode::EXCLUSIVE) {
+        migrate_fast_path(queue);
+    }
+
+    auto own = queue.granted.find(tx_id);
+    bool is_upgrade = own != queue.granted.end();
+    LockMode wanted = is_upgrade ? combine(own->second, mode) : mode;
+    if (is_upgrade && wanted == own->second) {
+        return LockResult::GRANTED;
+    }
+    if (wanted == LockMode::EXCLUSIVE) {
+        queue.strong_count++;
+    }
+
+    // New requests queue behind existing waiters; upgrades may skip ahead
+    if ((is_upgrade || queue.waiting.empty()) && can_grant(queue, tx_id, wanted)) {
+        queue.granted[tx_id] = wanted;
+        return LockResult::GRANTED;
+    }
+
+    auto request = std::make_shared<LockRequest>(LockRequest{tx_id, wanted});
+    if (is_upgrade) {
+        queue.waiting.push_front(request);
+    } else {
+        queue.waiting.push_back(request);
+    }
+    lock_waits_++;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(lock_timeout_ms_.load());
+
+    LockResult result = LockResult::GRANTED;
+    int victim = choose_deadlock_victim(tx_id);
+    if (victim == tx_id) {
+        result = LockResult::DEADLOCK;
+    } else if (victim != -1) {
+        deadlock_victims_.insert(victim);
+        for (auto& [name, other] : queues_) {
+            other->cv.notify_all();
         }
-        return false;
-    } else if (lock_info.first == LockMode::SHARED) {
-        // Shared lock exists
-        if (mode == LockMode::SHARED) {
-            for(int id : lock_info.second) {
-                if (id == tx_id) return true; // Already has shared lock
-            }
-            lock_info.second.push_back(tx_id);
-            return true;
+    }
+
+    while (result == LockResult::GRANTED && !request->granted) {
+        if (deadlock_victims_.count(tx_id)) {
+            result = LockResult::DEADLOCK;
+        } else if (queue.cv.wait_until(lock, deadline) == std::cv_status::timeout && !request->granted) {
+            result = LockResult::TIMEOUT;
         }
-        // Trying to get exclusive lock
-        if (lock_info.second.size() == 1 && lock_info.second[0] == tx_id) {
-            lock_info.first = LockMode::EXCLUSIVE;
-            return true;
+    }
+
+    auto waited = std::chrono::steady_clock::now() - start;
+    wait_time_us_ += std::chrono::duration_cast<std::chrono::microseconds>(waited).count();
+    if (result != LockResult::GRANTED) {
+        return abandon_request(tx_id, resource, request, result);
+    }
+    deadlock_victims_.erase(tx_id); // Granted before it could act on the verdict
+    return result;
+}
+
+// Called with mutex_ held exclusively after a wait fails
+LockResult LockManager::abandon_request(int tx_id, const std::string& resource, const std::shared_ptr<LockRequest>& request, LockResult reason) {
+    deadlock_victims_.erase(tx_id);
+    LockQueue& queue = *queues_[resource];
+    if (request->granted) {
+        return LockResult::GRANTED; // Granted while we were giving up; keep it
+    }
+
+    queue.waiting.remove(request);
+    auto own = queue.granted.find(tx_id);
+    bool was_exclusive = own != queue.granted.end() && own->second == LockMode::EXCLUSIVE;
+    if (request->mode == LockMode::EXCLUSIVE && !was_exclusive) {
+        queue.strong_count--;
+    }
+    if (reason == LockResult::DEADLOCK) {
+        deadlocks_++;
+    } else {
+        timeouts_++;
+    }
+
+    // Our request may have been the one blocking those behind it
+    grant_waiters(queue);
+    if (queue.transient && queue.granted.empty() && queue.waiting.empty()) {
+        queues_.erase(resource);
+    }
+    return reason;
+}
+
+void LockManager::release(int tx_id, const std::string& resource) {
+    if (release_fast_path(tx_id, resource)) {
+        return;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = queues_.find(resource);
+    if (it == queues_.end()) return;
+    LockQueue& queue = *it->second;
+
+    for (auto& slot : queue.fast_slots) {
+        int expected = tx_id;
+        slot.compare_exchange_strong(expected, -1);
+    }
+    auto own = queue.granted.find(tx_id);
+    if (own != queue.granted.end()) {
+        if (own->second == LockMode::EXCLUSIVE) {
+            queue.strong_count--;
         }
-        return false;
+        queue.granted.erase(own);
+    }
+
+    grant_waiters(queue);
+    if (queue.transient && queue.granted.empty() && queue.waiting.empty()) {
+        queues_.erase(it);
     }
+}
+
+// Uncontended IS locks only need a shared latch and one CAS on a per-object
+// slot. EXCLUSIVE is the only mode that conflicts with IS; while one is held
+// or waiting, strong_count keeps new IS requests on the slow path.
+bool LockManager::try_fast_path(int tx_id, const std::string& resource) {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = queues_.find(resource);
+    if (it == queues_.end()) return false;
+    LockQueue& queue = *it->second;
+    if (queue.strong_count > 0) return false;
 
-    // This should not happen with explicit initialization
+    for (auto& slot : queue.fast_slots) {
+        if (slot.load(std::memory_order_acquire) == tx_id) return true;
+    }
+    for (auto& slot : queue.fast_slots) {
+        int expected = -1;
+        if (slot.compare_exchange_strong(expected, tx_id)) return true;
+    }
     return false;
 }
 
-void LockManager::unlock_table(int tx_id, const std::string& table_name) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (locks_.find(table_name) == locks_.end()) return;
+// True when tx_id's lock on resource was held only through the fast path
+bool LockManager::release_fast_path(int tx_id, const std::string& resource) {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = queues_.find(resource);
+    if (it == queues_.end()) return false;
+    LockQueue& queue = *it->second;
 
-    auto& lock_info = locks_[table_name];
-    if (lock_info.first == LockMode::EXCLUSIVE) {
-        if (lock_info.second.size() == 1 && lock_info.second[0] == tx_id) {
-            locks_.erase(table_name);
+    bool released = false;
+    for (auto& slot : queue.fast_slots) {
+        int expected = tx_id;
+        if (slot.compare_exchange_strong(expected, -1)) released = true;
+    }
+    return released && queue.granted.find(tx_id) == queue.granted.end();
+}
+
+void LockManager::migrate_fast_path(LockQueue& queue) {
+    for (auto& slot : queue.fast_slots) {
+        int holder = slot.exchange(-1);
+        if (holder == -1) continue;
+        auto own = queue.granted.find(holder);
+        queue.granted[holder] = own == queue.granted.end() ? LockMode::INTENTION_SHARED : combine(own->second, LockMode::INTENTION_SHARED);
+    }
+}
+
+bool LockManager::can_grant(const LockQueue& queue, int tx_id, LockMode mode) const {
+    for (const auto& [holder_id, held_mode] : queue.granted) {
+        if (holder_id != tx_id && !is_compatible(held_mode, mode)) {
+            return false;
         }
-    } else if (lock_info.first == LockMode::SHARED) {
-        auto& tx_ids = lock_info.second;
-        for (auto it = tx_ids.begin(); it != tx_ids.end(); ++it) {
-            if (*it == tx_id) {
-                tx_ids.erase(it);
-                break;
+    }
+    return true;
+}
+
+void LockManager::grant_waiters(LockQueue& queue) {
+    while (!queue.waiting.empty()) {
+        auto& request = queue.waiting.front();
+        if (!can_grant(queue, request->tx_id, request->mode)) break;
+        queue.granted[request->tx_id] = request->mode;
+        request->granted = true;
+        queue.waiting.pop_front();
+    }
+    queue.cv.notify_all();
+}
+
+// Builds the waits-for graph from every queue: a waiter waits for each
+// incompatible holder and for each incompatible request queued ahead of it.
+// Only cycles through tx_id can be new, and the youngest member is the victim.
+int LockManager::choose_deadlock_victim(int tx_id) {
+    std::map<int, std::set<int>> graph;
+    for (const auto& [name, queue] : queues_) {
+        std::vector<const LockRequest*> ahead;
+        for (const auto& request : queue->waiting) {
+            for (const auto& [holder_id, held_mode] : queue->granted) {
+                if (holder_id != request->tx_id && !is_compatible(held_mode, request->mode)) {
+                    graph[request->tx_id].insert(holder_id);
+                }
+            }
+            for (const LockRequest* earlier : ahead) {
+                if (earlier->tx_id != request->tx_id && !is_compatible(earlier->mode, request->mode)) {
+                    graph[request->tx_id].insert(earlier->tx_id);
+                }
             }
+            ahead.push_back(request.get());
         }
-        if (tx_ids.empty()) {
-            locks_.erase(table_name);
+    }
+
+    std::vector<int> path;
+    std::set<int> visited;
+    if (!find_cycle(tx_id, tx_id, graph, path, visited)) {
+        return -1;
+    }
+    return *std::max_element(path.begin(), path.end());
+}
+
+bool LockManager::find_cycle(int start, int node, const std::map<int, std::set<int>>& graph, std::vector<int>& path, std::set<int>& visited) {
+    path.push_back(node);
+    auto edges = graph.find(node);
+    if (edges != graph.end()) {
+        for (int next : edges->second) {
+            if (next == start) return true;
+            if (visited.insert(next).second && find_cycle(start, next, graph, path, visited)) {
+                return true;
+            }
         }
     }
+    path.pop_back();
+    return false;
 }
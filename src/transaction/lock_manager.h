@@ -3,22 +3,97 @@
 
 #include <string>
 #include <unordered_map>
-#include <mutex>
+#include <map>
+#include <list>
+#include <set>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <shared_mutex>
+#include <condition_variable>
 #include <vector>
 
+// Table-level lock modes. Intention modes announce row-level work below the
+// table: IS/IX for reading/writing individual rows, SIX for a table read
+// that also writes some rows.
 enum class LockMode {
     SHARED = 0,
-    EXCLUSIVE = 1
+    EXCLUSIVE = 1,
+    INTENTION_SHARED = 2,
+    INTENTION_EXCLUSIVE = 3,
+    SHARED_INTENTION_EXCLUSIVE = 4
 };
 
+enum class LockResult {
+    GRANTED,
+    TIMEOUT,
+    DEADLOCK // Caller was chosen as the deadlock victim
+};
+
+const int DEFAULT_LOCK_TIMEOUT_MS = 5000;
+const int FAST_PATH_SLOTS = 16; // Per-object slots for uncontended IS locks
+
 class LockManager {
 public:
-    bool lock_table(int tx_id, const std::string& table_name, LockMode mode);
+    LockResult lock_table(int tx_id, const std::string& table_name, LockMode mode);
     void unlock_table(int tx_id, const std::string& table_name);
 
+    // Every transaction holds an exclusive lock on its own xid until it ends,
+    // so waiting for a transaction is a shared request on that lock and
+    // shows up in the waits-for graph like any other lock wait.
+    LockResult lock_transaction(int tx_id);
+    void unlock_transaction(int tx_id);
+    LockResult wait_for_transaction(int tx_id, int other_tx_id);
+
+    void set_lock_timeout(std::chrono::milliseconds timeout) { lock_timeout_ms_ = timeout.count(); }
+    void print_stats();
+
+    static bool is_compatible(LockMode held, LockMode requested);
+    static LockMode combine(LockMode held, LockMode requested); // Weakest mode covering both
+
 private:
-    std::mutex mutex_;
-    std::unordered_map<std::string, std::pair<LockMode, std::vector<int>>> locks_;
+    struct LockRequest {
+        int tx_id;
+        LockMode mode;
+        bool granted = false;
+    };
+
+    struct LockQueue {
+        std::map<int, LockMode> granted;                 // tx_id -> granted mode
+        std::list<std::shared_ptr<LockRequest>> waiting; // FIFO, upgrades go first
+        std::condition_variable_any cv;
+        std::atomic<int> fast_slots[FAST_PATH_SLOTS];    // tx_ids holding IS without the exclusive latch
+        int strong_count = 0;                            // Granted or waiting EXCLUSIVE requests
+        bool transient = false;                          // Transaction locks are dropped once unused
+
+        LockQueue() {
+            for (auto& slot : fast_slots) slot.store(-1, std::memory_order_relaxed);
+        }
+    };
+
+    std::shared_mutex mutex_; // Shared for the IS fast path, exclusive for everything else
+    std::unordered_map<std::string, std::unique_ptr<LockQueue>> queues_;
+    std::set<int> deadlock_victims_;
+    std::atomic<long long> lock_timeout_ms_{DEFAULT_LOCK_TIMEOUT_MS};
+
+    std::atomic<size_t> fast_path_grants_{0};
+    std::atomic<size_t> lock_waits_{0};
+    std::atomic<long long> wait_time_us_{0};
+    std::atomic<size_t> deadlocks_{0};
+    std::atomic<size_t> timeouts_{0};
+
+    LockResult acquire(int tx_id, const std::string& resource, LockMode mode, bool transient);
+    void release(int tx_id, const std::string& resource);
+    LockResult abandon_request(int tx_id, const std::string& resource, const std::shared_ptr<LockRequest>& request, LockResult reason);
+    bool try_fast_path(int tx_id, const std::string& resource);
+    bool release_fast_path(int tx_id, const std::string& resource);
+    void migrate_fast_path(LockQueue& queue);
+    bool can_grant(const LockQueue& queue, int tx_id, LockMode mode) const;
+    void grant_waiters(LockQueue& queue);
+    int choose_deadlock_victim(int tx_id); // -1 when tx_id's wait closes no cycle
+    bool find_cycle(int start, int node, const std::map<int, std::set<int>>& graph, std::vector<int>& path, std::set<int>& visited);
+
+    static std::string transaction_resource(int tx_id) { return "#" + std::to_string(tx_id); }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,25 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+// PostgreSQL-style snapshot: every xid < xmin had finished when the snapshot
+// was taken, every xid >= xmax had not started yet, and xids in between are
+// in progress only if they appear in the sorted active list.
+struct Snapshot {
+    int xmin = std::numeric_limits<int>::max();
+    int xmax = std::numeric_limits<int>::max();
+    std::vector<int> active; // Sorted ascending
+
+    // True if xid had already finished (committed or aborted) at snapshot time.
+    // A default-constructed snapshot treats every xid as finished.
+    bool is_finished(int xid) const {
+        if (xid < xmin) return true;
+        if (xid >= xmax) return false;
+        return !std::binary_search(active.begin(), active.end(), xid);
+    }
+};
+
+#endif
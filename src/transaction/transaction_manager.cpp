@@ -1,12 +1,22 @@
 #include "transaction_manager.h"
 #include "../storage/storage_engine.h"
+#include <limits>
+#include <stdexcept>
+
+TransactionManager::TransactionManager(StorageEngine* storage_engine)
+    : next_tx_id(storage_engine->commit_log().next_xid()), storage_engine_(storage_engine), commit_log_(storage_engine->commit_log()) {}
 
 int TransactionManager::start_transaction() {
     std::lock_guard<std::mutex> lock(tx_mutex_);
+    if (next_tx_id == std::numeric_limits<int>::max()) {
+        throw std::runtime_error("Transaction ids are exhausted.");
+    }
     int tx_id = next_tx_id++;
-    active_txs[tx_id] = true;
+    tx_xmins[tx_id] = active_txs.empty() ? tx_id : *active_txs.begin();
+    active_txs.insert(tx_id);
     tx_cids[tx_id] = 0;
     tx_locks_[tx_id] = {};
+    lock_manager_.lock_transaction(tx_id); // Brand-new xid, never contended
     return tx_id;
 }
 
@@ -18,13 +28,16 @@ void TransactionManager::commit(int tx_id) {
     
     storage_engine_->write_wal(tx_id, "COMMIT", "");
     storage_engine_->flush_buffer_pool();
+    commit_log_.set_status(tx_id, TxStatus::COMMITTED);
+    commit_log_.flush();
 
     for (const auto& table_name : tx_locks_[tx_id]) {
         lock_manager_.unlock_table(tx_id, table_name);
     }
     tx_locks_.erase(tx_id);
     active_txs.erase(tx_id);
-    committed_txs[tx_id] = next_tx_id;  // Approx commit seq
+    tx_xmins.erase(tx_id);
+    lock_manager_.unlock_transaction(tx_id);
 }
 
 void TransactionManager::rollback(int tx_id) {
@@ -34,29 +47,71 @@ void TransactionManager::rollback(int tx_id) {
     }
     
     storage_engine_->write_wal(tx_id, "ROLLBACK", "");
+    commit_log_.set_status(tx_id, TxStatus::ABORTED);
+    commit_log_.flush();
     for (const auto& table_name : tx_locks_[tx_id]) {
         lock_manager_.unlock_table(tx_id, table_name);
     }
     tx_locks_.erase(tx_id);
     active_txs.erase(tx_id);
+    tx_xmins.erase(tx_id);
+    lock_manager_.unlock_transaction(tx_id);
     tx_cids.erase(tx_id);
-    aborted_txs[tx_id] = true;
 }
 
 bool TransactionManager::is_committed(int tx_id) const {
+    return commit_log_.get_status(tx_id) == TxStatus::COMMITTED;
+}
+
+TxStatus TransactionManager::get_status(int tx_id) const {
+    return commit_log_.get_status(tx_id);
+}
+
+bool TransactionManager::is_active(int tx_id) const {
     std::lock_guard<std::mutex> lock(tx_mutex_);
-    return committed_txs.count(tx_id);
+    return active_txs.count(tx_id) > 0;
+}
+
+Snapshot TransactionManager::get_snapshot(int tx_id) {
+    std::lock_guard<std::mutex> lock(tx_mutex_);
+    return make_snapshot();
+}
+
+Snapshot TransactionManager::register_snapshot() {
+    std::lock_guard<std::mutex> lock(tx_mutex_);
+    Snapshot snapshot = make_snapshot();
+    snapshot_xmins.insert(snapshot.xmin);
+    return snapshot;
 }
 
-std::map<int, int> TransactionManager::get_snapshot(int tx_id) {
+void TransactionManager::release_snapshot(const Snapshot& snapshot) {
     std::lock_guard<std::mutex> lock(tx_mutex_);
-    std::map<int, int> snapshot = committed_txs;
-    for (auto& active : active_txs) {
-        snapshot[active.first] = -1;  // Mark active
+    auto it = snapshot_xmins.find(snapshot.xmin);
+    if (it != snapshot_xmins.end()) {
+        snapshot_xmins.erase(it);
     }
+}
+
+Snapshot TransactionManager::make_snapshot() const {
+    Snapshot snapshot;
+    snapshot.xmax = next_tx_id;
+    snapshot.xmin = active_txs.empty() ? snapshot.xmax : *active_txs.begin();
+    snapshot.active.assign(active_txs.begin(), active_txs.end());
     return snapshot;
 }
 
+int TransactionManager::oldest_xmin() {
+    std::lock_guard<std::mutex> lock(tx_mutex_);
+    int horizon = next_tx_id;
+    for (const auto& [tx_id, xmin] : tx_xmins) {
+        horizon = std::min(horizon, xmin);
+    }
+    if (!snapshot_xmins.empty()) {
+        horizon = std::min(horizon, *snapshot_xmins.begin());
+    }
+    return horizon;
+}
+
 int TransactionManager::get_next_cid(int tx_id) {
     std::lock_guard<std::mutex> lock(tx_mutex_);
     return tx_cids[tx_id]++;
@@ -67,12 +122,15 @@ int TransactionManager::get_current_tx_id() const {
 }
 
 bool TransactionManager::is_aborted(int tx_id) const {
-    std::lock_guard<std::mutex> lock(tx_mutex_);
-    return aborted_txs.count(tx_id);
+    return commit_log_.get_status(tx_id) == TxStatus::ABORTED;
 }
 
 bool TransactionManager::lock_table(int tx_id, const std::string& table_name, LockMode mode) {
-    if (lock_manager_.lock_table(tx_id, table_name, mode)) {
+    LockResult result = lock_manager_.lock_table(tx_id, table_name, mode);
+    if (result == LockResult::DEADLOCK) {
+        throw std::runtime_error("Deadlock detected; transaction " + std::to_string(tx_id) + " was chosen as the victim.");
+    }
+    if (result == LockResult::GRANTED) {
         std::lock_guard<std::mutex> lock(tx_mutex_);
         // Check if this table is already recorded for this transaction
         auto& tx_table_locks = tx_locks_[tx_id];
@@ -83,3 +141,13 @@ bool TransactionManager::lock_table(int tx_id, const std::string& table_name, Lo
     }
     return false;
 }
+
+void TransactionManager::wait_for_transaction(int tx_id, int other_tx_id) {
+    LockResult result = lock_manager_.wait_for_transaction(tx_id, other_tx_id);
+    if (result == LockResult::DEADLOCK) {
+        throw std::runtime_error("Deadlock detected; transaction " + std::to_string(tx_id) + " was chosen as the victim.");
+    }
+    if (result == LockResult::TIMEOUT) {
+        throw std::runtime_error("Lock wait timeout while waiting for transaction " + std::to_string(other_tx_id) + ".");
+    }
+}
@@ -2,38 +2,58 @@
 #define TRANSACTION_MANAGER_H
 
 #include <map>
+#include <set>
 #include <atomic>
 #include <vector>
 #include <mutex>
+#include <chrono>
 #include <algorithm>
 #include "lock_manager.h"
+#include "snapshot.h"
+#include "commit_log.h"
 
 class StorageEngine;
 
 class TransactionManager {
 public:
-    TransactionManager(StorageEngine* storage_engine) : storage_engine_(storage_engine) {}
+    TransactionManager(StorageEngine* storage_engine);
     int start_transaction();
     void commit(int tx_id);
     void rollback(int tx_id);
-    std::map<int, int> get_snapshot(int tx_id);  // active txs and min tx
+    Snapshot get_snapshot(int tx_id);  // O(active), independent of commit history
+    // A snapshot for a statement or transaction without an xid; its xmin
+    // holds back oldest_xmin until it is released
+    Snapshot register_snapshot();
+    void release_snapshot(const Snapshot& snapshot);
     int get_current_tx_id() const;
     int get_next_cid(int tx_id);
     bool is_aborted(int tx_id) const;
     bool is_committed(int tx_id) const;
+    TxStatus get_status(int tx_id) const;  // Lock-free commit-log lookup
+    bool is_active(int tx_id) const;  // Started by this process and not yet finished
+    // Every xid below this had finished before any active transaction or
+    // registered snapshot began, so a tuple committed below it is visible to
+    // all of them
+    int oldest_xmin();
 
     bool lock_table(int tx_id, const std::string& table_name, LockMode mode);
+    void wait_for_transaction(int tx_id, int other_tx_id);  // Blocks until other_tx_id commits or aborts
+    void set_lock_timeout(std::chrono::milliseconds timeout) { lock_manager_.set_lock_timeout(timeout); }
+    void print_lock_stats() { lock_manager_.print_stats(); }
 
 private:
     std::atomic<int> next_tx_id{1};
     mutable std::mutex tx_mutex_;  // Protects transaction state
-    std::map<int, bool> active_txs;
-    std::map<int, int> committed_txs;  // tx_id -> commit time
-    std::map<int, bool> aborted_txs;
+    std::set<int> active_txs;  // Ordered so snapshots come out sorted
     std::map<int, int> tx_cids;  // tx_id -> current cid
+    std::map<int, int> tx_xmins;  // tx_id -> oldest xid active when it began
+    std::multiset<int> snapshot_xmins;  // xmins of registered snapshots
     LockManager lock_manager_;
     std::map<int, std::vector<std::string>> tx_locks_;
     StorageEngine* storage_engine_;
+    CommitLog& commit_log_;
+
+    Snapshot make_snapshot() const;  // Called with tx_mutex_ held
 };
 
 #endif
\ No newline at end of file